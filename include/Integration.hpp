@@ -15,8 +15,20 @@
 
 #include <string>
 #include <map>
+#include <deque>
 #include <vector>
 #include <fstream>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+#include <limits>
+#include <cmath>
 
 #include <OpenCLTypes.hpp>
 #include <Kernel.hpp>
@@ -29,6 +41,15 @@
 namespace Integration
 {
 
+// Strategies of the in-place kernels; LocalMemory stages T * I * integration samples in local memory,
+// Registers accumulates each window in registers and reduces T partial sums, MultiPass stages one slice of each window per pass
+enum class integrationInPlaceVariant
+{
+    LocalMemory,
+    Registers,
+    MultiPass
+};
+
 class integrationConf : public isa::OpenCL::KernelConf
 {
   public:
@@ -36,76 +57,2864 @@ class integrationConf : public isa::OpenCL::KernelConf
     ~integrationConf();
     // Get
     bool getSubbandDedispersion() const;
+    bool getSubgroupReduction() const;
+    unsigned int getVectorWidth() const;
+    integrationInPlaceVariant getInPlaceVariant() const;
+    unsigned int getNrPasses() const;
+    bool getStatistics() const;
+    unsigned int getMaxCandidates() const;
+    // Code of the integer type, as in the configuration files
+    unsigned int getIntTypeCode() const;
     // Set
     void setSubbandDedispersion(bool subband);
+    // Reduce with sub-group functions where the kernel supports it and the device has cl_khr_subgroups
+    void setSubgroupReduction(bool subgroup);
+    // Number of contiguous elements loaded and stored at once, where the kernel and its layout allow it
+    void setVectorWidth(unsigned int width);
+    // Only used by the in-place kernels
+    void setInPlaceVariant(integrationInPlaceVariant variant);
+    // Number of slices the integration window is split in by the MultiPass variant, must divide the integration factor
+    void setNrPasses(unsigned int passes);
+    // Also write the statistics of every beam and DM, see integrationStatisticsSize; not a tuning parameter, so it is not printed
+    void setStatistics(bool emit);
+    // Also append the integrated samples above the threshold of their beam and DM to a list of at most this many candidates, zero disables it; not printed either
+    void setMaxCandidates(unsigned int candidates);
+    // Hides the one of KernelConf to also keep the code
+    void setIntType(unsigned int type);
     // utils
     std::string print() const;
 
   private:
+    unsigned int intTypeCode;
     bool subbandDedispersion;
+    bool subgroupReduction;
+    unsigned int vectorWidth;
+    integrationInPlaceVariant inPlaceVariant;
+    unsigned int nrPasses;
+    bool statistics;
+    unsigned int maxCandidates;
+};
+
+// Tuned configurations, indexed by device name, dim0 (i.e. DMs or channels) and integration factor
+class tunedIntegrationConf
+{
+  public:
+    tunedIntegrationConf();
+    ~tunedIntegrationConf();
+    // Get
+    std::size_t size() const;
+    bool empty() const;
+    // Configuration tuned for exactly these parameters, nullptr if there is none
+    const integrationConf *find(const std::string &deviceName, const unsigned int dim0, const unsigned int integration) const;
+    // Configuration tuned for the closest dim0 with this device and integration, nullptr if there is none
+    const integrationConf *findNearest(const std::string &deviceName, const unsigned int dim0, const unsigned int integration) const;
+    // Set
+    // The first configuration inserted for a set of parameters is kept
+    void insert(const std::string &deviceName, const unsigned int dim0, const unsigned int integration, const integrationConf &conf);
+    // Add the configurations of other, the ones already in this object are kept for duplicated parameters
+    void merge(const tunedIntegrationConf &other);
+    // utils
+    void clear();
+    // source identifies the data the cache is made from, readCache fails if it is not the one given to writeCache
+    void writeCache(const std::string &cacheFilename, const uint64_t source = 0) const;
+    // Replaces the content of this object, throws AstroData::FileError if the cache is invalid, truncated, or of another source
+    void readCache(const std::string &cacheFilename, const uint64_t source = 0);
+
+  private:
+    struct entry
+    {
+        uint32_t device;
+        uint32_t integration;
+        uint32_t dim0;
+        integrationConf conf;
+    };
+    // Index of deviceName in devices, devices.size() if unknown
+    uint32_t getDeviceIndex(const std::string &deviceName) const;
+    // Entries of device and integration, sorted by dim0
+    std::pair<std::vector<entry>::const_iterator, std::vector<entry>::const_iterator> getRange(const std::string &deviceName, const unsigned int integration) const;
+
+    friend void readTunedIntegrationConf(tunedIntegrationConf &tunedConf, const std::string &confFilename);
+
+    // Sorted, entries refer to devices by index
+    std::vector<std::string> devices;
+    // Sorted by device, integration, and dim0
+    std::vector<entry> entries;
+};
+
+// Type used to accumulate samples of type T, integer types are widened so that they do not wrap
+template<typename T>
+struct integrationAccumulator
+{
+    typedef T type;
+};
+template<>
+struct integrationAccumulator<uint8_t>
+{
+    typedef uint32_t type;
+};
+template<>
+struct integrationAccumulator<int8_t>
+{
+    typedef int32_t type;
+};
+template<>
+struct integrationAccumulator<uint16_t>
+{
+    typedef uint32_t type;
+};
+template<>
+struct integrationAccumulator<int16_t>
+{
+    typedef int32_t type;
+};
+
+// Types of an integration reading I and writing O, on the host and in the generated kernels
+template<typename I, typename O = I>
+struct integrationTypes
+{
+    typedef typename integrationAccumulator<I>::type accumulator;
+    // Integer outputs of a type different from the input are scaled and offset per DM
+    static constexpr bool scaled = std::is_integral<O>::value && !std::is_same<I, O>::value;
+    // Integer outputs of the input type are rounded integer divisions of the accumulator, the others multiply it by the reciprocal of the integration factor
+    typedef typename std::conditional<std::is_integral<O>::value && !scaled, accumulator, typename std::conditional<std::is_same<O, double>::value || (std::is_same<I, double>::value && std::is_floating_point<O>::value), double, float>::type>::type average;
+    // Statistics of the averages, in double precision only for double averages
+    typedef typename std::conditional<std::is_same<average, double>::value, double, float>::type statistics;
+};
+
+// Statistics of each beam and DM written by the kernels with statistics: sum, sum of squares, maximum, and index of the maximum of the integrated samples
+constexpr unsigned int integrationStatisticsSize = 4;
+
+// Sample stored as half precision by the kernels with a half output, the bits of an IEEE 754 binary16 number
+struct integrationHalf
+{
+    uint16_t bits;
+};
+
+// Integrated sample above the threshold of its beam and DM, appended by the kernels with candidates; value is the average before scaling
+struct integrationCandidate
+{
+    uint32_t beam;
+    uint32_t dm;
+    uint32_t sample;
+    float value;
+};
+
+class integrationCPUConf
+{
+  public:
+    integrationCPUConf();
+    ~integrationCPUConf();
+    // Get
+    unsigned int getNrThreads() const;
+    bool getDynamicScheduling() const;
+    unsigned int getChunkSize() const;
+    // Set
+    void setNrThreads(unsigned int threads);
+    void setDynamicScheduling(bool dynamic);
+    void setChunkSize(unsigned int chunk);
+    // utils
+    std::string print() const;
+
+  private:
+    // Zero threads means one per hardware thread
+    unsigned int nrThreads;
+    bool dynamicScheduling;
+    // Zero means an even split of the work between threads
+    unsigned int chunkSize;
+};
+
+// Pool of worker threads used by the parallel CPU implementations
+class threadPool
+{
+  public:
+    threadPool(const unsigned int nrThreads);
+    ~threadPool();
+    // Get
+    unsigned int getNrThreads() const;
+    // Execute function(first, last) over all the chunks of [0, nrItems), returns when all chunks are done
+    void parallelFor(const integrationCPUConf &conf, const unsigned int nrItems, const std::function<void(unsigned int, unsigned int)> &function);
+
+  private:
+    void worker(const unsigned int id);
+
+    std::vector<std::thread> threads;
+    std::mutex submitMutex;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable done;
+    bool stop;
+    uint64_t generation;
+    unsigned int activeWorkers;
+    std::exception_ptr error;
+    // Current work
+    const std::function<void(unsigned int, unsigned int)> *function;
+    unsigned int nrItems;
+    unsigned int chunkSize;
+    unsigned int nrChunks;
+    bool dynamicScheduling;
+    std::atomic<unsigned int> nextChunk;
+};
+
+// Compiled kernels, kept for the lifetime of the object and, if a directory is given, as program binaries on disk
+// Programs are identified by a hash of source, build options, and device; binaries are only used with the device and driver versions that built them
+class kernelCache
+{
+  public:
+    // At most maxPrograms programs are kept in memory, the least recently used one is dropped first; kernels already created stay valid
+    kernelCache(const std::string &directory = std::string(), const unsigned int maxPrograms = 128);
+    ~kernelCache();
+    // Get
+    unsigned int getNrMemoryHits() const;
+    unsigned int getNrDiskHits() const;
+    unsigned int getNrMisses() const;
+    // Same interface as isa::OpenCL::compile, the kernel is owned by the caller
+    cl::Kernel *compile(const std::string &name, const std::string &code, const std::string &flags, cl::Context &context, cl::Device &device);
+
+  private:
+    cl::Program build(const std::string &code, const std::string &flags, cl::Context &context, cl::Device &device, const std::string &deviceName, const std::string &deviceVersion, const std::string &driverVersion, const std::string &filename);
+
+    std::string directory;
+    unsigned int maxPrograms;
+    std::mutex mutex;
+    // Indexed by context, device, build options, and source, with the time of their last use
+    std::map<std::string, std::pair<cl::Program, uint64_t>> programs;
+    uint64_t nrUses;
+    unsigned int nrMemoryHits;
+    unsigned int nrDiskHits;
+    unsigned int nrMisses;
+};
+
+// Kernels generated and compiled by a pool of host threads, so that compilation overlaps with running other kernels
+class kernelCompiler
+{
+  public:
+    kernelCompiler(kernelCache &cache, const unsigned int nrThreads);
+    ~kernelCompiler();
+    // Get
+    unsigned int getNrThreads() const;
+    // Number of kernels submitted and not yet retrieved
+    unsigned int getNrPending() const;
+    bool isSubmitted(const unsigned int id) const;
+    // Generate and compile a kernel in the background
+    void submit(const unsigned int id, const std::string &name, const std::function<std::string()> &generator, const std::string &flags, cl::Context &context, cl::Device &device);
+    // Wait for a submitted kernel, compilation errors are thrown here; the kernel is owned by the caller
+    cl::Kernel *get(const unsigned int id);
+    // Wait for the running compilations and discard all kernels
+    void clear();
+
+  private:
+    struct job
+    {
+        unsigned int id;
+        std::string name;
+        std::function<std::string()> generator;
+        std::string flags;
+        cl::Context *context;
+        cl::Device *device;
+    };
+    struct result
+    {
+        cl::Kernel *kernel;
+        std::exception_ptr error;
+        bool ready;
+    };
+    void worker();
+
+    kernelCache &cache;
+    std::vector<std::thread> threads;
+    mutable std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable done;
+    bool stop;
+    unsigned int nrRunning;
+    std::deque<job> jobs;
+    std::map<unsigned int, result> results;
+};
+
+// Statistics of the run times of a kernel, in seconds
+class kernelRunTimes
+{
+  public:
+    kernelRunTimes();
+    ~kernelRunTimes();
+    // Get
+    unsigned int getNrRuns() const;
+    double getAverageTime() const;
+    double getStandardDeviation() const;
+    double getCoefficientOfVariation() const;
+    double getMinimumTime() const;
+    double getMedianTime() const;
+    // Time not exceeded by this fraction of the runs, e.g. 0.95
+    double getPercentileTime(const double fraction) const;
+    // Add the time of a run
+    void add(const double time);
+    void reset();
+
+  private:
+    std::vector<double> times;
+    // Sorted when a statistic based on order is needed
+    mutable std::vector<double> sortedTimes;
+};
+
+// Strategies to search the configuration space when tuning
+enum class searchStrategy
+{
+    Exhaustive,
+    HillClimbing,
+    SuccessiveHalving,
+    Surrogate
+};
+
+// Source code of a generated kernel, appended in order to a single buffer allocated once
+class kernelSourceBuilder
+{
+  public:
+    kernelSourceBuilder(const std::size_t capacity = 16384);
+    ~kernelSourceBuilder();
+    // Get
+    std::size_t size() const;
+    // Append text
+    kernelSourceBuilder &operator<<(const std::string &text);
+    kernelSourceBuilder &operator<<(const char *text);
+    // Append the decimal representation of an integer
+    template<typename I, typename std::enable_if<std::is_integral<I>::value, int>::type = 0>
+    kernelSourceBuilder &operator<<(const I value);
+    // Append " + offset", nothing if offset is zero
+    kernelSourceBuilder &appendOffset(const uint64_t offset);
+    // Append text, with every occurrence of placeholder replaced by value
+    kernelSourceBuilder &appendReplaced(const std::string &text, const std::string &placeholder, const uint64_t value);
+    // Move the code out of the builder
+    std::string release();
+
+  private:
+    void appendInteger(const uint64_t value);
+    void appendInteger(const int64_t value);
+
+    std::string code;
+};
+
+// Integration of a stream of DMs-samples batches, samples that do not complete an integration are carried over to the next batch
+// The host and device paths keep separate partial sums, an object should be used with only one of them
+template<typename T>
+class streamingIntegration
+{
+  public:
+    typedef typename integrationAccumulator<T>::type Accumulator;
+
+    streamingIntegration(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding);
+    ~streamingIntegration();
+    // Get
+    unsigned int getIntegration() const;
+    // Samples per DM already accumulated in the partial sums
+    unsigned int getNrPartialSamples() const;
+    // Output samples per DM produced by the next batch
+    unsigned int getNrOutputSamples() const;
+    // Output samples per DM of the largest batch output, rows of the output are padded to this size
+    unsigned int getMaxNrOutputSamples() const;
+    // Host
+    unsigned int integrate(const std::vector<T> &input, std::vector<T> &output);
+    // Device
+    void initializeDevice(cl::Context &context, const integrationConf &conf);
+    unsigned int integrate(cl::CommandQueue &queue, cl::Kernel &kernel, const cl::Buffer &input, const cl::Buffer &output, cl::Event *event = nullptr);
+    // utils
+    void reset();
+
+  private:
+    unsigned int integration;
+    unsigned int padding;
+    unsigned int nrRows;
+    unsigned int nrSamples;
+    unsigned int nrPartialSamples;
+    std::vector<Accumulator> partialSums;
+    // Device partial sums, read from one buffer and written to the other
+    cl::Buffer partialSums_d[2];
+    unsigned int currentPartialSums_d;
+    cl::NDRange global;
+    cl::NDRange local;
+};
+
+// Out-of-place integration of a sequence of batches, with depth device buffers used in turn
+// Uploads, kernels, and downloads run on three queues, so that the upload of the next batch, the integration of the current one, and the download of the previous one overlap
+// The kernel's first two arguments are set to the input and output buffers, other arguments must be set before submitting; batches complete in submission order
+template<typename T>
+class integrationPipeline
+{
+  public:
+    integrationPipeline(cl::Context &context, cl::Device &device, cl::Kernel &kernel, const cl::NDRange &global, const cl::NDRange &local, const uint64_t inputSize, const uint64_t outputSize, const unsigned int depth = 2);
+    ~integrationPipeline();
+    // Get
+    unsigned int getDepth() const;
+    // Batches submitted and not yet completed
+    unsigned int getNrInFlight() const;
+    // Enqueue a batch and return its sequence number, without waiting; input and output must not be used until the batch is completed
+    // All the buffers are in use if depth batches are in flight, a batch must be completed first; input and output must hold at least inputSize and outputSize elements
+    uint64_t submit(const std::vector<T> &input, std::vector<T> &output);
+    // Complete the oldest batch if its output is available, without waiting
+    bool poll();
+    // Wait for the oldest batch and return its sequence number
+    uint64_t complete();
+    // Wait for all the batches
+    void finish();
+
+  private:
+    cl::Kernel &kernel;
+    cl::NDRange global;
+    cl::NDRange local;
+    uint64_t inputSize;
+    uint64_t outputSize;
+    cl::CommandQueue uploadQueue;
+    cl::CommandQueue computeQueue;
+    cl::CommandQueue downloadQueue;
+    std::vector<cl::Buffer> input_d;
+    std::vector<cl::Buffer> output_d;
+    // Completion of the download of each buffer's batch
+    std::vector<cl::Event> downloaded;
+    uint64_t nrSubmitted;
+    uint64_t nrCompleted;
+};
+
+// Kernels with a launch geometry known by the library
+enum class integrationMode
+{
+    BeforeDedispersionInPlace,
+    AfterDedispersionInPlace,
+    DMsSamples,
+    SamplesDMs,
+    BeforeDedispersion
 };
 
-typedef std::map<std::string, std::map<unsigned int, std::map<unsigned int, Integration::integrationConf *> *> *> tunedIntegrationConf;
+// Integration kernel generated and compiled once, with its launch geometry and device buffers, so that running it only enqueues the kernel
+template<typename T>
+class integrationPlan
+{
+  public:
+    integrationPlan(const integrationConf &conf, const AstroData::Observation &observation, const integrationMode mode, const std::string &dataName, const unsigned int integration, const unsigned int padding);
+    integrationPlan(const integrationPlan &) = delete;
+    integrationPlan &operator=(const integrationPlan &) = delete;
+    ~integrationPlan();
+    // Get
+    integrationMode getMode() const;
+    const std::string &getName() const;
+    const cl::NDRange &getGlobal() const;
+    const cl::NDRange &getLocal() const;
+    // Elements of the padded input and output, there is no output in the in-place modes
+    uint64_t getInputSize() const;
+    uint64_t getOutputSize() const;
+    // Elements of the statistics, zero without statistics
+    uint64_t getStatisticsSize() const;
+    // Thresholds, one per beam and DM, zero without candidates; only the DMs-samples and samples-DMs modes have candidates
+    uint64_t getThresholdsSize() const;
+    cl::Buffer &getInput();
+    cl::Buffer &getOutput();
+    cl::Buffer &getStatistics();
+    cl::Buffer &getThresholds();
+    // A single uint, the number of candidates found by the last execution, possibly more than the maximum number of candidates
+    cl::Buffer &getNrCandidates();
+    // List of integrationCandidate
+    cl::Buffer &getCandidates();
+    bool isCompiled() const;
+    // Source code of the kernel
+    std::string getCode() const;
+    // Generate and compile the kernel, through cache if given
+    void compile(cl::Context &context, cl::Device &device, kernelCache *cache = nullptr, const std::string &flags = "-cl-mad-enable -Werror");
+    // Allocate the device buffers and bind them to the kernel
+    void allocate(cl::Context &context);
+    // Bind buffers allocated by the caller to the kernel, output is not used in the in-place modes and statistics only with statistics
+    void bind(const cl::Buffer &input, const cl::Buffer &output = cl::Buffer(), const cl::Buffer &statistics = cl::Buffer());
+    void bindCandidates(const cl::Buffer &thresholds, const cl::Buffer &nrCandidates, const cl::Buffer &candidates);
+    // Enqueue the kernel, after compile and allocate or bind; with candidates the number of candidates is reset first
+    void execute(cl::CommandQueue &queue, const std::vector<cl::Event> *events = nullptr, cl::Event *event = nullptr) const;
+
+  private:
+    integrationConf conf;
+    AstroData::Observation observation;
+    integrationMode mode;
+    std::string dataName;
+    unsigned int integration;
+    unsigned int padding;
+    std::string name;
+    cl::NDRange global;
+    cl::NDRange local;
+    uint64_t inputSize;
+    uint64_t outputSize;
+    uint64_t statisticsSize;
+    uint64_t thresholdsSize;
+    cl::Kernel *kernel;
+    cl::Buffer input_d;
+    cl::Buffer output_d;
+    cl::Buffer statistics_d;
+    cl::Buffer thresholds_d;
+    cl::Buffer nrCandidates_d;
+    cl::Buffer candidates_d;
+};
 
 // Sequential
 template<typename NumericType>
 void integrationBeforeDedispersion(const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<NumericType> &input, std::vector<NumericType> &output);
+// Same layout as the out-of-place kernel, the rows of the output are padded to the number of integrated samples
+template<typename NumericType>
+void integrationBeforeDedispersion(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<NumericType> &input, std::vector<NumericType> &output);
 template <typename T>
 void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output);
 template <typename T>
 void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output);
+// Store the averages as O, see integrationTypes; scales and offsets have one element per beam and DM, and are only used by scaled outputs
+template <typename T, typename O>
+void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets);
+template <typename T, typename O>
+void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets);
+// Also compute the statistics of the averages of each beam and DM, integrationStatisticsSize elements per beam and DM, as the kernels with statistics
+template <typename T, typename O>
+void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, std::vector<typename integrationTypes<T, O>::statistics> &statistics);
+template <typename T, typename O>
+void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, std::vector<typename integrationTypes<T, O>::statistics> &statistics);
+// Also append the averages above the threshold of their beam and DM to candidates, ordered by beam, DM, and sample, as the kernels with candidates without a limit
+template <typename T, typename O>
+void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, const std::vector<float> &thresholds, std::vector<integrationCandidate> &candidates);
+template <typename T, typename O>
+void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, const std::vector<float> &thresholds, std::vector<integrationCandidate> &candidates);
+// Both the statistics and the candidates, as the kernels with statistics and candidates
+template <typename T, typename O>
+void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, std::vector<typename integrationTypes<T, O>::statistics> &statistics, const std::vector<float> &thresholds, std::vector<integrationCandidate> &candidates);
+template <typename T, typename O>
+void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, std::vector<typename integrationTypes<T, O>::statistics> &statistics, const std::vector<float> &thresholds, std::vector<integrationCandidate> &candidates);
+template <typename T>
+void integrationDMsSamplesPyramid(const bool subbandDedispersion, const AstroData::Observation &observation, const std::vector<unsigned int> &integrations, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output);
+// Integrate and transpose, reading one layout and writing the other
+template <typename T>
+void integrationDMsSamplesToSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output);
+template <typename T>
+void integrationSamplesDMsToDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output);
+// Averages of widths[i] consecutive samples starting at every sample, without decimation, written at getIntegrationBoxcarOffsets()[i]
+template <typename T>
+void integrationDMsSamplesBoxcar(const bool subbandDedispersion, const AstroData::Observation &observation, const std::vector<unsigned int> &widths, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output);
+// Parallel
+template<typename NumericType>
+void integrationBeforeDedispersionParallel(threadPool &pool, const integrationCPUConf &cpuConf, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<NumericType> &input, std::vector<NumericType> &output);
+template <typename T>
+void integrationDMsSamplesParallel(threadPool &pool, const integrationCPUConf &cpuConf, const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output);
+template <typename T>
+void integrationSamplesDMsParallel(threadPool &pool, const integrationCPUConf &cpuConf, const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output);
+// Vectorized
+template<typename NumericType>
+void integrationBeforeDedispersionVectorized(const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<NumericType> &input, std::vector<NumericType> &output);
+template<>
+void integrationBeforeDedispersionVectorized<uint8_t>(const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<uint8_t> &input, std::vector<uint8_t> &output);
+template <typename T>
+void integrationSamplesDMsVectorized(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output);
+template <>
+void integrationSamplesDMsVectorized<float>(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<float> &input, std::vector<float> &output);
+// Name of the instruction set used by the vectorized CPU implementations on this machine
+std::string getVectorInstructionSet();
 // OpenCL
+// OpenCL name of the host type T
+template<typename T>
+std::string getIntegrationDataName();
+// Type used in the generated kernels to accumulate samples of type T
+template<typename T>
+std::string getIntegrationAccumulatorDataName();
+// Literal of the reciprocal of integration, in single or double precision, with enough digits to be exact
+std::string getIntegrationReciprocalOpenCL(const unsigned int integration, const bool doublePrecision);
+// OpenCL name of a scalar type, without the "signed" and "unsigned" keywords
+std::string getIntegrationScalarDataName(const std::string &dataName);
+// OpenCL vector type of width elements of type dataName, dataName itself for a width of one
+std::string getIntegrationVectorDataName(const std::string &dataName, const unsigned int width);
+// Vector width used by the kernel generated for a mode, one if the configured width does not fit the layout
+unsigned int getIntegrationVectorWidth(const integrationMode mode, const integrationConf &conf, const AstroData::Observation &observation, const unsigned int integration);
+// Vector width used by the in-place kernels with rows of dimZeroSize samples, depends on what the in-place variant loads at once
+unsigned int getIntegrationInPlaceVectorWidth(const integrationConf &conf, const unsigned int dimZeroSize, const unsigned int integration);
+// Name of the kernel generated for a mode
+std::string getIntegrationKernelName(const integrationMode mode, const unsigned int integration);
+// Global and local size of the kernel generated for a mode
+void getIntegrationNDRange(const integrationMode mode, const integrationConf &conf, const AstroData::Observation &observation, const unsigned int integration, cl::NDRange &global, cl::NDRange &local);
+// Expression averaging sum, integration samples added as integrationTypes<I, O>::accumulator, as integrationTypes<I, O>::average; integer averages are rounded to nearest
+// With a width larger than one, sum is a vector of width elements
+template<typename I, typename O = I>
+std::string getIntegrationAverageOpenCL(const std::string &sum, const unsigned int integration, const unsigned int width = 1);
+// Statements adding value to sum, a variable accumulating samples of type T, as integrationCompensatedAdd; floating point sums keep their rounding error in the variable sum + "Compensation"
+template<typename T>
+std::string getIntegrationCompensatedAddOpenCL(const std::string &sum, const std::string &value);
+// Expression with the value of a sum updated by getIntegrationCompensatedAddOpenCL
+template<typename T>
+std::string getIntegrationCompensatedSumOpenCL(const std::string &sum);
+// Statement storing average, an expression of type integrationTypes<I, O>::average, at output + index as O; scaled outputs use the scales and offsets at row
+template<typename I, typename O = I>
+std::string getIntegrationStoreOpenCL(const std::string &average, const std::string &index, const std::string &row, const unsigned int width = 1);
+// Registers with the statistics of a row, of OpenCL type statisticsName, named with suffix
+std::string getIntegrationStatisticsDeclarationOpenCL(const std::string &statisticsName, const std::string &suffix = std::string());
+// Statements adding value, a variable of the statistics type, with index sample to the statistics named with suffix
+std::string getIntegrationStatisticsUpdateOpenCL(const std::string &value, const std::string &sample, const std::string &suffix = std::string());
+// Local memory, declared at kernel scope, and statements reducing the statistics of the nrThreads work-items of a work-group in the first one
+std::string getIntegrationStatisticsLocalOpenCL(const std::string &statisticsName, const unsigned int nrThreads);
+std::string getIntegrationStatisticsReduceOpenCL(const unsigned int nrThreads);
+// Statements storing the statistics named with suffix in the elements of row of the statistics argument
+std::string getIntegrationStatisticsStoreOpenCL(const std::string &row, const std::string &suffix = std::string());
+// Kernel arguments of the kernels with candidates: the threshold of each beam and DM, the number of candidates found, and the list of integrationCandidate
+std::string getIntegrationCandidatesArgumentsOpenCL();
+// Statements appending value, the average of sample of dm in beam, to the first maxCandidates candidates if it is above the threshold of row
+std::string getIntegrationCandidateOpenCL(const std::string &value, const std::string &beam, const std::string &dm, const std::string &sample, const std::string &row, const unsigned int maxCandidates);
+template <typename T>
+std::string getIntegrationDMsSamplesOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &inputDataName, const unsigned int integration, const unsigned int padding);
+// Read T and write O, see integrationTypes; kernels with scaled outputs have two more arguments, the scales and offsets of each beam and DM, followed by the statistics and the candidates arguments if enabled
+template <typename T, typename O>
+std::string getIntegrationDMsSamplesOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &inputDataName, const std::string &outputDataName, const unsigned int integration, const unsigned int padding);
+// Every work-group reads nrThreadsD0 * nrItemsD0 + widths.back() - 1 samples once and computes all widths from them
+template <typename T>
+std::string getIntegrationDMsSamplesBoxcarOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const std::vector<unsigned int> &widths, const unsigned int padding);
+template <typename T>
+std::string getIntegrationDMsSamplesStreamOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding);
+// Integrate and transpose, each work-group integrates nrItemsD0 samples of nrItemsD1 DMs and transposes them in local memory
 template <typename T>
-std::string *getIntegrationDMsSamplesOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &inputDataName, const unsigned int integration, const unsigned int padding);
+std::string getIntegrationDMsSamplesToSamplesDMsOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding);
 template <typename T>
-std::string *getIntegrationSamplesDMsOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &inputDataName, const unsigned int integration, const unsigned int padding);
+std::string getIntegrationSamplesDMsToDMsSamplesOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding);
+template <typename T>
+std::string getIntegrationSamplesDMsOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &inputDataName, const unsigned int integration, const unsigned int padding);
+template <typename T, typename O>
+std::string getIntegrationSamplesDMsOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &inputDataName, const std::string &outputDataName, const unsigned int integration, const unsigned int padding);
+// Every work-group integrates nrItemsD0 blocks of the largest integration factor, the number of work-groups is rounded up
+template <typename T>
+std::string getIntegrationDMsSamplesPyramidOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const std::vector<unsigned int> &integrations, const unsigned int padding);
+template<typename NumericType>
+std::string getIntegrationBeforeDedispersionInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding);
+// Out-of-place version, the integrated samples of each channel are written to a separate output with rows padded to the integrated length
+template<typename NumericType>
+std::string getIntegrationBeforeDedispersionOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding);
 template<typename NumericType>
-std::string *getIntegrationBeforeDedispersionInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding);
+std::string getIntegrationAfterDedispersionInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding);
 template<typename NumericType>
-std::string *getIntegrationAfterDedispersionInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding);
+std::string getIntegrationInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int dimOneSize, const unsigned int dimZeroSize, const unsigned int integration, const unsigned int padding);
+// Registers variant of the in-place kernel, the work-group reads nrItemsD0 windows with coalesced strided loads and reduces in local memory only nrThreadsD0 partial sums per window
 template<typename NumericType>
-std::string *getIntegrationInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int dimOneSize, const unsigned int dimZeroSize, const unsigned int integration, const unsigned int padding);
-// Read configuration files
+std::string getIntegrationInPlaceRegistersOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int dimOneSize, const unsigned int dimZeroSize, const unsigned int integration, const unsigned int padding);
+// Multi-pass variant of the in-place kernel, local memory holds one of the nrPasses slices of every window of the chunk at a time
+template<typename NumericType>
+std::string getIntegrationInPlaceMultiPassOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int dimOneSize, const unsigned int dimZeroSize, const unsigned int integration, const unsigned int padding);
+// Tuning
+// Parse the name of a search strategy: exhaustive, hill_climbing, successive_halving, or surrogate
+searchStrategy getSearchStrategy(const std::string &name);
+// Search configurations, each described by the values of its tuning parameters, and return the index of the best one measured with nrIterations iterations
+// measure(configuration, iterations, nrRuns) returns the performance of a configuration, zero if it does not run, and can set nrRuns to the kernel runs it actually did
+// The budget is the number of configurations that can be measured with nrIterations iterations, zero for no limit; runs beyond the requested iterations are charged to it
+// If given, prepare(configurations) is called with the configurations that are going to be measured next, in order
+unsigned int searchConfigurations(const searchStrategy strategy, const std::vector<std::vector<unsigned int>> &parameters, const unsigned int nrIterations, const unsigned int budget, const std::function<double(const unsigned int, const unsigned int, unsigned int &)> &measure, const unsigned int seed, const std::function<void(const std::vector<unsigned int> &)> &prepare = std::function<void(const std::vector<unsigned int> &)>());
+// STREAM-like copy kernel, named "copy", used to measure the achievable memory bandwidth of a device; each work-item copies one uint4
+std::string getCopyOpenCL();
+// Read configuration files, adding their content to tunedConf; lines with parameters already in tunedConf are ignored
 void readTunedIntegrationConf(tunedIntegrationConf &tunedConf, const std::string &confFilename);
+// Same, but read the binary cache of confFilename if it was made from the same file (same size, modification time, and inode), otherwise read the text file and write the cache
+void readTunedIntegrationConf(tunedIntegrationConf &tunedConf, const std::string &confFilename, const std::string &cacheFilename);
+// Utils
+template<typename T>
+T integrationAverage(const typename integrationAccumulator<T>::type integratedSample, const unsigned int integration);
+// Average converted to O: floating point types are stored as they are, integer types as round((value - offset) / scale) with saturation
+template<typename O, typename V>
+O integrationOutput(const V value, const float scale, const float offset);
+// Average of integration samples of type I, added in integratedSample, stored as O as the kernels do, see integrationTypes
+template<typename I, typename O>
+O integrationOutputAverage(const typename integrationTypes<I, O>::accumulator integratedSample, const unsigned int integration, const float scale, const float offset);
+// Average of integration samples of type I, added in integratedSample, before it is stored as O
+template<typename I, typename O>
+typename integrationTypes<I, O>::average integrationTypedAverage(const typename integrationTypes<I, O>::accumulator integratedSample, const unsigned int integration);
+// Integrate row, beam * nrDMs + dm, of the DMs-samples or samples-DMs layout and store its averages as O; if given, visit(sample, average) is called with the average of every integrated sample
+template<typename T, typename O>
+void integrationTypedRow(const bool DMsSamples, const AstroData::Observation &observation, const unsigned int nrDMs, const unsigned int integration, const unsigned int padding, const unsigned int row, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, const std::function<void(const unsigned int, const typename integrationTypes<T, O>::average)> &visit = std::function<void(const unsigned int, const typename integrationTypes<T, O>::average)>());
+// Average consecutive groups of integration samples of one row of the before dedispersion layout; samples after the last complete group are not used
+template<typename NumericType>
+void integrationBeforeDedispersionRow(const unsigned int nrSamples, const unsigned int integration, const NumericType *inputRow, NumericType *outputRow);
+// Add value to sum, keeping the rounding error of floating point additions in compensation, so that a sliding window does not drift; integer sums are exact and do not use compensation
+template<typename A>
+void integrationCompensatedAdd(A &sum, A &compensation, const A value);
+// Add value, the integrated sample with index sample, to the statistics of row; statistics is initialized with integrationInitializeStatistics
+template<typename S>
+void integrationUpdateStatistics(std::vector<S> &statistics, const uint64_t row, const S value, const unsigned int sample);
+template<typename S>
+void integrationInitializeStatistics(std::vector<S> &statistics, const uint64_t nrRows);
+// Conversions rounding to nearest even, as vstore_half
+uint16_t integrationFloatToHalf(const float value);
+float integrationHalfToFloat(const uint16_t value);
+// Integration factors 2, 4, ..., maximum
+std::vector<unsigned int> getPowerOfTwoIntegrations(const unsigned int maximum);
+// True if the integration factors are increasing, each one divides the next, and the last one divides nrSamples
+bool isValidIntegrationPyramid(const std::vector<unsigned int> &integrations, const unsigned int nrSamples);
+// Number of valid output samples per DM of the boxcar mode, zero if width is larger than the batch
+unsigned int getNrBoxcarSamples(const AstroData::Observation &observation, const unsigned int width);
+// True if the boxcar widths are increasing, the first one is at least one, and the last one is not larger than nrSamples
+bool isValidIntegrationBoxcar(const std::vector<unsigned int> &widths, const unsigned int nrSamples);
+// Offset of each level in the output of the pyramid mode, the last element is the size of the whole output
+template <typename T>
+std::vector<uint64_t> getIntegrationPyramidOffsets(const bool subbandDedispersion, const AstroData::Observation &observation, const std::vector<unsigned int> &integrations, const unsigned int padding);
+// Offset of each width in the output of the boxcar mode, every width has rows as long as the input; the last element is the size of the whole output
+template <typename T>
+std::vector<uint64_t> getIntegrationBoxcarOffsets(const bool subbandDedispersion, const AstroData::Observation &observation, const std::vector<unsigned int> &widths, const unsigned int padding);
 
 // Implementations
-inline bool integrationConf::getSubbandDedispersion() const
+inline unsigned int kernelCompiler::getNrThreads() const
 {
-    return subbandDedispersion;
+    return threads.size();
 }
 
-inline void integrationConf::setSubbandDedispersion(bool subband)
+inline unsigned int kernelRunTimes::getNrRuns() const
 {
-    subbandDedispersion = subband;
+    return times.size();
 }
 
-template<typename NumericType>
-void integrationBeforeDedispersion(const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<NumericType> &input, std::vector<NumericType> &output)
+inline std::size_t kernelSourceBuilder::size() const
+{
+    return code.size();
+}
+
+inline kernelSourceBuilder &kernelSourceBuilder::operator<<(const std::string &text)
+{
+    code.append(text);
+    return *this;
+}
+
+inline kernelSourceBuilder &kernelSourceBuilder::operator<<(const char *text)
+{
+    code.append(text);
+    return *this;
+}
+
+template<typename I, typename std::enable_if<std::is_integral<I>::value, int>::type>
+inline kernelSourceBuilder &kernelSourceBuilder::operator<<(const I value)
+{
+    appendInteger(static_cast<typename std::conditional<std::is_signed<I>::value, int64_t, uint64_t>::type>(value));
+    return *this;
+}
+
+inline unsigned int kernelCache::getNrMemoryHits() const
+{
+    return nrMemoryHits;
+}
+
+inline unsigned int kernelCache::getNrDiskHits() const
+{
+    return nrDiskHits;
+}
+
+inline unsigned int kernelCache::getNrMisses() const
 {
-    for ( unsigned int beam = 0; beam < observation.getNrBeams(); beam++ )
+    return nrMisses;
+}
+
+inline std::size_t tunedIntegrationConf::size() const
+{
+    return entries.size();
+}
+
+inline bool tunedIntegrationConf::empty() const
+{
+    return entries.empty();
+}
+
+template<typename T>
+streamingIntegration<T>::streamingIntegration(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding) : integration(integration), padding(padding), nrPartialSamples(0), currentPartialSums_d(0)
+{
+    if (subbandDedispersion)
+    {
+        nrRows = observation.getNrSynthesizedBeams() * observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrRows = observation.getNrSynthesizedBeams() * observation.getNrDMs();
+    }
+    nrSamples = observation.getNrSamplesPerBatch() / observation.getDownsampling();
+    partialSums.resize(nrRows);
+}
+
+template<typename T>
+streamingIntegration<T>::~streamingIntegration() {}
+
+template<typename T>
+inline unsigned int streamingIntegration<T>::getIntegration() const
+{
+    return integration;
+}
+
+template<typename T>
+inline unsigned int streamingIntegration<T>::getNrPartialSamples() const
+{
+    return nrPartialSamples;
+}
+
+template<typename T>
+inline unsigned int streamingIntegration<T>::getNrOutputSamples() const
+{
+    return (nrPartialSamples + nrSamples) / integration;
+}
+
+template<typename T>
+inline unsigned int streamingIntegration<T>::getMaxNrOutputSamples() const
+{
+    return (integration - 1 + nrSamples) / integration;
+}
+
+template<typename T>
+unsigned int streamingIntegration<T>::integrate(const std::vector<T> &input, std::vector<T> &output)
+{
+    const unsigned int nrOutputSamples = getNrOutputSamples();
+    unsigned int nrIntegratedSamples = 0;
+
+    for (unsigned int row = 0; row < nrRows; row++)
     {
-        for ( unsigned int channel = 0; channel < observation.getNrChannels(); channel++ )
+        const T *inputRow = &input[row * static_cast<uint64_t>(isa::utils::pad(nrSamples, padding / sizeof(T)))];
+        T *outputRow = &output[row * static_cast<uint64_t>(isa::utils::pad(getMaxNrOutputSamples(), padding / sizeof(T)))];
+        Accumulator integratedSample = partialSums[row];
+        unsigned int outputSample = 0;
+
+        nrIntegratedSamples = nrPartialSamples;
+        for (unsigned int sample = 0; sample < nrSamples; sample++)
         {
-            for ( unsigned int sample = 0; sample < observation.getNrSamplesPerDispersedBatch(); sample += integration )
+            integratedSample += inputRow[sample];
+            nrIntegratedSamples++;
+            if (nrIntegratedSamples == integration)
             {
-                NumericType integratedSample = 0;
+                outputRow[outputSample] = integrationAverage<T>(integratedSample, integration);
+                outputSample++;
+                integratedSample = 0;
+                nrIntegratedSamples = 0;
+            }
+        }
+        partialSums[row] = integratedSample;
+    }
+    nrPartialSamples = nrIntegratedSamples;
+    return nrOutputSamples;
+}
+
+template<typename T>
+void streamingIntegration<T>::initializeDevice(cl::Context &context, const integrationConf &conf)
+{
+    // One more output than the largest batch output, the last one computes the partial sums
+    const unsigned int nrGroups = static_cast<unsigned int>(std::ceil(static_cast<float>(getMaxNrOutputSamples() + 1) / conf.getNrItemsD0()));
+
+    // The partial sums are not read when there are no partial samples, so they do not need to be initialized
+    partialSums_d[0] = cl::Buffer(context, CL_MEM_READ_WRITE, nrRows * sizeof(Accumulator), 0, 0);
+    partialSums_d[1] = cl::Buffer(context, CL_MEM_READ_WRITE, nrRows * sizeof(Accumulator), 0, 0);
+    currentPartialSums_d = 0;
+    global = cl::NDRange(conf.getNrThreadsD0() * nrGroups, nrRows);
+    local = cl::NDRange(conf.getNrThreadsD0(), 1);
+}
+
+template<typename T>
+unsigned int streamingIntegration<T>::integrate(cl::CommandQueue &queue, cl::Kernel &kernel, const cl::Buffer &input, const cl::Buffer &output, cl::Event *event)
+{
+    const unsigned int nrOutputSamples = getNrOutputSamples();
+
+    kernel.setArg(0, input);
+    kernel.setArg(1, output);
+    kernel.setArg(2, partialSums_d[currentPartialSums_d]);
+    kernel.setArg(3, partialSums_d[(currentPartialSums_d + 1) % 2]);
+    kernel.setArg(4, nrPartialSamples);
+    queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, local, nullptr, event);
+    currentPartialSums_d = (currentPartialSums_d + 1) % 2;
+    nrPartialSamples = (nrPartialSamples + nrSamples) % integration;
+    return nrOutputSamples;
+}
+
+template<typename T>
+void streamingIntegration<T>::reset()
+{
+    std::fill(partialSums.begin(), partialSums.end(), 0);
+    nrPartialSamples = 0;
+}
+
+template<typename T>
+integrationPipeline<T>::integrationPipeline(cl::Context &context, cl::Device &device, cl::Kernel &kernel, const cl::NDRange &global, const cl::NDRange &local, const uint64_t inputSize, const uint64_t outputSize, const unsigned int depth) : kernel(kernel), global(global), local(local), inputSize(inputSize), outputSize(outputSize), nrSubmitted(0), nrCompleted(0)
+{
+    uploadQueue = cl::CommandQueue(context, device);
+    computeQueue = cl::CommandQueue(context, device);
+    downloadQueue = cl::CommandQueue(context, device);
+    for (unsigned int buffer = 0; buffer < std::max(depth, 1u); buffer++)
+    {
+        input_d.push_back(cl::Buffer(context, CL_MEM_READ_ONLY, inputSize * sizeof(T), 0, 0));
+        output_d.push_back(cl::Buffer(context, CL_MEM_WRITE_ONLY, outputSize * sizeof(T), 0, 0));
+    }
+    downloaded.resize(input_d.size());
+}
+
+template<typename T>
+integrationPipeline<T>::~integrationPipeline()
+{
+    // The device may still be writing to the host memory of the batches in flight
+    try
+    {
+        finish();
+    }
+    catch (cl::Error &err)
+    {
+    }
+}
+
+template<typename T>
+inline unsigned int integrationPipeline<T>::getDepth() const
+{
+    return input_d.size();
+}
+
+template<typename T>
+inline unsigned int integrationPipeline<T>::getNrInFlight() const
+{
+    return nrSubmitted - nrCompleted;
+}
+
+template<typename T>
+uint64_t integrationPipeline<T>::submit(const std::vector<T> &input, std::vector<T> &output)
+{
+    const unsigned int buffer = nrSubmitted % input_d.size();
+    std::vector<cl::Event> uploaded(1);
+    std::vector<cl::Event> integrated(1);
+
+    if (getNrInFlight() == getDepth())
+    {
+        throw std::out_of_range("All the buffers of the pipeline are in use.");
+    }
+    if (input.size() < inputSize || output.size() < outputSize)
+    {
+        throw std::invalid_argument("The input or output of the batch is smaller than the buffers of the pipeline.");
+    }
+    uploadQueue.enqueueWriteBuffer(input_d[buffer], CL_FALSE, 0, inputSize * sizeof(T), input.data(), nullptr, &uploaded[0]);
+    kernel.setArg(0, input_d[buffer]);
+    kernel.setArg(1, output_d[buffer]);
+    computeQueue.enqueueNDRangeKernel(kernel, cl::NullRange, global, local, &uploaded, &integrated[0]);
+    downloadQueue.enqueueReadBuffer(output_d[buffer], CL_FALSE, 0, outputSize * sizeof(T), output.data(), &integrated, &downloaded[buffer]);
+    // Start the work without waiting for it
+    uploadQueue.flush();
+    computeQueue.flush();
+    downloadQueue.flush();
+    return nrSubmitted++;
+}
+
+template<typename T>
+bool integrationPipeline<T>::poll()
+{
+    if (getNrInFlight() == 0)
+    {
+        return false;
+    }
+    if (downloaded[nrCompleted % input_d.size()].getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() > CL_COMPLETE)
+    {
+        return false;
+    }
+    // Failed commands have a negative status, the error is thrown by complete
+    complete();
+    return true;
+}
+
+template<typename T>
+uint64_t integrationPipeline<T>::complete()
+{
+    if (getNrInFlight() == 0)
+    {
+        throw std::out_of_range("There are no batches in the pipeline.");
+    }
+    downloaded[nrCompleted % input_d.size()].wait();
+    return nrCompleted++;
+}
+
+template<typename T>
+void integrationPipeline<T>::finish()
+{
+    while (getNrInFlight() > 0)
+    {
+        complete();
+    }
+}
+
+template<typename T>
+integrationPlan<T>::integrationPlan(const integrationConf &conf, const AstroData::Observation &observation, const integrationMode mode, const std::string &dataName, const unsigned int integration, const unsigned int padding) : conf(conf), observation(observation), mode(mode), dataName(dataName), integration(integration), padding(padding), outputSize(0), statisticsSize(0), thresholdsSize(0), kernel(nullptr)
+{
+    const uint64_t nrRows = observation.getNrSynthesizedBeams() * static_cast<uint64_t>(observation.getNrDMs(true) * observation.getNrDMs());
+
+    name = getIntegrationKernelName(mode, integration);
+    getIntegrationNDRange(mode, conf, observation, integration, global, local);
+    switch (mode)
+    {
+        case integrationMode::BeforeDedispersionInPlace:
+            inputSize = observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion(), padding / sizeof(T));
+            statisticsSize = observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * integrationStatisticsSize;
+            break;
+        case integrationMode::AfterDedispersionInPlace:
+            inputSize = nrRows * observation.getNrSamplesPerBatch(false, padding / sizeof(T));
+            statisticsSize = nrRows * integrationStatisticsSize;
+            break;
+        case integrationMode::DMsSamples:
+            inputSize = nrRows * observation.getNrSamplesPerBatch(false, padding / sizeof(T));
+            outputSize = nrRows * isa::utils::pad(observation.getNrSamplesPerBatch() / integration, padding / sizeof(T));
+            statisticsSize = nrRows * integrationStatisticsSize;
+            break;
+        case integrationMode::SamplesDMs:
+            inputSize = observation.getNrSynthesizedBeams() * static_cast<uint64_t>(observation.getNrSamplesPerBatch()) * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(T));
+            outputSize = observation.getNrSynthesizedBeams() * static_cast<uint64_t>(observation.getNrSamplesPerBatch() / integration) * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(T));
+            statisticsSize = nrRows * integrationStatisticsSize;
+            break;
+        case integrationMode::BeforeDedispersion:
+            inputSize = observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion(), padding / sizeof(T));
+            outputSize = observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * isa::utils::pad(observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion()) / integration, padding / sizeof(T));
+            break;
+    }
+    // The out-of-place integration before dedispersion has no statistics
+    if (!conf.getStatistics() || (mode == integrationMode::BeforeDedispersion))
+    {
+        statisticsSize = 0;
+    }
+    if ((conf.getMaxCandidates() > 0) && ((mode == integrationMode::DMsSamples) || (mode == integrationMode::SamplesDMs)))
+    {
+        thresholdsSize = nrRows;
+    }
+}
+
+template<typename T>
+integrationPlan<T>::~integrationPlan()
+{
+    delete kernel;
+}
+
+template<typename T>
+inline integrationMode integrationPlan<T>::getMode() const
+{
+    return mode;
+}
+
+template<typename T>
+inline const std::string &integrationPlan<T>::getName() const
+{
+    return name;
+}
+
+template<typename T>
+inline const cl::NDRange &integrationPlan<T>::getGlobal() const
+{
+    return global;
+}
+
+template<typename T>
+inline const cl::NDRange &integrationPlan<T>::getLocal() const
+{
+    return local;
+}
+
+template<typename T>
+inline uint64_t integrationPlan<T>::getInputSize() const
+{
+    return inputSize;
+}
+
+template<typename T>
+inline uint64_t integrationPlan<T>::getOutputSize() const
+{
+    return outputSize;
+}
+
+template<typename T>
+inline uint64_t integrationPlan<T>::getStatisticsSize() const
+{
+    return statisticsSize;
+}
+
+template<typename T>
+inline uint64_t integrationPlan<T>::getThresholdsSize() const
+{
+    return thresholdsSize;
+}
+
+template<typename T>
+inline cl::Buffer &integrationPlan<T>::getInput()
+{
+    return input_d;
+}
+
+template<typename T>
+inline cl::Buffer &integrationPlan<T>::getOutput()
+{
+    return output_d;
+}
+
+template<typename T>
+inline cl::Buffer &integrationPlan<T>::getStatistics()
+{
+    return statistics_d;
+}
+
+template<typename T>
+inline cl::Buffer &integrationPlan<T>::getThresholds()
+{
+    return thresholds_d;
+}
+
+template<typename T>
+inline cl::Buffer &integrationPlan<T>::getNrCandidates()
+{
+    return nrCandidates_d;
+}
+
+template<typename T>
+inline cl::Buffer &integrationPlan<T>::getCandidates()
+{
+    return candidates_d;
+}
+
+template<typename T>
+inline bool integrationPlan<T>::isCompiled() const
+{
+    return kernel != nullptr;
+}
+
+template<typename T>
+std::string integrationPlan<T>::getCode() const
+{
+    switch (mode)
+    {
+        case integrationMode::BeforeDedispersionInPlace:
+            return getIntegrationBeforeDedispersionInPlaceOpenCL<T>(conf, observation, dataName, integration, padding);
+        case integrationMode::AfterDedispersionInPlace:
+            return getIntegrationAfterDedispersionInPlaceOpenCL<T>(conf, observation, dataName, integration, padding);
+        case integrationMode::DMsSamples:
+            return getIntegrationDMsSamplesOpenCL<T>(conf, observation, dataName, integration, padding);
+        case integrationMode::BeforeDedispersion:
+            return getIntegrationBeforeDedispersionOpenCL<T>(conf, observation, dataName, integration, padding);
+        case integrationMode::SamplesDMs:
+            break;
+    }
+    return getIntegrationSamplesDMsOpenCL<T>(conf, observation, dataName, integration, padding);
+}
+
+template<typename T>
+void integrationPlan<T>::compile(cl::Context &context, cl::Device &device, kernelCache *cache, const std::string &flags)
+{
+    const std::string code = getCode();
+    cl::Kernel *compiled = nullptr;
+
+    if (cache != nullptr)
+    {
+        compiled = cache->compile(name, code, flags, context, device);
+    }
+    else
+    {
+        compiled = isa::OpenCL::compile(name, code, flags, context, device);
+    }
+    delete kernel;
+    kernel = compiled;
+    // Buffers bound before compiling
+    if (input_d())
+    {
+        bind(input_d, output_d, statistics_d);
+    }
+}
+
+template<typename T>
+void integrationPlan<T>::allocate(cl::Context &context)
+{
+    input_d = cl::Buffer(context, CL_MEM_READ_WRITE, inputSize * sizeof(T), 0, 0);
+    if (outputSize > 0)
+    {
+        output_d = cl::Buffer(context, CL_MEM_READ_WRITE, outputSize * sizeof(T), 0, 0);
+    }
+    if (statisticsSize > 0)
+    {
+        statistics_d = cl::Buffer(context, CL_MEM_READ_WRITE, statisticsSize * sizeof(typename integrationTypes<T>::statistics), 0, 0);
+    }
+    if (thresholdsSize > 0)
+    {
+        thresholds_d = cl::Buffer(context, CL_MEM_READ_ONLY, thresholdsSize * sizeof(float), 0, 0);
+        nrCandidates_d = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(uint32_t), 0, 0);
+        candidates_d = cl::Buffer(context, CL_MEM_WRITE_ONLY, conf.getMaxCandidates() * sizeof(integrationCandidate), 0, 0);
+    }
+    bind(input_d, output_d, statistics_d);
+}
+
+template<typename T>
+void integrationPlan<T>::bind(const cl::Buffer &input, const cl::Buffer &output, const cl::Buffer &statistics)
+{
+    input_d = input;
+    output_d = output;
+    statistics_d = statistics;
+    if (kernel == nullptr)
+    {
+        return;
+    }
+    kernel->setArg(0, input_d);
+    if (outputSize > 0)
+    {
+        kernel->setArg(1, output_d);
+    }
+    // Statistics and candidates are the last arguments
+    if (statisticsSize > 0)
+    {
+        kernel->setArg(outputSize > 0 ? 2 : 1, statistics_d);
+    }
+    if ((thresholdsSize > 0) && thresholds_d())
+    {
+        const unsigned int argument = 2 + (statisticsSize > 0 ? 1 : 0);
+
+        kernel->setArg(argument, thresholds_d);
+        kernel->setArg(argument + 1, nrCandidates_d);
+        kernel->setArg(argument + 2, candidates_d);
+    }
+}
+
+template<typename T>
+void integrationPlan<T>::bindCandidates(const cl::Buffer &thresholds, const cl::Buffer &nrCandidates, const cl::Buffer &candidates)
+{
+    thresholds_d = thresholds;
+    nrCandidates_d = nrCandidates;
+    candidates_d = candidates;
+    if (input_d())
+    {
+        bind(input_d, output_d, statistics_d);
+    }
+}
+
+template<typename T>
+inline void integrationPlan<T>::execute(cl::CommandQueue &queue, const std::vector<cl::Event> *events, cl::Event *event) const
+{
+    static const uint32_t noCandidates = 0;
+
+    if (thresholdsSize > 0)
+    {
+        std::vector<cl::Event> reset(1);
+
+        // The kernel appends to the list, so every execution starts from an empty one
+        queue.enqueueWriteBuffer(nrCandidates_d, CL_FALSE, 0, sizeof(uint32_t), &noCandidates, events, &reset[0]);
+        queue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, &reset, event);
+        return;
+    }
+    queue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, events, event);
+}
+
+template <typename T>
+std::vector<uint64_t> getIntegrationPyramidOffsets(const bool subbandDedispersion, const AstroData::Observation &observation, const std::vector<unsigned int> &integrations, const unsigned int padding)
+{
+    unsigned int nrDMs = 0;
+    std::vector<uint64_t> offsets(integrations.size() + 1);
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    offsets[0] = 0;
+    for (unsigned int level = 0; level < integrations.size(); level++)
+    {
+        offsets[level + 1] = offsets[level] + (static_cast<uint64_t>(observation.getNrSynthesizedBeams()) * nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling() / integrations[level], padding / sizeof(T)));
+    }
+    return offsets;
+}
+
+template <typename T>
+std::vector<uint64_t> getIntegrationBoxcarOffsets(const bool subbandDedispersion, const AstroData::Observation &observation, const std::vector<unsigned int> &widths, const unsigned int padding)
+{
+    unsigned int nrDMs = 0;
+    std::vector<uint64_t> offsets(widths.size() + 1);
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    for (unsigned int width = 0; width <= widths.size(); width++)
+    {
+        offsets[width] = width * (static_cast<uint64_t>(observation.getNrSynthesizedBeams()) * nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling(), padding / sizeof(T)));
+    }
+    return offsets;
+}
+
+template<typename T>
+inline T integrationAverage(const typename integrationAccumulator<T>::type integratedSample, const unsigned int integration, std::false_type)
+{
+    return integratedSample * (static_cast<T>(1) / integration);
+}
+
+template<typename T>
+inline T integrationAverage(const typename integrationAccumulator<T>::type integratedSample, const unsigned int integration, std::true_type)
+{
+    typedef typename integrationAccumulator<T>::type Accumulator;
+
+    // Round to nearest, halfway cases away from zero
+    if ( integratedSample < 0 )
+    {
+        return static_cast<T>((integratedSample - static_cast<Accumulator>(integration / 2)) / static_cast<Accumulator>(integration));
+    }
+    return static_cast<T>((integratedSample + static_cast<Accumulator>(integration / 2)) / static_cast<Accumulator>(integration));
+}
+
+template<typename T>
+inline T integrationAverage(const typename integrationAccumulator<T>::type integratedSample, const unsigned int integration)
+{
+    return integrationAverage<T>(integratedSample, integration, std::is_integral<T>());
+}
+
+template<typename O, typename V>
+inline O integrationOutput(const V value, const float, const float, std::false_type)
+{
+    return static_cast<O>(value);
+}
+
+template<typename O, typename V>
+inline O integrationOutput(const V value, const float scale, const float offset, std::true_type)
+{
+    // Same operations as convert_sat_rte in the kernels, rounding to nearest even and converting NaN to zero
+    const float scaled = std::nearbyint((static_cast<float>(value) - offset) * (1.0f / scale));
+
+    if ( std::isnan(scaled) )
+    {
+        return 0;
+    }
+    else if ( scaled < static_cast<float>(std::numeric_limits<O>::min()) )
+    {
+        return std::numeric_limits<O>::min();
+    }
+    else if ( scaled > static_cast<float>(std::numeric_limits<O>::max()) )
+    {
+        return std::numeric_limits<O>::max();
+    }
+    return static_cast<O>(scaled);
+}
+
+template<typename O, typename V>
+inline O integrationOutput(const V value, const float scale, const float offset)
+{
+    return integrationOutput<O, V>(value, scale, offset, std::is_integral<O>());
+}
+
+template<>
+inline integrationHalf integrationOutput<integrationHalf, float>(const float value, const float, const float)
+{
+    return integrationHalf{integrationFloatToHalf(value)};
+}
+
+template<typename I, typename O>
+inline O integrationOutputAverage(const typename integrationTypes<I, O>::accumulator integratedSample, const unsigned int integration, const float, const float, std::true_type)
+{
+    return integrationAverage<I>(integratedSample, integration);
+}
+
+template<typename I, typename O>
+inline O integrationOutputAverage(const typename integrationTypes<I, O>::accumulator integratedSample, const unsigned int integration, const float scale, const float offset, std::false_type)
+{
+    return integrationOutput<O, typename integrationTypes<I, O>::average>(integrationTypedAverage<I, O>(integratedSample, integration), scale, offset);
+}
+
+template<typename I, typename O>
+inline O integrationOutputAverage(const typename integrationTypes<I, O>::accumulator integratedSample, const unsigned int integration, const float scale, const float offset)
+{
+    return integrationOutputAverage<I, O>(integratedSample, integration, scale, offset, std::integral_constant<bool, std::is_integral<O>::value && !integrationTypes<I, O>::scaled>());
+}
+
+template<typename I, typename O>
+inline typename integrationTypes<I, O>::average integrationTypedAverage(const typename integrationTypes<I, O>::accumulator integratedSample, const unsigned int integration)
+{
+    typedef typename integrationTypes<I, O>::average Average;
+
+    if (std::is_integral<O>::value && !integrationTypes<I, O>::scaled)
+    {
+        return integrationAverage<I>(integratedSample, integration);
+    }
+    return static_cast<Average>(integratedSample) * (static_cast<Average>(1) / integration);
+}
+
+template<typename NumericType>
+inline void integrationBeforeDedispersionRow(const unsigned int nrSamples, const unsigned int integration, const NumericType *inputRow, NumericType *outputRow)
+{
+    for ( unsigned int sample = 0; sample + integration <= nrSamples; sample += integration )
+    {
+        typename integrationAccumulator<NumericType>::type integratedSample = 0;
+
+        for ( unsigned int i = 0; i < integration; i++ )
+        {
+            integratedSample += inputRow[sample + i];
+        }
+        outputRow[sample / integration] = integrationAverage<NumericType>(integratedSample, integration);
+    }
+}
+
+template<typename A>
+inline void integrationCompensatedAdd(A &sum, A &, const A value, std::true_type)
+{
+    sum += value;
+}
+
+template<typename A>
+inline void integrationCompensatedAdd(A &sum, A &compensation, const A value, std::false_type)
+{
+    const A newSum = sum + value;
+    const A part = newSum - sum;
+
+    // Rounding error of the addition, exact for any magnitude of sum and value
+    compensation += (sum - (newSum - part)) + (value - part);
+    sum = newSum;
+}
+
+template<typename A>
+inline void integrationCompensatedAdd(A &sum, A &compensation, const A value)
+{
+    integrationCompensatedAdd<A>(sum, compensation, value, std::is_integral<A>());
+}
+
+template<typename S>
+inline void integrationUpdateStatistics(std::vector<S> &statistics, const uint64_t row, const S value, const unsigned int sample)
+{
+    S *rowStatistics = statistics.data() + (row * integrationStatisticsSize);
+
+    rowStatistics[0] += value;
+    rowStatistics[1] += value * value;
+    // The first maximum is kept, as in the kernels
+    if (value > rowStatistics[2])
+    {
+        rowStatistics[2] = value;
+        rowStatistics[3] = sample;
+    }
+}
+
+template<typename S>
+void integrationInitializeStatistics(std::vector<S> &statistics, const uint64_t nrRows)
+{
+    statistics.resize(nrRows * integrationStatisticsSize);
+    for (uint64_t row = 0; row < nrRows; row++)
+    {
+        statistics[(row * integrationStatisticsSize)] = 0;
+        statistics[(row * integrationStatisticsSize) + 1] = 0;
+        statistics[(row * integrationStatisticsSize) + 2] = -std::numeric_limits<S>::infinity();
+        statistics[(row * integrationStatisticsSize) + 3] = 0;
+    }
+}
+
+template<typename T, typename O>
+void integrationTypedRow(const bool DMsSamples, const AstroData::Observation &observation, const unsigned int nrDMs, const unsigned int integration, const unsigned int padding, const unsigned int row, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, const std::function<void(const unsigned int, const typename integrationTypes<T, O>::average)> &visit)
+{
+    const unsigned int nrSamples = DMsSamples ? observation.getNrSamplesPerBatch() / observation.getDownsampling() : observation.getNrSamplesPerBatch();
+    const float scale = integrationTypes<T, O>::scaled ? scales[row] : 1.0f;
+    const float offset = integrationTypes<T, O>::scaled ? offsets[row] : 0.0f;
+    // First sample of the row, and distance between its samples, in the input and in the output
+    uint64_t inputFirst = 0;
+    uint64_t inputStride = 1;
+    uint64_t outputFirst = 0;
+    uint64_t outputStride = 1;
+
+    if (DMsSamples)
+    {
+        inputFirst = row * static_cast<uint64_t>(isa::utils::pad(nrSamples, padding / sizeof(T)));
+        outputFirst = row * static_cast<uint64_t>(isa::utils::pad(nrSamples / integration, padding / sizeof(O)));
+    }
+    else
+    {
+        inputStride = isa::utils::pad(nrDMs, padding / sizeof(T));
+        outputStride = isa::utils::pad(nrDMs, padding / sizeof(O));
+        inputFirst = ((row / nrDMs) * static_cast<uint64_t>(nrSamples) * inputStride) + (row % nrDMs);
+        outputFirst = ((row / nrDMs) * static_cast<uint64_t>(nrSamples / integration) * outputStride) + (row % nrDMs);
+    }
+    for (unsigned int sample = 0; sample + integration <= nrSamples; sample += integration)
+    {
+        typename integrationTypes<T, O>::accumulator integratedSample = 0;
+
+        for (unsigned int i = 0; i < integration; i++)
+        {
+            integratedSample += input[inputFirst + ((sample + i) * inputStride)];
+        }
+        output[outputFirst + ((sample / integration) * outputStride)] = integrationOutputAverage<T, O>(integratedSample, integration, scale, offset);
+        if (visit)
+        {
+            visit(sample / integration, integrationTypedAverage<T, O>(integratedSample, integration));
+        }
+    }
+}
+
+template<>
+inline std::string getIntegrationDataName<int8_t>()
+{
+    return "char";
+}
+
+template<>
+inline std::string getIntegrationDataName<uint8_t>()
+{
+    return "uchar";
+}
+
+template<>
+inline std::string getIntegrationDataName<int16_t>()
+{
+    return "short";
+}
+
+template<>
+inline std::string getIntegrationDataName<uint16_t>()
+{
+    return "ushort";
+}
+
+template<>
+inline std::string getIntegrationDataName<int32_t>()
+{
+    return "int";
+}
+
+template<>
+inline std::string getIntegrationDataName<uint32_t>()
+{
+    return "uint";
+}
+
+template<>
+inline std::string getIntegrationDataName<int64_t>()
+{
+    return "long";
+}
+
+template<>
+inline std::string getIntegrationDataName<uint64_t>()
+{
+    return "ulong";
+}
+
+template<>
+inline std::string getIntegrationDataName<float>()
+{
+    return "float";
+}
+
+template<>
+inline std::string getIntegrationDataName<double>()
+{
+    return "double";
+}
+
+template<>
+inline std::string getIntegrationDataName<integrationHalf>()
+{
+    return "half";
+}
+
+template<typename T>
+inline std::string getIntegrationAccumulatorDataName()
+{
+    return getIntegrationDataName<typename integrationAccumulator<T>::type>();
+}
+
+template<typename I, typename O>
+inline std::string getIntegrationAverageOpenCL(const std::string &sum, const unsigned int integration, const unsigned int width, std::true_type)
+{
+    typedef typename integrationTypes<I, O>::accumulator Accumulator;
+    const std::string half = std::to_string(integration / 2);
+    const std::string factor = std::to_string(integration);
+    const std::string average = "convert_" + getIntegrationVectorDataName(getIntegrationDataName<O>(), width);
+
+    // Round to nearest, halfway cases away from zero, as integrationAverage
+    if ( std::is_signed<Accumulator>::value )
+    {
+        return average + "((" + sum + " < 0) ? ((" + sum + " - " + half + ") / " + factor + ") : ((" + sum + " + " + half + ") / " + factor + "))";
+    }
+    return average + "((" + sum + " + " + half + ") / " + factor + ")";
+}
+
+template<typename I, typename O>
+inline std::string getIntegrationAverageOpenCL(const std::string &sum, const unsigned int integration, const unsigned int width, std::false_type)
+{
+    typedef typename integrationTypes<I, O>::accumulator Accumulator;
+    typedef typename integrationTypes<I, O>::average Average;
+    const std::string reciprocal = getIntegrationReciprocalOpenCL(integration, std::is_same<Average, double>::value);
+
+    if ( std::is_same<Accumulator, Average>::value )
+    {
+        return "(" + sum + " * " + reciprocal + ")";
+    }
+    return "(convert_" + getIntegrationVectorDataName(getIntegrationDataName<Average>(), width) + "(" + sum + ") * " + reciprocal + ")";
+}
+
+template<typename I, typename O>
+inline std::string getIntegrationAverageOpenCL(const std::string &sum, const unsigned int integration, const unsigned int width)
+{
+    return getIntegrationAverageOpenCL<I, O>(sum, integration, width, std::integral_constant<bool, std::is_integral<O>::value && !integrationTypes<I, O>::scaled>());
+}
+
+template<typename T>
+inline std::string getIntegrationCompensatedAddOpenCL(const std::string &sum, const std::string &value)
+{
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<T>();
+
+    if ( std::is_integral<typename integrationAccumulator<T>::type>::value )
+    {
+        return sum + " += " + value + ";\n";
+    }
+    return "{\n"
+        "const " + accumulatorName + " compensatedValue = " + value + ";\n"
+        "const " + accumulatorName + " compensatedSum = " + sum + " + compensatedValue;\n"
+        "const " + accumulatorName + " compensatedPart = compensatedSum - " + sum + ";\n"
+        + sum + "Compensation += (" + sum + " - (compensatedSum - compensatedPart)) + (compensatedValue - compensatedPart);\n"
+        + sum + " = compensatedSum;\n"
+        "}\n";
+}
+
+template<typename T>
+inline std::string getIntegrationCompensatedSumOpenCL(const std::string &sum)
+{
+    if ( std::is_integral<typename integrationAccumulator<T>::type>::value )
+    {
+        return sum;
+    }
+    return "(" + sum + " + " + sum + "Compensation)";
+}
+
+template<typename I, typename O>
+inline std::string getIntegrationStoreOpenCL(const std::string &average, const std::string &index, const std::string &row, const unsigned int width)
+{
+    typedef typename integrationTypes<I, O>::average Average;
+    const std::string suffix = (width > 1) ? std::to_string(width) : "";
+    std::string value = average;
+
+    if ( std::is_same<O, integrationHalf>::value )
+    {
+        // Only storing half values, no cl_khr_fp16 needed
+        return "vstore_half" + suffix + "(" + average + ", " + ((width > 1) ? "0, output + " + index : index + ", output") + ");\n";
+    }
+    else if ( integrationTypes<I, O>::scaled )
+    {
+        if ( width > 1 )
+        {
+            value = "convert_" + getIntegrationVectorDataName(getIntegrationDataName<O>(), width) + "_sat_rte((" + average + " - vload" + suffix + "(0, offsets + " + row + ")) * (1.0f / vload" + suffix + "(0, scales + " + row + ")))";
+        }
+        else
+        {
+            value = "convert_" + getIntegrationDataName<O>() + "_sat_rte((" + average + " - offsets[" + row + "]) * (1.0f / scales[" + row + "]))";
+        }
+    }
+    else if ( !std::is_integral<O>::value && !std::is_same<O, Average>::value )
+    {
+        value = "convert_" + getIntegrationVectorDataName(getIntegrationDataName<O>(), width) + "(" + average + ")";
+    }
+    if ( width > 1 )
+    {
+        return "vstore" + suffix + "(" + value + ", 0, output + " + index + ");\n";
+    }
+    return "output[" + index + "] = " + value + ";\n";
+}
+
+inline bool integrationConf::getSubbandDedispersion() const
+{
+    return subbandDedispersion;
+}
+
+inline bool integrationConf::getSubgroupReduction() const
+{
+    return subgroupReduction;
+}
+
+inline unsigned int integrationConf::getVectorWidth() const
+{
+    return vectorWidth;
+}
+
+inline void integrationConf::setSubbandDedispersion(bool subband)
+{
+    subbandDedispersion = subband;
+}
+
+inline void integrationConf::setSubgroupReduction(bool subgroup)
+{
+    subgroupReduction = subgroup;
+}
+
+inline integrationInPlaceVariant integrationConf::getInPlaceVariant() const
+{
+    return inPlaceVariant;
+}
+
+inline unsigned int integrationConf::getNrPasses() const
+{
+    return nrPasses;
+}
+
+inline bool integrationConf::getStatistics() const
+{
+    return statistics;
+}
+
+inline unsigned int integrationConf::getMaxCandidates() const
+{
+    return maxCandidates;
+}
+
+inline void integrationConf::setVectorWidth(unsigned int width)
+{
+    vectorWidth = width;
+}
+
+inline void integrationConf::setInPlaceVariant(integrationInPlaceVariant variant)
+{
+    inPlaceVariant = variant;
+}
+
+inline void integrationConf::setNrPasses(unsigned int passes)
+{
+    nrPasses = passes;
+}
+
+inline void integrationConf::setStatistics(bool emit)
+{
+    statistics = emit;
+}
+
+inline void integrationConf::setMaxCandidates(unsigned int candidates)
+{
+    maxCandidates = candidates;
+}
+
+inline unsigned int integrationConf::getIntTypeCode() const
+{
+    return intTypeCode;
+}
+
+inline void integrationConf::setIntType(unsigned int type)
+{
+    isa::OpenCL::KernelConf::setIntType(type);
+    intTypeCode = type;
+}
+
+inline unsigned int integrationCPUConf::getNrThreads() const
+{
+    return nrThreads;
+}
+
+inline bool integrationCPUConf::getDynamicScheduling() const
+{
+    return dynamicScheduling;
+}
+
+inline unsigned int integrationCPUConf::getChunkSize() const
+{
+    return chunkSize;
+}
+
+inline void integrationCPUConf::setNrThreads(unsigned int threads)
+{
+    nrThreads = threads;
+}
+
+inline void integrationCPUConf::setDynamicScheduling(bool dynamic)
+{
+    dynamicScheduling = dynamic;
+}
+
+inline void integrationCPUConf::setChunkSize(unsigned int chunk)
+{
+    chunkSize = chunk;
+}
+
+inline unsigned int threadPool::getNrThreads() const
+{
+    return threads.size();
+}
+
+template<typename NumericType>
+void integrationBeforeDedispersion(const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<NumericType> &input, std::vector<NumericType> &output)
+{
+    integrationBeforeDedispersion(false, observation, integration, padding, input, output);
+}
+
+template<typename NumericType>
+void integrationBeforeDedispersion(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<NumericType> &input, std::vector<NumericType> &output)
+{
+    const unsigned int nrSamples = observation.getNrSamplesPerDispersedBatch(subbandDedispersion);
+    const uint64_t inputRowSize = observation.getNrSamplesPerDispersedBatch(subbandDedispersion, padding / sizeof(NumericType));
+    const uint64_t outputRowSize = isa::utils::pad(nrSamples / integration, padding / sizeof(NumericType));
+
+    for ( unsigned int row = 0; row < observation.getNrBeams() * observation.getNrChannels(); row++ )
+    {
+        integrationBeforeDedispersionRow<NumericType>(nrSamples, integration, &input[row * inputRowSize], &output[row * outputRowSize]);
+    }
+}
+
+template <typename T>
+void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+{
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+
+    for (unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++)
+    {
+        for (unsigned int dm = 0; dm < nrDMs; dm++)
+        {
+            for (unsigned int sample = 0; sample < observation.getNrSamplesPerBatch() / observation.getDownsampling(); sample += integration)
+            {
+                typename integrationAccumulator<T>::type integratedSample = 0;
+
+                for (unsigned int i = 0; i < integration; i++)
+                {
+                    integratedSample += input[(beam * nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling(), padding / sizeof(T))) + (dm * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling(), padding / sizeof(T))) + (sample + i)];
+                }
+                output[(beam * nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling() / integration, padding / sizeof(T))) + (dm * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling() / integration, padding / sizeof(T))) + (sample / integration)] = integrationAverage<T>(integratedSample, integration);
+            }
+        }
+    }
+}
+
+template <typename T>
+void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+{
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    for (unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++)
+    {
+        for (unsigned int dm = 0; dm < nrDMs; dm++)
+        {
+            for (unsigned int sample = 0; sample < observation.getNrSamplesPerBatch(); sample += integration)
+            {
+                typename integrationAccumulator<T>::type integratedSample = 0;
+
+                for (unsigned int i = 0; i < integration; i++)
+                {
+                    integratedSample += input[(beam * observation.getNrSamplesPerBatch() * isa::utils::pad(nrDMs, padding / sizeof(T))) + ((sample + i) * isa::utils::pad(nrDMs, padding / sizeof(T))) + dm];
+                }
+                output[(beam * (observation.getNrSamplesPerBatch() / integration) * isa::utils::pad(nrDMs, padding / sizeof(T))) + ((sample / integration) * isa::utils::pad(nrDMs, padding / sizeof(T))) + dm] = integrationAverage<T>(integratedSample, integration);
+            }
+        }
+    }
+}
+
+template <typename T, typename O>
+void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets)
+{
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+
+    for (unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++)
+    {
+        integrationTypedRow<T, O>(true, observation, nrDMs, integration, padding, row, input, output, scales, offsets);
+    }
+}
+
+template <typename T, typename O>
+void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets)
+{
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+
+    for (unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++)
+    {
+        integrationTypedRow<T, O>(false, observation, nrDMs, integration, padding, row, input, output, scales, offsets);
+    }
+}
+
+template <typename T, typename O>
+void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, std::vector<typename integrationTypes<T, O>::statistics> &statistics)
+{
+    typedef typename integrationTypes<T, O>::statistics Statistics;
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+
+    integrationInitializeStatistics(statistics, observation.getNrSynthesizedBeams() * static_cast<uint64_t>(nrDMs));
+    for (unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++)
+    {
+        integrationTypedRow<T, O>(true, observation, nrDMs, integration, padding, row, input, output, scales, offsets, [&statistics, row](const unsigned int sample, const typename integrationTypes<T, O>::average average)
+        {
+            integrationUpdateStatistics<Statistics>(statistics, row, average, sample);
+        });
+    }
+}
+
+template <typename T, typename O>
+void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, std::vector<typename integrationTypes<T, O>::statistics> &statistics)
+{
+    typedef typename integrationTypes<T, O>::statistics Statistics;
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+
+    integrationInitializeStatistics(statistics, observation.getNrSynthesizedBeams() * static_cast<uint64_t>(nrDMs));
+    for (unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++)
+    {
+        integrationTypedRow<T, O>(false, observation, nrDMs, integration, padding, row, input, output, scales, offsets, [&statistics, row](const unsigned int sample, const typename integrationTypes<T, O>::average average)
+        {
+            integrationUpdateStatistics<Statistics>(statistics, row, average, sample);
+        });
+    }
+}
+
+template <typename T, typename O>
+void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, const std::vector<float> &thresholds, std::vector<integrationCandidate> &candidates)
+{
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+
+    candidates.clear();
+    for (unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++)
+    {
+        integrationTypedRow<T, O>(true, observation, nrDMs, integration, padding, row, input, output, scales, offsets, [&thresholds, &candidates, nrDMs, row](const unsigned int sample, const typename integrationTypes<T, O>::average average)
+        {
+            if (average > thresholds[row])
+            {
+                candidates.push_back({row / nrDMs, row % nrDMs, sample, static_cast<float>(average)});
+            }
+        });
+    }
+}
+
+template <typename T, typename O>
+void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, const std::vector<float> &thresholds, std::vector<integrationCandidate> &candidates)
+{
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+
+    candidates.clear();
+    for (unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++)
+    {
+        integrationTypedRow<T, O>(false, observation, nrDMs, integration, padding, row, input, output, scales, offsets, [&thresholds, &candidates, nrDMs, row](const unsigned int sample, const typename integrationTypes<T, O>::average average)
+        {
+            if (average > thresholds[row])
+            {
+                candidates.push_back({row / nrDMs, row % nrDMs, sample, static_cast<float>(average)});
+            }
+        });
+    }
+}
+
+template <typename T, typename O>
+void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, std::vector<typename integrationTypes<T, O>::statistics> &statistics, const std::vector<float> &thresholds, std::vector<integrationCandidate> &candidates)
+{
+    typedef typename integrationTypes<T, O>::statistics Statistics;
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+
+    integrationInitializeStatistics(statistics, observation.getNrSynthesizedBeams() * static_cast<uint64_t>(nrDMs));
+    candidates.clear();
+    for (unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++)
+    {
+        integrationTypedRow<T, O>(true, observation, nrDMs, integration, padding, row, input, output, scales, offsets, [&statistics, &thresholds, &candidates, nrDMs, row](const unsigned int sample, const typename integrationTypes<T, O>::average average)
+        {
+            integrationUpdateStatistics<Statistics>(statistics, row, average, sample);
+            if (average > thresholds[row])
+            {
+                candidates.push_back({row / nrDMs, row % nrDMs, sample, static_cast<float>(average)});
+            }
+        });
+    }
+}
+
+template <typename T, typename O>
+void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<O> &output, const std::vector<float> &scales, const std::vector<float> &offsets, std::vector<typename integrationTypes<T, O>::statistics> &statistics, const std::vector<float> &thresholds, std::vector<integrationCandidate> &candidates)
+{
+    typedef typename integrationTypes<T, O>::statistics Statistics;
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+
+    integrationInitializeStatistics(statistics, observation.getNrSynthesizedBeams() * static_cast<uint64_t>(nrDMs));
+    candidates.clear();
+    for (unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++)
+    {
+        integrationTypedRow<T, O>(false, observation, nrDMs, integration, padding, row, input, output, scales, offsets, [&statistics, &thresholds, &candidates, nrDMs, row](const unsigned int sample, const typename integrationTypes<T, O>::average average)
+        {
+            integrationUpdateStatistics<Statistics>(statistics, row, average, sample);
+            if (average > thresholds[row])
+            {
+                candidates.push_back({row / nrDMs, row % nrDMs, sample, static_cast<float>(average)});
+            }
+        });
+    }
+}
+
+template <typename T>
+void integrationDMsSamplesToSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+{
+    typedef typename integrationAccumulator<T>::type Accumulator;
+    unsigned int nrDMs = 0;
+    const unsigned int nrSamples = observation.getNrSamplesPerBatch() / observation.getDownsampling();
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    for (unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++)
+    {
+        for (unsigned int dm = 0; dm < nrDMs; dm++)
+        {
+            for (unsigned int sample = 0; sample < nrSamples / integration; sample++)
+            {
+                Accumulator integratedSample = 0;
+
+                for (unsigned int i = 0; i < integration; i++)
+                {
+                    integratedSample += input[(beam * nrDMs * isa::utils::pad(nrSamples, padding / sizeof(T))) + (dm * isa::utils::pad(nrSamples, padding / sizeof(T))) + (sample * integration) + i];
+                }
+                output[(beam * (nrSamples / integration) * isa::utils::pad(nrDMs, padding / sizeof(T))) + (sample * isa::utils::pad(nrDMs, padding / sizeof(T))) + dm] = integrationAverage<T>(integratedSample, integration);
+            }
+        }
+    }
+}
+
+template <typename T>
+void integrationSamplesDMsToDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+{
+    typedef typename integrationAccumulator<T>::type Accumulator;
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    for (unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++)
+    {
+        for (unsigned int sample = 0; sample < observation.getNrSamplesPerBatch() / integration; sample++)
+        {
+            for (unsigned int dm = 0; dm < nrDMs; dm++)
+            {
+                Accumulator integratedSample = 0;
+
+                for (unsigned int i = 0; i < integration; i++)
+                {
+                    integratedSample += input[(beam * observation.getNrSamplesPerBatch() * isa::utils::pad(nrDMs, padding / sizeof(T))) + (((sample * integration) + i) * isa::utils::pad(nrDMs, padding / sizeof(T))) + dm];
+                }
+                output[(beam * nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / integration, padding / sizeof(T))) + (dm * isa::utils::pad(observation.getNrSamplesPerBatch() / integration, padding / sizeof(T))) + sample] = integrationAverage<T>(integratedSample, integration);
+            }
+        }
+    }
+}
+
+template <typename T>
+void integrationDMsSamplesBoxcar(const bool subbandDedispersion, const AstroData::Observation &observation, const std::vector<unsigned int> &widths, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+{
+    typedef typename integrationAccumulator<T>::type Accumulator;
+    unsigned int nrDMs = 0;
+    const unsigned int nrSamples = observation.getNrSamplesPerBatch() / observation.getDownsampling();
+    const std::vector<uint64_t> offsets = getIntegrationBoxcarOffsets<T>(subbandDedispersion, observation, widths, padding);
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    for (unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++)
+    {
+        for (unsigned int dm = 0; dm < nrDMs; dm++)
+        {
+            const uint64_t row = ((beam * static_cast<uint64_t>(nrDMs)) + dm) * isa::utils::pad(nrSamples, padding / sizeof(T));
+            const T *inputRow = &input[row];
+            std::vector<Accumulator> sums(widths.size(), 0);
+            std::vector<Accumulator> compensations(widths.size(), 0);
+            Accumulator integratedSample = 0;
+            Accumulator compensation = 0;
+            unsigned int item = 0;
+
+            // First window of every width, each width adds the samples after the previous one
+            for (unsigned int width = 0; width < widths.size(); width++)
+            {
+                for ( ; item < std::min(widths[width], nrSamples); item++)
+                {
+                    integrationCompensatedAdd<Accumulator>(integratedSample, compensation, inputRow[item]);
+                }
+                sums[width] = integratedSample;
+                compensations[width] = compensation;
+            }
+            // Running windows, the cost per sample does not depend on the width
+            for (unsigned int sample = 0; sample < getNrBoxcarSamples(observation, widths.front()); sample++)
+            {
+                for (unsigned int width = 0; (width < widths.size()) && (sample + widths[width] <= nrSamples); width++)
+                {
+                    output[offsets[width] + row + sample] = integrationAverage<T>(sums[width] + compensations[width], widths[width]);
+                    if (sample + widths[width] < nrSamples)
+                    {
+                        integrationCompensatedAdd<Accumulator>(sums[width], compensations[width], inputRow[sample + widths[width]]);
+                        integrationCompensatedAdd<Accumulator>(sums[width], compensations[width], -static_cast<Accumulator>(inputRow[sample]));
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void integrationDMsSamplesPyramid(const bool subbandDedispersion, const AstroData::Observation &observation, const std::vector<unsigned int> &integrations, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+{
+    typedef typename integrationAccumulator<T>::type Accumulator;
+    unsigned int nrDMs = 0;
+    const unsigned int nrSamples = observation.getNrSamplesPerBatch() / observation.getDownsampling();
+    const std::vector<uint64_t> offsets = getIntegrationPyramidOffsets<T>(subbandDedispersion, observation, integrations, padding);
+    std::vector<Accumulator> sums(nrSamples / integrations.front());
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    for (unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++)
+    {
+        for (unsigned int dm = 0; dm < nrDMs; dm++)
+        {
+            const T *inputRow = &input[((beam * static_cast<uint64_t>(nrDMs)) + dm) * isa::utils::pad(nrSamples, padding / sizeof(T))];
+
+            // The first level is the only one reading the input, every other level adds the sums of the previous one
+            for (unsigned int level = 0; level < integrations.size(); level++)
+            {
+                const unsigned int nrOutputSamples = nrSamples / integrations[level];
+                T *outputRow = &output[offsets[level] + (((beam * static_cast<uint64_t>(nrDMs)) + dm) * isa::utils::pad(nrOutputSamples, padding / sizeof(T)))];
+
+                for (unsigned int sample = 0; sample < nrOutputSamples; sample++)
+                {
+                    Accumulator integratedSample = 0;
+
+                    if (level == 0)
+                    {
+                        for (unsigned int i = 0; i < integrations[level]; i++)
+                        {
+                            integratedSample += inputRow[(sample * integrations[level]) + i];
+                        }
+                    }
+                    else
+                    {
+                        const unsigned int ratio = integrations[level] / integrations[level - 1];
+
+                        for (unsigned int i = 0; i < ratio; i++)
+                        {
+                            integratedSample += sums[(sample * ratio) + i];
+                        }
+                    }
+                    // In place is safe, the sums of sample are never read again after this point
+                    sums[sample] = integratedSample;
+                    outputRow[sample] = integrationAverage<T>(integratedSample, integrations[level]);
+                }
+            }
+        }
+    }
+}
+
+template<typename NumericType>
+void integrationBeforeDedispersionParallel(threadPool &pool, const integrationCPUConf &cpuConf, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<NumericType> &input, std::vector<NumericType> &output)
+{
+    const unsigned int inputRowSize = observation.getNrSamplesPerDispersedBatch(false, padding / sizeof(NumericType));
+    const unsigned int outputRowSize = isa::utils::pad(observation.getNrSamplesPerDispersedBatch() / integration, padding / sizeof(NumericType));
+
+    // Each item is a (beam, channel) row
+    pool.parallelFor(cpuConf, observation.getNrBeams() * observation.getNrChannels(), [&](unsigned int firstRow, unsigned int lastRow)
+    {
+        for ( unsigned int row = firstRow; row < lastRow; row++ )
+        {
+            integrationBeforeDedispersionRow<NumericType>(observation.getNrSamplesPerDispersedBatch(), integration, &input[row * static_cast<uint64_t>(inputRowSize)], &output[row * static_cast<uint64_t>(outputRowSize)]);
+        }
+    });
+}
+
+template <typename T>
+void integrationDMsSamplesParallel(threadPool &pool, const integrationCPUConf &cpuConf, const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+{
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    const unsigned int nrSamples = observation.getNrSamplesPerBatch() / observation.getDownsampling();
+    const unsigned int inputRowSize = isa::utils::pad(nrSamples, padding / sizeof(T));
+    const unsigned int outputRowSize = isa::utils::pad(nrSamples / integration, padding / sizeof(T));
+
+    // Each item is a (beam, DM) row
+    pool.parallelFor(cpuConf, observation.getNrSynthesizedBeams() * nrDMs, [&](unsigned int firstRow, unsigned int lastRow)
+    {
+        for (unsigned int row = firstRow; row < lastRow; row++)
+        {
+            const T *inputRow = &input[row * static_cast<uint64_t>(inputRowSize)];
+            T *outputRow = &output[row * static_cast<uint64_t>(outputRowSize)];
+
+            for (unsigned int sample = 0; sample + integration <= nrSamples; sample += integration)
+            {
+                typename integrationAccumulator<T>::type integratedSample = 0;
+
+                for (unsigned int i = 0; i < integration; i++)
+                {
+                    integratedSample += inputRow[sample + i];
+                }
+                outputRow[sample / integration] = integrationAverage<T>(integratedSample, integration);
+            }
+        }
+    });
+}
+
+template <typename T>
+void integrationSamplesDMsParallel(threadPool &pool, const integrationCPUConf &cpuConf, const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+{
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    const unsigned int nrSamples = observation.getNrSamplesPerBatch();
+    const unsigned int rowSize = isa::utils::pad(nrDMs, padding / sizeof(T));
+
+    // Each item is a (beam, DM) pair, items of the same beam are contiguous
+    pool.parallelFor(cpuConf, observation.getNrSynthesizedBeams() * nrDMs, [&](unsigned int firstItem, unsigned int lastItem)
+    {
+        for (unsigned int item = firstItem; item < lastItem; item++)
+        {
+            const unsigned int beam = item / nrDMs;
+            const unsigned int dm = item % nrDMs;
+            const T *inputBeam = &input[beam * static_cast<uint64_t>(nrSamples) * rowSize];
+            T *outputBeam = &output[beam * static_cast<uint64_t>(nrSamples / integration) * rowSize];
+
+            for (unsigned int sample = 0; sample + integration <= nrSamples; sample += integration)
+            {
+                typename integrationAccumulator<T>::type integratedSample = 0;
+
+                for (unsigned int i = 0; i < integration; i++)
+                {
+                    integratedSample += inputBeam[((sample + i) * static_cast<uint64_t>(rowSize)) + dm];
+                }
+                outputBeam[((sample / integration) * static_cast<uint64_t>(rowSize)) + dm] = integrationAverage<T>(integratedSample, integration);
+            }
+        }
+    });
+}
+
+template<typename NumericType>
+void integrationBeforeDedispersionVectorized(const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<NumericType> &input, std::vector<NumericType> &output)
+{
+    const unsigned int inputRowSize = observation.getNrSamplesPerDispersedBatch(false, padding / sizeof(NumericType));
+    const unsigned int outputRowSize = isa::utils::pad(observation.getNrSamplesPerDispersedBatch() / integration, padding / sizeof(NumericType));
+
+    for ( unsigned int row = 0; row < observation.getNrBeams() * observation.getNrChannels(); row++ )
+    {
+        integrationBeforeDedispersionRow<NumericType>(observation.getNrSamplesPerDispersedBatch(), integration, &input[row * static_cast<uint64_t>(inputRowSize)], &output[row * static_cast<uint64_t>(outputRowSize)]);
+    }
+}
+
+template <typename T>
+void integrationSamplesDMsVectorized(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+{
+    // Number of DMs accumulated at the same time, the accumulators are kept in L1
+    const unsigned int dmTile = 1024;
+    unsigned int nrDMs = 0;
+
+    if (subbandDedispersion)
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    const unsigned int rowSize = isa::utils::pad(nrDMs, padding / sizeof(T));
+    typename integrationAccumulator<T>::type integratedSamples[dmTile];
+
+    for (unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++)
+    {
+        for (unsigned int sample = 0; sample + integration <= observation.getNrSamplesPerBatch(); sample += integration)
+        {
+            for (unsigned int firstDM = 0; firstDM < nrDMs; firstDM += dmTile)
+            {
+                const unsigned int tile = std::min(dmTile, nrDMs - firstDM);
+
+                std::fill(integratedSamples, integratedSamples + tile, 0);
+                for (unsigned int i = 0; i < integration; i++)
+                {
+                    const T *inputRow = &input[(beam * static_cast<uint64_t>(observation.getNrSamplesPerBatch()) * rowSize) + ((sample + i) * static_cast<uint64_t>(rowSize)) + firstDM];
+
+                    for (unsigned int dm = 0; dm < tile; dm++)
+                    {
+                        integratedSamples[dm] += inputRow[dm];
+                    }
+                }
+                T *outputRow = &output[(beam * static_cast<uint64_t>(observation.getNrSamplesPerBatch() / integration) * rowSize) + ((sample / integration) * static_cast<uint64_t>(rowSize)) + firstDM];
+
+                for (unsigned int dm = 0; dm < tile; dm++)
+                {
+                    outputRow[dm] = integrationAverage<T>(integratedSamples[dm], integration);
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+std::string getIntegrationDMsSamplesOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
+{
+    return getIntegrationDMsSamplesOpenCL<T, T>(conf, observation, dataName, dataName, integration, padding);
+}
+
+template <typename T, typename O>
+std::string getIntegrationDMsSamplesOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const std::string &outputDataName, const unsigned int integration, const unsigned int padding)
+{
+    typedef typename integrationTypes<T, O>::accumulator Accumulator;
+    unsigned int nrDMs = 0;
+    // sub_group_reduce_add is only defined for 32 and 64 bits types
+    const bool subgroupReduction = conf.getSubgroupReduction() && sizeof(Accumulator) >= 4;
+    const unsigned int vectorWidth = getIntegrationVectorWidth(integrationMode::DMsSamples, conf, observation, integration);
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<T>();
+    const std::string vectorName = getIntegrationVectorDataName(accumulatorName, vectorWidth);
+    const std::string statisticsName = getIntegrationDataName<typename integrationTypes<T, O>::statistics>();
+    // Type of the expressions of getIntegrationAverageOpenCL, integer averages of the input type are already converted to O
+    const std::string averageName = (std::is_integral<O>::value && !integrationTypes<T, O>::scaled) ? getIntegrationDataName<O>() : getIntegrationDataName<typename integrationTypes<T, O>::average>();
+    // With statistics every work-group integrates all the chunks of its DM
+    const std::string chunk = conf.getStatistics() ? "chunk" : "get_group_id(0)";
+    kernelSourceBuilder code;
+
+    if (conf.getSubbandDedispersion())
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    // Begin kernel's template
+    if (subgroupReduction)
+    {
+        code << "#if defined(cl_khr_subgroups)\n"
+        "#pragma OPENCL EXTENSION cl_khr_subgroups : enable\n"
+        "#define INTEGRATION_SUBGROUPS\n"
+        "#elif defined(__opencl_c_subgroups)\n"
+        "#define INTEGRATION_SUBGROUPS\n"
+        "#endif\n";
+    }
+    code << "__kernel void integrationDMsSamples" << integration << "(__global const " << dataName << " * const restrict input, __global " << outputDataName << " * const restrict output";
+    if (integrationTypes<T, O>::scaled)
+    {
+        code << ", __global const float * const restrict scales, __global const float * const restrict offsets";
+    }
+    if (conf.getStatistics())
+    {
+        code << ", __global " << statisticsName << " * const restrict statistics";
+    }
+    if (conf.getMaxCandidates() > 0)
+    {
+        code << getIntegrationCandidatesArgumentsOpenCL();
+    }
+    code << ") {\n"
+    << conf.getIntType() << " beam = get_group_id(2);\n"
+    << conf.getIntType() << " dm = get_group_id(1);\n"
+    "__local " << accumulatorName << " buffer[" << conf.getNrThreadsD0() * conf.getNrItemsD0() << "];\n";
+    if (conf.getStatistics())
+    {
+        code << getIntegrationStatisticsLocalOpenCL(statisticsName, conf.getNrThreadsD0()) << getIntegrationStatisticsDeclarationOpenCL(statisticsName) <<
+        "for ( " << conf.getIntType() << " chunk = 0; chunk < " << (observation.getNrSamplesPerBatch() / observation.getDownsampling() / integration) / conf.getNrItemsD0() << "; chunk++ ) {\n";
+    }
+    code << conf.getIntType() << " inGlobalMemory = (beam * " << nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling(), padding / sizeof(T)) << ") + (dm * " << isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling(), padding / sizeof(T)) << ") + (" << chunk << " * " << integration * conf.getNrItemsD0() << ");\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        code << accumulatorName << " integratedSample" << sample << " = 0;\n";
+    }
+    if (vectorWidth > 1)
+    {
+        // Every work-item loads vectorWidth contiguous samples at once, and adds their elements at the end
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+        {
+            code << vectorName << " integratedVector" << sample << " = 0;\n";
+        }
+        code << "\n"
+        "// First computing phase\n"
+        "for ( " << conf.getIntType() << " sample = get_local_id(0) * " << vectorWidth << "; sample < " << integration << "; sample += " << conf.getNrThreadsD0() * vectorWidth << " ) {\n";
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+        {
+            code << "integratedVector" << sample << " += ";
+            if (!std::is_same<T, Accumulator>::value)
+            {
+                code << "convert_" << vectorName;
+            }
+            code << "(vload" << vectorWidth << "(0, input + inGlobalMemory + sample";
+            code.appendOffset(sample * integration) << "));\n";
+        }
+        code << "}\n";
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+        {
+            code << "integratedSample" << sample << " = integratedVector" << sample << ".s0";
+            for (unsigned int item = 1; item < vectorWidth; item++)
+            {
+                code << " + integratedVector" << sample << ".s" << std::string(1, "0123456789abcdef"[item]);
+            }
+            code << ";\n";
+        }
+    }
+    else
+    {
+        code << "\n"
+        "// First computing phase\n"
+        "for ( " << conf.getIntType() << " sample = get_local_id(0); sample < " << integration << "; sample += " << conf.getNrThreadsD0() << " ) {\n";
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+        {
+            code << "integratedSample" << sample << " += input[inGlobalMemory + sample";
+            code.appendOffset(sample * integration) << "];\n";
+        }
+        code << "}\n";
+    }
+    if (subgroupReduction)
+    {
+        // The partial sums of the sub-groups are added by the first nrItemsD0 work-items, each sample has nrThreadsD0 elements of the buffer
+        code << "#ifdef INTEGRATION_SUBGROUPS\n"
+        "// Reduce\n";
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+        {
+            code << "integratedSample" << sample << " = sub_group_reduce_add(integratedSample" << sample << ");\n";
+        }
+        code << "if ( get_sub_group_local_id() == 0 ) {\n";
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+        {
+            code << "buffer[get_sub_group_id()";
+            code.appendOffset(sample * conf.getNrThreadsD0()) << "] = integratedSample" << sample << ";\n";
+        }
+        code << "}\n"
+        "barrier(CLK_LOCAL_MEM_FENCE);\n"
+        "if ( get_local_id(0) < " << conf.getNrItemsD0() << " ) {\n"
+        << accumulatorName << " integratedSample = 0;\n"
+        "for ( uint subgroup = 0; subgroup < get_num_sub_groups(); subgroup++ ) {\n"
+        "integratedSample += buffer[(get_local_id(0) * " << conf.getNrThreadsD0() << ") + subgroup];\n"
+        "}\n"
+        "buffer[get_local_id(0) * " << conf.getNrThreadsD0() << "] = integratedSample;\n"
+        "}\n"
+        "#else\n";
+    }
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        code << "buffer[get_local_id(0)";
+        code.appendOffset(sample * conf.getNrThreadsD0()) << "] = integratedSample" << sample << ";\n";
+    }
+    code << "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "// Reduce\n"
+    << conf.getIntType() << " threshold = " << conf.getNrThreadsD0() / 2 << ";\n"
+    "for ( " << conf.getIntType() << " sample = get_local_id(0); threshold > 0; threshold /= 2 ) {\n"
+    "if ( sample < threshold ) {\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        code << "integratedSample" << sample << " += buffer[(sample";
+        code.appendOffset(sample * conf.getNrThreadsD0()) << ") + threshold];\n"
+        "buffer[sample";
+        code.appendOffset(sample * conf.getNrThreadsD0()) << "] = integratedSample" << sample << ";\n";
+    }
+    code << "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "}\n";
+    if (subgroupReduction)
+    {
+        code << "#endif\n";
+    }
+    code << "inGlobalMemory = (beam * " << nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling() / integration, padding / sizeof(O)) << ") + (dm * " << isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling() / integration, padding / sizeof(O)) << ") + (" << chunk << " * " << conf.getNrItemsD0() << ");\n"
+    "if ( get_local_id(0) < " << conf.getNrItemsD0() << " ) {\n";
+    if (conf.getStatistics() || (conf.getMaxCandidates() > 0))
+    {
+        code << averageName << " integratedAverage = " << getIntegrationAverageOpenCL<T, O>("buffer[get_local_id(0) * " + std::to_string(conf.getNrThreadsD0()) + "]", integration) << ";\n"
+        << getIntegrationStoreOpenCL<T, O>("integratedAverage", "inGlobalMemory + get_local_id(0)", "(beam * " + std::to_string(nrDMs) + ") + dm");
+    }
+    else
+    {
+        code << getIntegrationStoreOpenCL<T, O>(getIntegrationAverageOpenCL<T, O>("buffer[get_local_id(0) * " + std::to_string(conf.getNrThreadsD0()) + "]", integration), "inGlobalMemory + get_local_id(0)", "(beam * " + std::to_string(nrDMs) + ") + dm");
+    }
+    if (conf.getStatistics())
+    {
+        code << statisticsName << " statisticsValue = integratedAverage;\n"
+        << getIntegrationStatisticsUpdateOpenCL("statisticsValue", "(chunk * " + std::to_string(conf.getNrItemsD0()) + ") + get_local_id(0)");
+    }
+    if (conf.getMaxCandidates() > 0)
+    {
+        code << getIntegrationCandidateOpenCL("integratedAverage", "beam", "dm", "(" + chunk + " * " + std::to_string(conf.getNrItemsD0()) + ") + get_local_id(0)", "(beam * " + std::to_string(nrDMs) + ") + dm", conf.getMaxCandidates());
+    }
+    code << "}\n";
+    if (conf.getStatistics())
+    {
+        // The buffer is overwritten by the next chunk
+        code << "barrier(CLK_LOCAL_MEM_FENCE);\n"
+        "}\n"
+        << getIntegrationStatisticsReduceOpenCL(conf.getNrThreadsD0()) <<
+        "if ( get_local_id(0) == 0 ) {\n"
+        << getIntegrationStatisticsStoreOpenCL("(beam * " + std::to_string(nrDMs) + ") + dm") <<
+        "}\n";
+    }
+    code << "}\n";
+    // End kernel's template
+
+    return code.release();
+}
+
+template <typename T>
+std::string getIntegrationSamplesDMsOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
+{
+    return getIntegrationSamplesDMsOpenCL<T, T>(conf, observation, dataName, dataName, integration, padding);
+}
+
+template <typename T, typename O>
+std::string getIntegrationSamplesDMsOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const std::string &outputDataName, const unsigned int integration, const unsigned int padding)
+{
+    typedef typename integrationTypes<T, O>::accumulator Accumulator;
+    unsigned int nrDMs = 0;
+    const unsigned int vectorWidth = getIntegrationVectorWidth(integrationMode::SamplesDMs, conf, observation, integration);
+    const std::string vectorName = getIntegrationVectorDataName(getIntegrationAccumulatorDataName<T>(), vectorWidth);
+    const std::string statisticsName = getIntegrationDataName<typename integrationTypes<T, O>::statistics>();
+    // Type of the expressions of getIntegrationAverageOpenCL, integer averages of the input type are already converted to O
+    const std::string averageName = (std::is_integral<O>::value && !integrationTypes<T, O>::scaled) ? getIntegrationDataName<O>() : getIntegrationDataName<typename integrationTypes<T, O>::average>();
+    // With statistics every work-item integrates all the samples of its DMs
+    const std::string outputSample = conf.getStatistics() ? "outputSample" : "get_group_id(1)";
+    kernelSourceBuilder code;
+
+    if (conf.getSubbandDedispersion())
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    // Begin kernel's template
+    code << "__kernel void integrationSamplesDMs" << integration << "(__global const " << dataName << " * const restrict input, __global " << outputDataName << " * const restrict output";
+    if (integrationTypes<T, O>::scaled)
+    {
+        code << ", __global const float * const restrict scales, __global const float * const restrict offsets";
+    }
+    if (conf.getStatistics())
+    {
+        code << ", __global " << statisticsName << " * const restrict statistics";
+    }
+    if (conf.getMaxCandidates() > 0)
+    {
+        code << getIntegrationCandidatesArgumentsOpenCL();
+    }
+    code << ") {\n"
+    << conf.getIntType() << " beam = get_group_id(2);\n";
+    if (!conf.getStatistics())
+    {
+        code << conf.getIntType() << " firstSample = get_group_id(1) * " << integration << ";\n";
+    }
+    code << conf.getIntType() << " dm = (get_group_id(0) * " << conf.getNrThreadsD0() * conf.getNrItemsD0() * vectorWidth << ") + get_local_id(0)";
+    if (vectorWidth > 1)
+    {
+        // Every work-item integrates vectorWidth contiguous DMs at once
+        code << " * " << vectorWidth;
+    }
+    code << ";\n";
+    if (conf.getStatistics())
+    {
+        for (unsigned int dm = 0; dm < conf.getNrItemsD0() * vectorWidth; dm++)
+        {
+            code << getIntegrationStatisticsDeclarationOpenCL(statisticsName, std::to_string(dm));
+        }
+        code << "for ( " << conf.getIntType() << " outputSample = 0; outputSample < " << observation.getNrSamplesPerBatch() / integration << "; outputSample++ ) {\n"
+        << conf.getIntType() << " firstSample = outputSample * " << integration << ";\n";
+    }
+    for (unsigned int dm = 0; dm < conf.getNrItemsD0(); dm++)
+    {
+        code << vectorName << " integratedSample" << dm << " = 0;\n";
+    }
+    code << "\n"
+    "for ( " << conf.getIntType() << " sample = firstSample; sample < firstSample + " << integration << "; sample++ ) {\n";
+    for (unsigned int dm = 0; dm < conf.getNrItemsD0(); dm++)
+    {
+        if (vectorWidth > 1)
+        {
+            code << "integratedSample" << dm << " += ";
+            if (!std::is_same<T, Accumulator>::value)
+            {
+                code << "convert_" << vectorName;
+            }
+            code << "(vload" << vectorWidth << "(0, input + (beam * " << observation.getNrSamplesPerBatch() * isa::utils::pad(nrDMs, padding / sizeof(T)) << " ) + (sample * " << isa::utils::pad(nrDMs, padding / sizeof(T)) << ") + (dm";
+            code.appendOffset(dm * conf.getNrThreadsD0() * vectorWidth) << ")));\n";
+        }
+        else
+        {
+            code << "integratedSample" << dm << " += input[(beam * " << observation.getNrSamplesPerBatch() * isa::utils::pad(nrDMs, padding / sizeof(T)) << " ) + (sample * " << isa::utils::pad(nrDMs, padding / sizeof(T)) << ") + (dm";
+            code.appendOffset(dm * conf.getNrThreadsD0()) << ")];\n";
+        }
+    }
+    code << "}\n";
+    for (unsigned int dm = 0; dm < conf.getNrItemsD0(); dm++)
+    {
+        const std::string item = "dm" + ((dm > 0) ? " + " + std::to_string(dm * conf.getNrThreadsD0() * vectorWidth) : "");
+
+        const std::string index = "(beam * " + std::to_string((observation.getNrSamplesPerBatch() / integration) * isa::utils::pad(nrDMs, padding / sizeof(O))) + ") + (" + outputSample + " * " + std::to_string(isa::utils::pad(nrDMs, padding / sizeof(O))) + ") + (" + item + ")";
+
+        if (conf.getStatistics() || (conf.getMaxCandidates() > 0))
+        {
+            code << getIntegrationVectorDataName(averageName, vectorWidth) << " integratedAverage" << dm << " = " << getIntegrationAverageOpenCL<T, O>("integratedSample" + std::to_string(dm), integration, vectorWidth) << ";\n";
+            code << getIntegrationStoreOpenCL<T, O>("integratedAverage" + std::to_string(dm), index, "(beam * " + std::to_string(nrDMs) + ") + " + item, vectorWidth);
+            for (unsigned int element = 0; element < vectorWidth; element++)
+            {
+                const std::string suffix = std::to_string((dm * vectorWidth) + element);
+                const std::string value = "integratedAverage" + std::to_string(dm) + ((vectorWidth > 1) ? ".s" + std::string(1, "0123456789abcdef"[element]) : "");
+                const std::string elementItem = item + ((element > 0) ? " + " + std::to_string(element) : "");
+
+                if (conf.getStatistics())
+                {
+                    code << statisticsName << " statisticsValue" << suffix << " = " << value << ";\n"
+                    << getIntegrationStatisticsUpdateOpenCL("statisticsValue" + suffix, "outputSample", suffix);
+                }
+                if (conf.getMaxCandidates() > 0)
+                {
+                    code << getIntegrationCandidateOpenCL(value, "beam", elementItem, outputSample, "(beam * " + std::to_string(nrDMs) + ") + " + elementItem, conf.getMaxCandidates());
+                }
+            }
+        }
+        else
+        {
+            code << getIntegrationStoreOpenCL<T, O>(getIntegrationAverageOpenCL<T, O>("integratedSample" + std::to_string(dm), integration, vectorWidth), index, "(beam * " + std::to_string(nrDMs) + ") + " + item, vectorWidth);
+        }
+    }
+    if (conf.getStatistics())
+    {
+        code << "}\n";
+        for (unsigned int dm = 0; dm < conf.getNrItemsD0(); dm++)
+        {
+            for (unsigned int element = 0; element < vectorWidth; element++)
+            {
+                code << getIntegrationStatisticsStoreOpenCL("(beam * " + std::to_string(nrDMs) + ") + dm + " + std::to_string((dm * conf.getNrThreadsD0() * vectorWidth) + element), std::to_string((dm * vectorWidth) + element));
+            }
+        }
+    }
+    code << "}\n";
+    // End kernel's template
+
+    return code.release();
+}
+
+template <typename T>
+std::string getIntegrationDMsSamplesBoxcarOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const std::vector<unsigned int> &widths, const unsigned int padding)
+{
+    unsigned int nrDMs = 0;
+    const unsigned int nrSamples = observation.getNrSamplesPerBatch() / observation.getDownsampling();
+    const unsigned int rowSize = isa::utils::pad(nrSamples, padding / sizeof(T));
+    const std::vector<uint64_t> offsets = getIntegrationBoxcarOffsets<T>(conf.getSubbandDedispersion(), observation, widths, padding);
+    // Each work-group computes nrThreadsD0 * nrItemsD0 windows of every width, reading widths.back() more samples; the last one is only read by the last slide
+    const unsigned int nrOutputSamplesPerGroup = conf.getNrThreadsD0() * conf.getNrItemsD0();
+    const unsigned int nrSamplesPerGroup = nrOutputSamplesPerGroup + widths.back();
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<T>();
+    const bool compensated = !std::is_integral<typename integrationAccumulator<T>::type>::value;
+    kernelSourceBuilder code;
+
+    if (conf.getSubbandDedispersion())
+    {
+        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+    }
+    else
+    {
+        nrDMs = observation.getNrDMs();
+    }
+    // Begin kernel's template
+    code << "__kernel void integrationDMsSamplesBoxcar" << widths.back() << "(__global const " << dataName << " * const restrict input, __global " << dataName << " * const restrict output) {\n"
+    << conf.getIntType() << " beam = get_group_id(2);\n"
+    << conf.getIntType() << " dm = get_group_id(1);\n"
+    << conf.getIntType() << " firstSample = get_group_id(0) * " << nrOutputSamplesPerGroup << ";\n"
+    << conf.getIntType() << " firstItem = get_local_id(0) * " << conf.getNrItemsD0() << ";\n"
+    "__local " << dataName << " samples[" << nrSamplesPerGroup << "];\n"
+    << conf.getIntType() << " inGlobalMemory = (beam * " << nrDMs * rowSize << ") + (dm * " << rowSize << ") + firstSample;\n"
+    "\n"
+    "// Single read of the input, samples after the end of the row are zero\n"
+    "for ( " << conf.getIntType() << " sample = get_local_id(0); sample < " << nrSamplesPerGroup << "; sample += " << conf.getNrThreadsD0() << " ) {\n"
+    "if ( firstSample + sample < " << nrSamples << " ) {\n"
+    "samples[sample] = input[inGlobalMemory + sample];\n"
+    "} else {\n"
+    "samples[sample] = 0;\n"
+    "}\n"
+    "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "// Each work-item slides the windows of every width over nrItemsD0 consecutive samples\n"
+    "if ( firstSample + firstItem >= " << getNrBoxcarSamples(observation, widths.front()) << " ) {\n"
+    "return;\n"
+    "}\n"
+    "// First windows, each width adds the samples after the previous one\n";
+    for (unsigned int width = 0; width < widths.size(); width++)
+    {
+        const std::string sum = "integratedSample" + std::to_string(width);
+
+        if (width == 0)
+        {
+            code << accumulatorName << " " << sum << " = 0;\n";
+            if (compensated)
+            {
+                code << accumulatorName << " " << sum << "Compensation = 0;\n";
+            }
+        }
+        else
+        {
+            code << accumulatorName << " " << sum << " = integratedSample" << width - 1 << ";\n";
+            if (compensated)
+            {
+                code << accumulatorName << " " << sum << "Compensation = integratedSample" << width - 1 << "Compensation;\n";
+            }
+        }
+        code << "for ( " << conf.getIntType() << " item = " << ((width == 0) ? 0 : widths[width - 1]) << "; item < " << widths[width] << "; item++ ) {\n"
+        << getIntegrationCompensatedAddOpenCL<T>(sum, "samples[firstItem + item]") <<
+        "}\n";
+    }
+    code << "// Running windows, the cost per sample does not depend on the width\n"
+    "for ( " << conf.getIntType() << " sample = firstItem; sample < firstItem + " << conf.getNrItemsD0() << "; sample++ ) {\n";
+    for (unsigned int width = 0; width < widths.size(); width++)
+    {
+        const std::string sum = "integratedSample" + std::to_string(width);
+
+        code << "// Width " << widths[width] << "\n"
+        "if ( firstSample + sample < " << getNrBoxcarSamples(observation, widths[width]) << " ) {\n"
+        "output[" << offsets[width] << " + inGlobalMemory + sample] = " << getIntegrationAverageOpenCL<T>(getIntegrationCompensatedSumOpenCL<T>(sum), widths[width]) << ";\n"
+        << getIntegrationCompensatedAddOpenCL<T>(sum, "samples[sample + " + std::to_string(widths[width]) + "]")
+        << getIntegrationCompensatedAddOpenCL<T>(sum, "-samples[sample]") <<
+        "}\n";
+    }
+    code << "}\n"
+    "}\n";
+    // End kernel's template
+
+    return code.release();
+}
+
+template <typename T>
+std::string getIntegrationDMsSamplesStreamOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
+{
+    const unsigned int nrSamples = observation.getNrSamplesPerBatch() / observation.getDownsampling();
+    const unsigned int maxNrOutputSamples = (integration - 1 + nrSamples) / integration;
+    // Each work-group computes nrItemsD0 output samples
+    const unsigned int nrSamplesPerGroup = conf.getNrItemsD0() * integration;
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<T>();
+    kernelSourceBuilder code;
+
+    // Begin kernel's template
+    code << "__kernel void integrationDMsSamplesStream" << integration << "(__global const " << dataName << " * const restrict input, __global " << dataName << " * const restrict output, __global const " << accumulatorName << " * const restrict partialSums, __global " << accumulatorName << " * const restrict nextPartialSums, const unsigned int nrPartialSamples) {\n"
+    << conf.getIntType() << " row = get_group_id(1);\n"
+    << conf.getIntType() << " nrOutputSamples = (nrPartialSamples + " << nrSamples << ") / " << integration << ";\n"
+    "__local " << dataName << " samples[" << nrSamplesPerGroup << "];\n"
+    << conf.getIntType() << " inGlobalMemory = (row * " << isa::utils::pad(nrSamples, padding / sizeof(T)) << ") + (get_group_id(0) * " << nrSamplesPerGroup << ");\n"
+    "\n"
+    "// Load samples in local memory, the first nrPartialSamples of the stream are already in the partial sums\n"
+    "for ( " << conf.getIntType() << " sample = get_local_id(0); sample < " << nrSamplesPerGroup << "; sample += " << conf.getNrThreadsD0() << " ) {\n"
+    "if ( (get_group_id(0) * " << nrSamplesPerGroup << ") + sample >= nrPartialSamples && (get_group_id(0) * " << nrSamplesPerGroup << ") + sample < nrPartialSamples + " << nrSamples << " ) {\n"
+    "samples[sample] = input[inGlobalMemory + sample - nrPartialSamples];\n"
+    "} else {\n"
+    "samples[sample] = 0;\n"
+    "}\n"
+    "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "// Integrate, the sample after the last complete one holds the samples to carry over\n"
+    "for ( " << conf.getIntType() << " sample = get_local_id(0); sample < " << conf.getNrItemsD0() << "; sample += " << conf.getNrThreadsD0() << " ) {\n"
+    << conf.getIntType() << " outputSample = (get_group_id(0) * " << conf.getNrItemsD0() << ") + sample;\n"
+    << accumulatorName << " integratedSample = 0;\n"
+    "if ( outputSample > nrOutputSamples ) {\n"
+    "break;\n"
+    "}\n"
+    "if ( outputSample == 0 && nrPartialSamples > 0 ) {\n"
+    "integratedSample = partialSums[row];\n"
+    "}\n"
+    "for ( " << conf.getIntType() << " item = 0; item < " << integration << "; item++ ) {\n"
+    "integratedSample += samples[(sample * " << integration << ") + item];\n"
+    "}\n"
+    "if ( outputSample < nrOutputSamples ) {\n"
+    "output[(row * " << isa::utils::pad(maxNrOutputSamples, padding / sizeof(T)) << ") + outputSample] = " << getIntegrationAverageOpenCL<T>("integratedSample", integration) << ";\n"
+    "} else {\n"
+    "nextPartialSums[row] = integratedSample;\n"
+    "}\n"
+    "}\n"
+    "}\n";
+    // End kernel's template
 
-                for ( unsigned int i = 0; i < integration; i++ )
-                {
-                    integratedSample += input[(beam * observation.getNrChannels() * observation.getNrSamplesPerDispersedBatch(false, padding / sizeof(NumericType))) + (channel * observation.getNrSamplesPerDispersedBatch(false, padding / sizeof(NumericType))) + (sample + i)];
-                }
-                output[(beam * observation.getNrChannels() * isa::utils::pad(observation.getNrSamplesPerDispersedBatch() / integration, padding / sizeof(NumericType))) + (channel * isa::utils::pad(observation.getNrSamplesPerDispersedBatch() / integration, padding / sizeof(NumericType))) + (sample / integration)] = integratedSample / integration;
-            }
-        }
-    }
+    return code.release();
 }
 
 template <typename T>
-void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+std::string getIntegrationDMsSamplesToSamplesDMsOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
 {
     unsigned int nrDMs = 0;
+    const unsigned int nrSamples = observation.getNrSamplesPerBatch() / observation.getDownsampling();
+    const unsigned int nrOutputSamples = nrSamples / integration;
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<T>();
+    kernelSourceBuilder code;
 
-    if (subbandDedispersion)
+    if (conf.getSubbandDedispersion())
     {
         nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
     }
@@ -113,31 +2922,50 @@ void integrationDMsSamples(const bool subbandDedispersion, const AstroData::Obse
     {
         nrDMs = observation.getNrDMs();
     }
+    // Begin kernel's template
+    code << "__kernel void integrationDMsSamplesToSamplesDMs" << integration << "(__global const " << dataName << " * const restrict input, __global " << dataName << " * const restrict output) {\n"
+    << conf.getIntType() << " beam = get_group_id(2);\n"
+    << conf.getIntType() << " firstSample = get_group_id(0) * " << conf.getNrItemsD0() << ";\n"
+    << conf.getIntType() << " firstDM = get_group_id(1) * " << conf.getNrItemsD1() << ";\n"
+    "__local " << dataName << " buffer[" << conf.getNrItemsD0() << "][" << conf.getNrItemsD1() + 1 << "];\n"
+    "\n"
+    "// Integrate, consecutive work-items read consecutive integrations of the same DM\n"
+    "for ( " << conf.getIntType() << " item = get_local_id(0); item < " << conf.getNrItemsD0() * conf.getNrItemsD1() << "; item += " << conf.getNrThreadsD0() << " ) {\n"
+    << conf.getIntType() << " sample = item % " << conf.getNrItemsD0() << ";\n"
+    << conf.getIntType() << " dm = item / " << conf.getNrItemsD0() << ";\n"
+    << accumulatorName << " integratedSample = 0;\n"
+    "if ( (firstSample + sample < " << nrOutputSamples << ") && (firstDM + dm < " << nrDMs << ") ) {\n"
+    << conf.getIntType() << " inGlobalMemory = (beam * " << nrDMs * isa::utils::pad(nrSamples, padding / sizeof(T)) << ") + ((firstDM + dm) * " << isa::utils::pad(nrSamples, padding / sizeof(T)) << ") + ((firstSample + sample) * " << integration << ");\n"
+    "for ( " << conf.getIntType() << " i = 0; i < " << integration << "; i++ ) {\n"
+    "integratedSample += input[inGlobalMemory + i];\n"
+    "}\n"
+    "}\n"
+    "buffer[sample][dm] = " << getIntegrationAverageOpenCL<T>("integratedSample", integration) << ";\n"
+    "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "// Store, consecutive work-items write consecutive DMs of the same sample\n"
+    "for ( " << conf.getIntType() << " item = get_local_id(0); item < " << conf.getNrItemsD0() * conf.getNrItemsD1() << "; item += " << conf.getNrThreadsD0() << " ) {\n"
+    << conf.getIntType() << " sample = item / " << conf.getNrItemsD1() << ";\n"
+    << conf.getIntType() << " dm = item % " << conf.getNrItemsD1() << ";\n"
+    "if ( (firstSample + sample < " << nrOutputSamples << ") && (firstDM + dm < " << nrDMs << ") ) {\n"
+    "output[(beam * " << nrOutputSamples * isa::utils::pad(nrDMs, padding / sizeof(T)) << ") + ((firstSample + sample) * " << isa::utils::pad(nrDMs, padding / sizeof(T)) << ") + firstDM + dm] = buffer[sample][dm];\n"
+    "}\n"
+    "}\n"
+    "}\n";
+    // End kernel's template
 
-    for (unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++)
-    {
-        for (unsigned int dm = 0; dm < nrDMs; dm++)
-        {
-            for (unsigned int sample = 0; sample < observation.getNrSamplesPerBatch() / observation.getDownsampling(); sample += integration)
-            {
-                T integratedSample = 0;
-
-                for (unsigned int i = 0; i < integration; i++)
-                {
-                    integratedSample += input[(beam * nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling(), padding / sizeof(T))) + (dm * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling(), padding / sizeof(T))) + (sample + i)];
-                }
-                output[(beam * nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling() / integration, padding / sizeof(T))) + (dm * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling() / integration, padding / sizeof(T))) + (sample / integration)] = integratedSample / integration;
-            }
-        }
-    }
+    return code.release();
 }
 
 template <typename T>
-void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Observation &observation, const unsigned int integration, const unsigned int padding, const std::vector<T> &input, std::vector<T> &output)
+std::string getIntegrationSamplesDMsToDMsSamplesOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
 {
     unsigned int nrDMs = 0;
+    const unsigned int nrOutputSamples = observation.getNrSamplesPerBatch() / integration;
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<T>();
+    kernelSourceBuilder code;
 
-    if (subbandDedispersion)
+    if (conf.getSubbandDedispersion())
     {
         nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
     }
@@ -145,29 +2973,51 @@ void integrationSamplesDMs(const bool subbandDedispersion, const AstroData::Obse
     {
         nrDMs = observation.getNrDMs();
     }
-    for (unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++)
-    {
-        for (unsigned int dm = 0; dm < nrDMs; dm++)
-        {
-            for (unsigned int sample = 0; sample < observation.getNrSamplesPerBatch(); sample += integration)
-            {
-                T integratedSample = 0;
+    // Begin kernel's template
+    code << "__kernel void integrationSamplesDMsToDMsSamples" << integration << "(__global const " << dataName << " * const restrict input, __global " << dataName << " * const restrict output) {\n"
+    << conf.getIntType() << " beam = get_group_id(2);\n"
+    << conf.getIntType() << " firstSample = get_group_id(0) * " << conf.getNrItemsD0() << ";\n"
+    << conf.getIntType() << " firstDM = get_group_id(1) * " << conf.getNrItemsD1() << ";\n"
+    "__local " << dataName << " buffer[" << conf.getNrItemsD1() << "][" << conf.getNrItemsD0() + 1 << "];\n"
+    "\n"
+    "// Integrate, consecutive work-items read consecutive DMs of the same sample\n"
+    "for ( " << conf.getIntType() << " item = get_local_id(0); item < " << conf.getNrItemsD0() * conf.getNrItemsD1() << "; item += " << conf.getNrThreadsD0() << " ) {\n"
+    << conf.getIntType() << " sample = item / " << conf.getNrItemsD1() << ";\n"
+    << conf.getIntType() << " dm = item % " << conf.getNrItemsD1() << ";\n"
+    << accumulatorName << " integratedSample = 0;\n"
+    "if ( (firstSample + sample < " << nrOutputSamples << ") && (firstDM + dm < " << nrDMs << ") ) {\n"
+    << conf.getIntType() << " inGlobalMemory = (beam * " << observation.getNrSamplesPerBatch() * isa::utils::pad(nrDMs, padding / sizeof(T)) << ") + ((firstSample + sample) * " << integration * isa::utils::pad(nrDMs, padding / sizeof(T)) << ") + firstDM + dm;\n"
+    "for ( " << conf.getIntType() << " i = 0; i < " << integration << "; i++ ) {\n"
+    "integratedSample += input[inGlobalMemory + (i * " << isa::utils::pad(nrDMs, padding / sizeof(T)) << ")];\n"
+    "}\n"
+    "}\n"
+    "buffer[dm][sample] = " << getIntegrationAverageOpenCL<T>("integratedSample", integration) << ";\n"
+    "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "// Store, consecutive work-items write consecutive samples of the same DM\n"
+    "for ( " << conf.getIntType() << " item = get_local_id(0); item < " << conf.getNrItemsD0() * conf.getNrItemsD1() << "; item += " << conf.getNrThreadsD0() << " ) {\n"
+    << conf.getIntType() << " sample = item % " << conf.getNrItemsD0() << ";\n"
+    << conf.getIntType() << " dm = item / " << conf.getNrItemsD0() << ";\n"
+    "if ( (firstSample + sample < " << nrOutputSamples << ") && (firstDM + dm < " << nrDMs << ") ) {\n"
+    "output[(beam * " << nrDMs * isa::utils::pad(nrOutputSamples, padding / sizeof(T)) << ") + ((firstDM + dm) * " << isa::utils::pad(nrOutputSamples, padding / sizeof(T)) << ") + firstSample + sample] = buffer[dm][sample];\n"
+    "}\n"
+    "}\n"
+    "}\n";
+    // End kernel's template
 
-                for (unsigned int i = 0; i < integration; i++)
-                {
-                    integratedSample += input[(beam * observation.getNrSamplesPerBatch() * isa::utils::pad(nrDMs, padding / sizeof(T))) + ((sample + i) * isa::utils::pad(nrDMs, padding / sizeof(T))) + dm];
-                }
-                output[(beam * (observation.getNrSamplesPerBatch() / integration) * isa::utils::pad(nrDMs, padding / sizeof(T))) + ((sample / integration) * isa::utils::pad(nrDMs, padding / sizeof(T))) + dm] = integratedSample / integration;
-            }
-        }
-    }
+    return code.release();
 }
 
 template <typename T>
-std::string *getIntegrationDMsSamplesOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
+std::string getIntegrationDMsSamplesPyramidOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const std::vector<unsigned int> &integrations, const unsigned int padding)
 {
     unsigned int nrDMs = 0;
-    std::string *code = new std::string();
+    const unsigned int nrSamples = observation.getNrSamplesPerBatch() / observation.getDownsampling();
+    // Each work-group integrates nrItemsD0 blocks of the largest integration factor
+    const unsigned int nrSamplesPerGroup = integrations.back() * conf.getNrItemsD0();
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<T>();
+    const std::vector<uint64_t> offsets = getIntegrationPyramidOffsets<T>(conf.getSubbandDedispersion(), observation, integrations, padding);
+    kernelSourceBuilder code;
 
     if (conf.getSubbandDedispersion())
     {
@@ -178,213 +3028,133 @@ std::string *getIntegrationDMsSamplesOpenCL(const integrationConf &conf, const A
         nrDMs = observation.getNrDMs();
     }
     // Begin kernel's template
-    *code = "__kernel void integrationDMsSamples" + std::to_string(integration) + "(__global const " + dataName + " * const restrict input, __global " + dataName + " * const restrict output) {\n"
-    + conf.getIntType() + " beam = get_group_id(2);\n"
-    + conf.getIntType() + " dm = get_group_id(1);\n"
-    "__local " + dataName + " buffer[" + std::to_string(conf.getNrThreadsD0() * conf.getNrItemsD0()) + "];\n"
-    + conf.getIntType() + " inGlobalMemory = (beam * " + std::to_string(nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling(), padding / sizeof(T))) + ") + (dm * " + std::to_string(isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling(), padding / sizeof(T))) + ") + (get_group_id(0) * " + std::to_string(integration * conf.getNrItemsD0()) + ");\n"
-    "<%DEFS%>"
+    code << "__kernel void integrationDMsSamplesPyramid" << integrations.back() << "(__global const " << dataName << " * const restrict input, __global " << dataName << " * const restrict output) {\n"
+    << conf.getIntType() << " beam = get_group_id(2);\n"
+    << conf.getIntType() << " dm = get_group_id(1);\n"
+    "__local " << dataName << " samples[" << nrSamplesPerGroup << "];\n"
+    "__local " << accumulatorName << " sums[2][" << nrSamplesPerGroup / integrations.front() << "];\n"
+    << conf.getIntType() << " inGlobalMemory = (beam * " << nrDMs * isa::utils::pad(nrSamples, padding / sizeof(T)) << ") + (dm * " << isa::utils::pad(nrSamples, padding / sizeof(T)) << ") + (get_group_id(0) * " << nrSamplesPerGroup << ");\n"
     "\n"
-    "// First computing phase\n"
-    "for ( " + conf.getIntType() + " sample = get_local_id(0); sample < " + std::to_string(integration) + "; sample += " + std::to_string(conf.getNrThreadsD0()) + " ) {\n"
-    "<%SUM%>"
+    "// Single read of the input, the last work-group can be partial\n"
+    "for ( " << conf.getIntType() << " sample = get_local_id(0); (sample < " << nrSamplesPerGroup << ") && (sample + (get_group_id(0) * " << nrSamplesPerGroup << ") < " << nrSamples << "); sample += " << conf.getNrThreadsD0() << " ) {\n"
+    "samples[sample] = input[inGlobalMemory + sample];\n"
     "}\n"
-    "<%LOAD%>"
-    "barrier(CLK_LOCAL_MEM_FENCE);\n"
-    "// Reduce\n"
-    + conf.getIntType() + " threshold = " + std::to_string(conf.getNrThreadsD0() / 2) + ";\n"
-    "for ( " + conf.getIntType() + " sample = get_local_id(0); threshold > 0; threshold /= 2 ) {\n"
-    "if ( sample < threshold ) {\n"
-    "<%REDUCE%>"
-    "}\n"
-    "barrier(CLK_LOCAL_MEM_FENCE);\n"
-    "}\n"
-    "inGlobalMemory = (beam * " + std::to_string(nrDMs * isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling() / integration, padding / sizeof(T))) + ") + (dm * " + std::to_string(isa::utils::pad(observation.getNrSamplesPerBatch() / observation.getDownsampling() / integration, padding / sizeof(T))) + ") + (get_group_id(0) * " + std::to_string(conf.getNrItemsD0()) + ");\n"
-    "if ( get_local_id(0) < " + std::to_string(conf.getNrItemsD0()) + " ) {\n";
-    if (dataName == "float")
-    {
-        *code += "output[inGlobalMemory + get_local_id(0)] = buffer[get_local_id(0) * " + std::to_string(conf.getNrThreadsD0()) + "] * " + std::to_string(1.0f / integration) + "f;\n";
-    }
-    else if (dataName == "double")
-    {
-        *code += "output[inGlobalMemory + get_local_id(0)] = buffer[get_local_id(0) * " + std::to_string(conf.getNrThreadsD0()) + "] * " + std::to_string(1.0 / integration) + ";\n";
-    }
-    else
-    {
-        *code += "output[inGlobalMemory + get_local_id(0)] = buffer[get_local_id(0) * " + std::to_string(conf.getNrThreadsD0()) + "] / " + std::to_string(integration) + ";\n";
-    }
-    *code += "}\n"
-             "}\n";
-    std::string defs_sTemplate = dataName + " integratedSample<%NUM%> = 0;\n";
-    std::string sum_sTemplate = "integratedSample<%NUM%> += input[inGlobalMemory + sample + <%OFFSET%>];\n";
-    std::string load_sTemplate = "buffer[get_local_id(0) + <%OFFSET%>] = integratedSample<%NUM%>;\n";
-    std::string reduce_sTemplate = "integratedSample<%NUM%> += buffer[(sample + <%OFFSET%>) + threshold];\n"
-    "buffer[sample + <%OFFSET%>] = integratedSample<%NUM%>;\n";
-    // End kernel's template
-
-    std::string *defs_s = new std::string();
-    std::string *sum_s = new std::string();
-    std::string *load_s = new std::string();
-    std::string *reduce_s = new std::string();
-
-    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    "barrier(CLK_LOCAL_MEM_FENCE);\n";
+    for (unsigned int level = 0; level < integrations.size(); level++)
     {
-        std::string sample_s = std::to_string(sample);
-        std::string offset_s = std::to_string(sample * integration);
-        std::string localOffset_s = std::to_string(sample * conf.getNrThreadsD0());
-        std::string *temp = 0;
+        const unsigned int nrOutputSamples = nrSamplesPerGroup / integrations[level];
+        const unsigned int outputRowSize = isa::utils::pad(nrSamples / integrations[level], padding / sizeof(T));
 
-        temp = isa::utils::replace(&defs_sTemplate, "<%NUM%>", sample_s);
-        defs_s->append(*temp);
-        delete temp;
-        temp = isa::utils::replace(&sum_sTemplate, "<%NUM%>", sample_s);
-        if (sample == 0)
+        code << "// Integration " << integrations[level] << "\n"
+        "inGlobalMemory = " << offsets[level] << " + (beam * " << nrDMs * outputRowSize << ") + (dm * " << outputRowSize << ") + (get_group_id(0) * " << nrOutputSamples << ");\n"
+        "for ( " << conf.getIntType() << " sample = get_local_id(0); (sample < " << nrOutputSamples << ") && (sample + (get_group_id(0) * " << nrOutputSamples << ") < " << nrSamples / integrations[level] << "); sample += " << conf.getNrThreadsD0() << " ) {\n"
+        << accumulatorName << " integratedSample = 0;\n";
+        if (level == 0)
         {
-            std::string empty_s("");
-            temp = isa::utils::replace(temp, " + <%OFFSET%>", empty_s, true);
+            code << "for ( " << conf.getIntType() << " item = 0; item < " << integrations[level] << "; item++ ) {\n"
+            "integratedSample += samples[(sample * " << integrations[level] << ") + item];\n"
+            "}\n";
         }
         else
         {
-            temp = isa::utils::replace(temp, "<%OFFSET%>", offset_s, true);
-        }
-        sum_s->append(*temp);
-        delete temp;
-        temp = isa::utils::replace(&load_sTemplate, "<%NUM%>", sample_s);
-        if (sample == 0)
-        {
-            std::string empty_s("");
-            temp = isa::utils::replace(temp, " + <%OFFSET%>", empty_s, true);
-        }
-        else
-        {
-            temp = isa::utils::replace(temp, "<%OFFSET%>", localOffset_s, true);
-        }
-        load_s->append(*temp);
-        delete temp;
-        temp = isa::utils::replace(&reduce_sTemplate, "<%NUM%>", sample_s);
-        if (sample == 0)
-        {
-            std::string empty_s("");
-            temp = isa::utils::replace(temp, " + <%OFFSET%>", empty_s, true);
+            const unsigned int ratio = integrations[level] / integrations[level - 1];
+
+            code << "for ( " << conf.getIntType() << " item = 0; item < " << ratio << "; item++ ) {\n"
+            "integratedSample += sums[" << (level - 1) % 2 << "][(sample * " << ratio << ") + item];\n"
+            "}\n";
         }
-        else
+        code << "sums[" << level % 2 << "][sample] = integratedSample;\n"
+        "output[inGlobalMemory + sample] = " << getIntegrationAverageOpenCL<T>("integratedSample", integrations[level]) << ";\n"
+        "}\n";
+        if (level + 1 < integrations.size())
         {
-            temp = isa::utils::replace(temp, "<%OFFSET%>", localOffset_s, true);
+            code << "barrier(CLK_LOCAL_MEM_FENCE);\n";
         }
-        reduce_s->append(*temp);
-        delete temp;
     }
-    code = isa::utils::replace(code, "<%DEFS%>", *defs_s, true);
-    code = isa::utils::replace(code, "<%SUM%>", *sum_s, true);
-    code = isa::utils::replace(code, "<%LOAD%>", *load_s, true);
-    code = isa::utils::replace(code, "<%REDUCE%>", *reduce_s, true);
-    delete defs_s;
-    delete sum_s;
-    delete load_s;
-    delete reduce_s;
+    code << "}\n";
+    // End kernel's template
 
-    return code;
+    return code.release();
 }
 
-template <typename T>
-std::string *getIntegrationSamplesDMsOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
+template<typename NumericType>
+std::string getIntegrationBeforeDedispersionInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
 {
-    unsigned int nrDMs = 0;
-    std::string *code = new std::string();
+    return getIntegrationInPlaceOpenCL<NumericType>(conf, observation, dataName, observation.getNrChannels(), observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion()), integration, padding);
+}
 
-    if (conf.getSubbandDedispersion())
+template<typename NumericType>
+std::string getIntegrationBeforeDedispersionOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
+{
+    const unsigned int nrSamples = observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion());
+    const unsigned int nrOutputSamples = nrSamples / integration;
+    // Each work-group integrates one chunk of a channel, nrThreadsD0 * nrItemsD0 output samples
+    const unsigned int nrOutputSamplesPerGroup = conf.getNrThreadsD0() * conf.getNrItemsD0();
+    const unsigned int nrSamplesPerGroup = nrOutputSamplesPerGroup * integration;
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<NumericType>();
+    const std::string average = getIntegrationAverageOpenCL<NumericType>("integratedSample<%NUM%>", integration);
+    const unsigned int vectorWidth = getIntegrationInPlaceVectorWidth(conf, nrSamples, integration);
+    kernelSourceBuilder code;
+
+    // Begin kernel's template
+    code << "__kernel void integrationBeforeDedispersion" << integration << "(__global const " << dataName << " * const restrict input, __global " << dataName << " * const restrict output) {\n"
+    "__local " << dataName << " buffer[" << nrSamplesPerGroup << "];\n"
+    "// Load samples in local memory\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
     {
-        nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+        code << accumulatorName << " integratedSample" << sample << " = 0;\n";
     }
-    else
+    code << conf.getIntType() << " inGlobalMemory = (get_group_id(2) * " << observation.getNrChannels() * static_cast<uint64_t>(isa::utils::pad(nrSamples, padding / sizeof(NumericType))) << ") + (get_group_id(1) * " << isa::utils::pad(nrSamples, padding / sizeof(NumericType)) << ") + (get_group_id(0) * " << nrSamplesPerGroup << ");\n"
+    "for ( " << conf.getIntType() << " item = get_local_id(0)";
+    if (vectorWidth > 1)
     {
-        nrDMs = observation.getNrDMs();
+        code << " * " << vectorWidth;
     }
-    // Begin kernel's template
-    *code = "__kernel void integrationSamplesDMs" + std::to_string(integration) + "(__global const " + dataName + " * const restrict input, __global " + dataName + " * const restrict output) {\n"
-    + conf.getIntType() + " beam = get_group_id(2);\n"
-    + conf.getIntType() + " firstSample = get_group_id(1) * " + std::to_string(integration) + ";\n"
-    + conf.getIntType() + " dm = (get_group_id(0) * " + std::to_string(conf.getNrThreadsD0() * conf.getNrItemsD0()) + ") + get_local_id(0);\n"
-    "<%DEFS%>"
-    "\n"
-    "for ( " + conf.getIntType() + " sample = firstSample; sample < firstSample + " + std::to_string(integration) + "; sample++ ) {\n"
-    "<%SUM%>"
-    "}\n"
-    "<%STORE%>"
-    "}\n";
-    std::string defs_sTemplate = dataName + " integratedSample<%NUM%> = 0;\n";
-    std::string sum_sTemplate = "integratedSample<%NUM%> += input[(beam * " + std::to_string(observation.getNrSamplesPerBatch() * isa::utils::pad(nrDMs, padding / sizeof(T))) + " ) + (sample * " + std::to_string(isa::utils::pad(nrDMs, padding / sizeof(T))) + ") + (dm + <%OFFSET%>)];\n";
-    std::string store_sTemplate;
-    if (dataName == "float")
+    code << "; (item < " << nrSamplesPerGroup << ") && (item + (get_group_id(0) * " << nrSamplesPerGroup << ") < " << nrSamples << "); item += " << conf.getNrThreadsD0() * vectorWidth << " ) {\n";
+    if (vectorWidth > 1)
     {
-        store_sTemplate += "output[(beam * " + std::to_string((observation.getNrSamplesPerBatch() / integration) * isa::utils::pad(nrDMs, padding / sizeof(T))) + ") + (get_group_id(1) * " + std::to_string(isa::utils::pad(nrDMs, padding / sizeof(T))) + ") + (dm + <%OFFSET%>)] = integratedSample<%NUM%> * " + std::to_string(1.0f / integration) + "f;\n";
+        code << "vstore" << vectorWidth << "(vload" << vectorWidth << "(0, input + inGlobalMemory + item), 0, buffer + item);\n";
     }
-    else if (dataName == "double")
+    else
     {
-        store_sTemplate += "output[(beam * " + std::to_string((observation.getNrSamplesPerBatch() / integration) * isa::utils::pad(nrDMs, padding / sizeof(T))) + ") + (get_group_id(1) * " + std::to_string(isa::utils::pad(nrDMs, padding / sizeof(T))) + ") + (dm + <%OFFSET%>)] = integratedSample<%NUM%> * " + std::to_string(1.0 / integration) + ";\n";
+        code << "buffer[item] = input[inGlobalMemory + item];\n";
     }
-    else
+    code << "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "// Integrate samples\n"
+    "for ( " << conf.getIntType() << " item = 0; item < " << integration << "; item++ ) {\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
     {
-        store_sTemplate += "output[(beam * " + std::to_string((observation.getNrSamplesPerBatch() / integration) * isa::utils::pad(nrDMs, padding / sizeof(T))) + ") + (get_group_id(1) * " + std::to_string(isa::utils::pad(nrDMs, padding / sizeof(T))) + ") + (dm + <%OFFSET%>)] = integratedSample<%NUM%> / " + std::to_string(integration) + ";\n";
+        code << "integratedSample" << sample << " += buffer[(get_local_id(0) * " << integration << ")";
+        code.appendOffset(sample * integration * conf.getNrThreadsD0()) << " + item];\n";
     }
-    // End kernel's template
-
-    std::string *defs_s = new std::string();
-    std::string *sum_s = new std::string();
-    std::string *store_s = new std::string();
-
-    for (unsigned int dm = 0; dm < conf.getNrItemsD0(); dm++)
+    code << "}\n"
+    "// Store integrated data\n"
+    "inGlobalMemory = (get_group_id(2) * " << observation.getNrChannels() * static_cast<uint64_t>(isa::utils::pad(nrOutputSamples, padding / sizeof(NumericType))) << ") + (get_group_id(1) * " << isa::utils::pad(nrOutputSamples, padding / sizeof(NumericType)) << ") + (get_group_id(0) * " << nrOutputSamplesPerGroup << ");\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
     {
-        std::string dm_s = std::to_string(dm);
-        std::string offset_s = std::to_string(dm * conf.getNrThreadsD0());
-        std::string *temp = 0;
-
-        temp = isa::utils::replace(&defs_sTemplate, "<%NUM%>", dm_s);
-        defs_s->append(*temp);
-        delete temp;
-        temp = isa::utils::replace(&sum_sTemplate, "<%NUM%>", dm_s);
-        if (dm == 0)
+        // Only the last chunk of a channel can be partial, the output rows are not large enough for a whole chunk
+        if ((nrOutputSamples % nrOutputSamplesPerGroup) != 0)
         {
-            std::string empty_s("");
-            temp = isa::utils::replace(temp, " + <%OFFSET%>", empty_s, true);
+            code << "if ( (get_group_id(0) * " << nrOutputSamplesPerGroup << ") + get_local_id(0)";
+            code.appendOffset(sample * conf.getNrThreadsD0()) << " < " << nrOutputSamples << " ) {\n";
         }
-        else
-        {
-            temp = isa::utils::replace(temp, "<%OFFSET%>", offset_s, true);
-        }
-        sum_s->append(*temp);
-        delete temp;
-        temp = isa::utils::replace(&store_sTemplate, "<%NUM%>", dm_s);
-        if (dm == 0)
-        {
-            std::string empty_s("");
-            temp = isa::utils::replace(temp, " + <%OFFSET%>", empty_s, true);
-        }
-        else
+        code << "output[inGlobalMemory + get_local_id(0)";
+        code.appendOffset(sample * conf.getNrThreadsD0()) << "] = ";
+        code.appendReplaced(average, "<%NUM%>", sample) << ";\n";
+        if ((nrOutputSamples % nrOutputSamplesPerGroup) != 0)
         {
-            temp = isa::utils::replace(temp, "<%OFFSET%>", offset_s, true);
+            code << "}\n";
         }
-        store_s->append(*temp);
-        delete temp;
     }
-    code = isa::utils::replace(code, "<%DEFS%>", *defs_s, true);
-    code = isa::utils::replace(code, "<%SUM%>", *sum_s, true);
-    code = isa::utils::replace(code, "<%STORE%>", *store_s, true);
-    delete defs_s;
-    delete sum_s;
-    delete store_s;
-
-    return code;
-}
+    code << "}\n";
+    // End kernel's template
 
-template<typename NumericType>
-std::string *getIntegrationBeforeDedispersionInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
-{
-    return getIntegrationInPlaceOpenCL<NumericType>(conf, observation, dataName, observation.getNrChannels(), observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion()), integration, padding);
+    return code.release();
 }
 
 template<typename NumericType>
-std::string *getIntegrationAfterDedispersionInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
+std::string getIntegrationAfterDedispersionInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int integration, const unsigned int padding)
 {
     unsigned int nrDMs = 0;
 
@@ -400,79 +3170,355 @@ std::string *getIntegrationAfterDedispersionInPlaceOpenCL(const integrationConf
 }
 
 template<typename NumericType>
-std::string *getIntegrationInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int dimOneSize, const unsigned int dimZeroSize, const unsigned int integration, const unsigned int padding)
+std::string getIntegrationInPlaceOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int dimOneSize, const unsigned int dimZeroSize, const unsigned int integration, const unsigned int padding)
 {
-    std::string *code = new std::string();
+    if (conf.getInPlaceVariant() == integrationInPlaceVariant::Registers)
+    {
+        return getIntegrationInPlaceRegistersOpenCL<NumericType>(conf, observation, dataName, dimOneSize, dimZeroSize, integration, padding);
+    }
+    else if (conf.getInPlaceVariant() == integrationInPlaceVariant::MultiPass)
+    {
+        return getIntegrationInPlaceMultiPassOpenCL<NumericType>(conf, observation, dataName, dimOneSize, dimZeroSize, integration, padding);
+    }
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<NumericType>();
+    const std::string average = getIntegrationAverageOpenCL<NumericType>("integratedSample<%NUM%>", integration);
+    const unsigned int vectorWidth = getIntegrationInPlaceVectorWidth(conf, dimZeroSize, integration);
+    const unsigned int nrChunks = static_cast<unsigned int>(std::ceil(static_cast<float>(dimZeroSize) / (conf.getNrThreadsD0() * conf.getNrItemsD0() * integration)));
+    const std::string statisticsName = getIntegrationDataName<typename integrationTypes<NumericType>::statistics>();
+    kernelSourceBuilder code;
+
     // Begin kernel's template
-    *code = "__kernel void integration" + std::to_string(integration) + "(__global " + dataName + " * const restrict data) {\n"
-    "__local " + dataName + " buffer[" + std::to_string(conf.getNrThreadsD0() * conf.getNrItemsD0() * integration) + "];\n"
-    "for ( " + conf.getIntType() + " chunk = 0; chunk < " + std::to_string(static_cast<unsigned int>(std::ceil(static_cast<float>(dimZeroSize) / (conf.getNrThreadsD0() * conf.getNrItemsD0() * integration)))) + "; chunk++ ) {\n"
-    "// Load samples in local memory\n"
-    "<%DEFS%>"
-    + conf.getIntType() + " inGlobalMemory = (get_group_id(2) * " + std::to_string(dimOneSize * isa::utils::pad(dimZeroSize, padding / sizeof(NumericType))) + ") + (get_group_id(1) * " + std::to_string(isa::utils::pad(dimZeroSize, padding / sizeof(NumericType))) + ") + (chunk * " + std::to_string(conf.getNrThreadsD0() * conf.getNrItemsD0() * integration) + ");\n"
-    "for ( " + conf.getIntType() + " item = get_local_id(0); (item < " + std::to_string(conf.getNrThreadsD0() * conf.getNrItemsD0() * integration) + ") && (item + (chunk * " + std::to_string(conf.getNrThreadsD0() * conf.getNrItemsD0() * integration) + ") < " + std::to_string(dimZeroSize) + "); item += " + std::to_string(conf.getNrThreadsD0()) + " ) {\n"
-    "buffer[item] = data[inGlobalMemory + item];\n"
-    "}\n"
+    code << "__kernel void integration" << integration << "(__global " << dataName << " * const restrict data";
+    if (conf.getStatistics())
+    {
+        code << ", __global " << statisticsName << " * const restrict statistics";
+    }
+    code << ") {\n"
+    "__local " << dataName << " buffer[" << conf.getNrThreadsD0() * conf.getNrItemsD0() * integration << "];\n";
+    if (conf.getStatistics())
+    {
+        code << getIntegrationStatisticsLocalOpenCL(statisticsName, conf.getNrThreadsD0()) << getIntegrationStatisticsDeclarationOpenCL(statisticsName);
+    }
+    code << "for ( " << conf.getIntType() << " chunk = 0; chunk < " << nrChunks << "; chunk++ ) {\n"
+    "// Load samples in local memory\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        code << accumulatorName << " integratedSample" << sample << " = 0;\n";
+    }
+    code << conf.getIntType() << " inGlobalMemory = (get_group_id(2) * " << dimOneSize * isa::utils::pad(dimZeroSize, padding / sizeof(NumericType)) << ") + (get_group_id(1) * " << isa::utils::pad(dimZeroSize, padding / sizeof(NumericType)) << ") + (chunk * " << conf.getNrThreadsD0() * conf.getNrItemsD0() * integration << ");\n"
+    "for ( " << conf.getIntType() << " item = get_local_id(0)";
+    if (vectorWidth > 1)
+    {
+        // Samples are copied to local memory vectorWidth at a time
+        code << " * " << vectorWidth;
+    }
+    code << "; (item < " << conf.getNrThreadsD0() * conf.getNrItemsD0() * integration << ") && (item + (chunk * " << conf.getNrThreadsD0() * conf.getNrItemsD0() * integration << ") < " << dimZeroSize << "); item += " << conf.getNrThreadsD0() * vectorWidth << " ) {\n";
+    if (vectorWidth > 1)
+    {
+        code << "vstore" << vectorWidth << "(vload" << vectorWidth << "(0, data + inGlobalMemory + item), 0, buffer + item);\n";
+    }
+    else
+    {
+        code << "buffer[item] = data[inGlobalMemory + item];\n";
+    }
+    code << "}\n"
     "barrier(CLK_LOCAL_MEM_FENCE);\n"
     "// Integrate samples\n"
-    "for ( " + conf.getIntType() + " item = 0; item < " + std::to_string(integration) + "; item++ ) {\n"
-    "<%SUMS%>"
-    "}\n"
+    "for ( " << conf.getIntType() << " item = 0; item < " << integration << "; item++ ) {\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        code << "integratedSample" << sample << " += buffer[(get_local_id(0) * " << integration << ")";
+        code.appendOffset(sample * integration * conf.getNrThreadsD0()) << " + item];\n";
+    }
+    code << "}\n"
     "// Store integrated data\n"
-    "inGlobalMemory = (get_group_id(2) * " + std::to_string(dimOneSize * isa::utils::pad(dimZeroSize, padding / sizeof(NumericType))) + ") + (get_group_id(1) * " + std::to_string(isa::utils::pad(dimZeroSize, padding / sizeof(NumericType))) + ") + (chunk * " + std::to_string(conf.getNrThreadsD0() * conf.getNrItemsD0()) + ");\n"
-    "<%STORES%>"
-    "}\n"
+    "inGlobalMemory = (get_group_id(2) * " << dimOneSize * isa::utils::pad(dimZeroSize, padding / sizeof(NumericType)) << ") + (get_group_id(1) * " << isa::utils::pad(dimZeroSize, padding / sizeof(NumericType)) << ") + (chunk * " << conf.getNrThreadsD0() * conf.getNrItemsD0() << ");\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        if (conf.getStatistics())
+        {
+            code << dataName << " integratedAverage" << sample << " = ";
+            code.appendReplaced(average, "<%NUM%>", sample) << ";\n"
+            "data[inGlobalMemory + get_local_id(0)";
+            code.appendOffset(sample * conf.getNrThreadsD0()) << "] = integratedAverage" << sample << ";\n";
+            // The last chunk can go past the integrated samples of the row
+            if (nrChunks * conf.getNrThreadsD0() * conf.getNrItemsD0() > dimZeroSize / integration)
+            {
+                code << "if ( (chunk * " << conf.getNrThreadsD0() * conf.getNrItemsD0() << ") + get_local_id(0)";
+                code.appendOffset(sample * conf.getNrThreadsD0()) << " < " << dimZeroSize / integration << " ) ";
+            }
+            code << "{\n"
+            << statisticsName << " statisticsValue = integratedAverage" << sample << ";\n"
+            << getIntegrationStatisticsUpdateOpenCL("statisticsValue", "(chunk * " + std::to_string(conf.getNrThreadsD0() * conf.getNrItemsD0()) + ") + get_local_id(0) + " + std::to_string(sample * conf.getNrThreadsD0())) <<
+            "}\n";
+        }
+        else
+        {
+            code << "data[inGlobalMemory + get_local_id(0)";
+            code.appendOffset(sample * conf.getNrThreadsD0()) << "] = ";
+            code.appendReplaced(average, "<%NUM%>", sample) << ";\n";
+        }
+    }
+    code << "barrier(CLK_LOCAL_MEM_FENCE);\n"
     "}\n";
-    std::string defs_sTemplate = dataName + " integratedSample<%NUM%> = 0;\n";
-    std::string sum_sTemplate = "integratedSample<%NUM%> += buffer[(get_local_id(0) * " + std::to_string(integration) + ") + <%OFFSET%> + item];\n";
-    std::string store_sTemplate = "data[inGlobalMemory + get_local_id(0) + <%OFFSET%>] = integratedSample<%NUM%> / " + std::to_string(integration) + ";\n";
+    if (conf.getStatistics())
+    {
+        code << getIntegrationStatisticsReduceOpenCL(conf.getNrThreadsD0()) <<
+        "if ( get_local_id(0) == 0 ) {\n"
+        << getIntegrationStatisticsStoreOpenCL("(get_group_id(2) * " + std::to_string(dimOneSize) + ") + get_group_id(1)") <<
+        "}\n";
+    }
+    code << "}\n";
     // End kernel's template
 
-    std::string *defs_s = new std::string();
-    std::string *sum_s = new std::string();
-    std::string *store_s = new std::string();
+    return code.release();
+}
+
+template<typename NumericType>
+std::string getIntegrationInPlaceRegistersOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int dimOneSize, const unsigned int dimZeroSize, const unsigned int integration, const unsigned int padding)
+{
+    typedef typename integrationAccumulator<NumericType>::type Accumulator;
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<NumericType>();
+    const unsigned int vectorWidth = getIntegrationInPlaceVectorWidth(conf, dimZeroSize, integration);
+    const std::string vectorName = getIntegrationVectorDataName(accumulatorName, vectorWidth);
+    const unsigned int nrOutputSamples = dimZeroSize / integration;
+    // The last chunk has fewer than nrItemsD0 windows
+    const bool partialChunk = (nrOutputSamples % conf.getNrItemsD0()) != 0;
+    const std::string statisticsName = getIntegrationDataName<typename integrationTypes<NumericType>::statistics>();
+    const std::string rowOffset = "(get_group_id(2) * " + std::to_string(dimOneSize * isa::utils::pad(dimZeroSize, padding / sizeof(NumericType))) + ") + (get_group_id(1) * " + std::to_string(isa::utils::pad(dimZeroSize, padding / sizeof(NumericType))) + ")";
+    kernelSourceBuilder code;
 
+    // Begin kernel's template
+    code << "__kernel void integration" << integration << "(__global " << dataName << " * const restrict data";
+    if (conf.getStatistics())
+    {
+        code << ", __global " << statisticsName << " * const restrict statistics";
+    }
+    code << ") {\n"
+    "__local " << accumulatorName << " buffer[" << conf.getNrThreadsD0() * conf.getNrItemsD0() << "];\n";
+    if (conf.getStatistics())
+    {
+        code << getIntegrationStatisticsLocalOpenCL(statisticsName, conf.getNrThreadsD0()) << getIntegrationStatisticsDeclarationOpenCL(statisticsName);
+    }
+    code << "for ( " << conf.getIntType() << " chunk = 0; chunk < " << (nrOutputSamples + conf.getNrItemsD0() - 1) / conf.getNrItemsD0() << "; chunk++ ) {\n";
     for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
     {
-        std::string sample_s = std::to_string(sample);
-        std::string offset_s = std::to_string(sample * integration * conf.getNrThreadsD0());
-        std::string * temp = nullptr;
-
-        temp = isa::utils::replace(&defs_sTemplate, "<%NUM%>", sample_s);
-        defs_s->append(*temp);
-        delete temp;
-        temp = isa::utils::replace(&sum_sTemplate, "<%NUM%>", sample_s);
-        if (sample == 0)
+        code << accumulatorName << " integratedSample" << sample << " = 0;\n";
+    }
+    code << conf.getIntType() << " inGlobalMemory = " << rowOffset << " + (chunk * " << conf.getNrItemsD0() * integration << ");\n";
+    if (vectorWidth > 1)
+    {
+        // Every work-item loads vectorWidth contiguous samples at once, and adds their elements at the end
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
         {
-            temp = isa::utils::replace(temp, " + <%OFFSET%>", "", true);
+            code << vectorName << " integratedVector" << sample << " = 0;\n";
         }
-        else
+        code << "// Integrate samples, consecutive work-items read consecutive samples of each window\n"
+        "for ( " << conf.getIntType() << " sample = get_local_id(0) * " << vectorWidth << "; sample < " << integration << "; sample += " << conf.getNrThreadsD0() * vectorWidth << " ) {\n";
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+        {
+            if (partialChunk)
+            {
+                code << "if ( (chunk * " << conf.getNrItemsD0() << ")";
+                code.appendOffset(sample) << " < " << nrOutputSamples << " ) ";
+            }
+            code << "integratedVector" << sample << " += ";
+            if (!std::is_same<NumericType, Accumulator>::value)
+            {
+                code << "convert_" << vectorName;
+            }
+            code << "(vload" << vectorWidth << "(0, data + inGlobalMemory + sample";
+            code.appendOffset(sample * integration) << "));\n";
+        }
+        code << "}\n";
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+        {
+            code << "integratedSample" << sample << " = integratedVector" << sample << ".s0";
+            for (unsigned int item = 1; item < vectorWidth; item++)
+            {
+                code << " + integratedVector" << sample << ".s" << std::string(1, "0123456789abcdef"[item]);
+            }
+            code << ";\n";
+        }
+    }
+    else
+    {
+        code << "// Integrate samples, consecutive work-items read consecutive samples of each window\n"
+        "for ( " << conf.getIntType() << " sample = get_local_id(0); sample < " << integration << "; sample += " << conf.getNrThreadsD0() << " ) {\n";
+        for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
         {
-            temp = isa::utils::replace(temp, "<%OFFSET%>", offset_s, true);
+            if (partialChunk)
+            {
+                code << "if ( (chunk * " << conf.getNrItemsD0() << ")";
+                code.appendOffset(sample) << " < " << nrOutputSamples << " ) ";
+            }
+            code << "integratedSample" << sample << " += data[inGlobalMemory + sample";
+            code.appendOffset(sample * integration) << "];\n";
         }
-        sum_s->append(*temp);
-        delete temp;
-        temp = isa::utils::replace(&store_sTemplate, "<%NUM%>", sample_s);
-        offset_s = std::to_string(sample * conf.getNrThreadsD0());
-        if (sample == 0)
+        code << "}\n";
+    }
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        code << "buffer[get_local_id(0)";
+        code.appendOffset(sample * conf.getNrThreadsD0()) << "] = integratedSample" << sample << ";\n";
+    }
+    code << "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "// Reduce\n"
+    << conf.getIntType() << " threshold = " << conf.getNrThreadsD0() / 2 << ";\n"
+    "for ( " << conf.getIntType() << " sample = get_local_id(0); threshold > 0; threshold /= 2 ) {\n"
+    "if ( sample < threshold ) {\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        code << "integratedSample" << sample << " += buffer[(sample";
+        code.appendOffset(sample * conf.getNrThreadsD0()) << ") + threshold];\n"
+        "buffer[sample";
+        code.appendOffset(sample * conf.getNrThreadsD0()) << "] = integratedSample" << sample << ";\n";
+    }
+    code << "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "}\n"
+    "// Store integrated data, all the samples of the chunk have been read\n"
+    "inGlobalMemory = " << rowOffset << " + (chunk * " << conf.getNrItemsD0() << ");\n"
+    "if ( get_local_id(0) < " << conf.getNrItemsD0();
+    if (partialChunk)
+    {
+        code << " && (chunk * " << conf.getNrItemsD0() << ") + get_local_id(0) < " << nrOutputSamples;
+    }
+    code << " ) {\n";
+    if (conf.getStatistics())
+    {
+        code << dataName << " integratedAverage = " << getIntegrationAverageOpenCL<NumericType>("buffer[get_local_id(0) * " + std::to_string(conf.getNrThreadsD0()) + "]", integration) << ";\n"
+        "data[inGlobalMemory + get_local_id(0)] = integratedAverage;\n"
+        << statisticsName << " statisticsValue = integratedAverage;\n"
+        << getIntegrationStatisticsUpdateOpenCL("statisticsValue", "(chunk * " + std::to_string(conf.getNrItemsD0()) + ") + get_local_id(0)");
+    }
+    else
+    {
+        code << "data[inGlobalMemory + get_local_id(0)] = " << getIntegrationAverageOpenCL<NumericType>("buffer[get_local_id(0) * " + std::to_string(conf.getNrThreadsD0()) + "]", integration) << ";\n";
+    }
+    code << "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "}\n";
+    if (conf.getStatistics())
+    {
+        code << getIntegrationStatisticsReduceOpenCL(conf.getNrThreadsD0()) <<
+        "if ( get_local_id(0) == 0 ) {\n"
+        << getIntegrationStatisticsStoreOpenCL("(get_group_id(2) * " + std::to_string(dimOneSize) + ") + get_group_id(1)") <<
+        "}\n";
+    }
+    code << "}\n";
+    // End kernel's template
+
+    return code.release();
+}
+
+template<typename NumericType>
+std::string getIntegrationInPlaceMultiPassOpenCL(const integrationConf &conf, const AstroData::Observation &observation, const std::string &dataName, const unsigned int dimOneSize, const unsigned int dimZeroSize, const unsigned int integration, const unsigned int padding)
+{
+    const std::string accumulatorName = getIntegrationAccumulatorDataName<NumericType>();
+    const std::string average = getIntegrationAverageOpenCL<NumericType>("integratedSample<%NUM%>", integration);
+    const unsigned int vectorWidth = getIntegrationInPlaceVectorWidth(conf, dimZeroSize, integration);
+    const unsigned int nrPasses = ((conf.getNrPasses() > 0) && ((integration % conf.getNrPasses()) == 0)) ? conf.getNrPasses() : 1;
+    const unsigned int slice = integration / nrPasses;
+    const unsigned int chunkSize = conf.getNrThreadsD0() * conf.getNrItemsD0() * integration;
+    const std::string statisticsName = getIntegrationDataName<typename integrationTypes<NumericType>::statistics>();
+    const std::string rowOffset = "(get_group_id(2) * " + std::to_string(dimOneSize * isa::utils::pad(dimZeroSize, padding / sizeof(NumericType))) + ") + (get_group_id(1) * " + std::to_string(isa::utils::pad(dimZeroSize, padding / sizeof(NumericType))) + ")";
+    kernelSourceBuilder code;
+
+    // Begin kernel's template
+    code << "__kernel void integration" << integration << "(__global " << dataName << " * const restrict data";
+    if (conf.getStatistics())
+    {
+        code << ", __global " << statisticsName << " * const restrict statistics";
+    }
+    code << ") {\n"
+    "__local " << dataName << " buffer[" << conf.getNrThreadsD0() * conf.getNrItemsD0() * slice << "];\n";
+    if (conf.getStatistics())
+    {
+        code << getIntegrationStatisticsLocalOpenCL(statisticsName, conf.getNrThreadsD0()) << getIntegrationStatisticsDeclarationOpenCL(statisticsName);
+    }
+    code << "for ( " << conf.getIntType() << " chunk = 0; chunk < " << (dimZeroSize + chunkSize - 1) / chunkSize << "; chunk++ ) {\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        code << accumulatorName << " integratedSample" << sample << " = 0;\n";
+    }
+    code << conf.getIntType() << " inGlobalMemory = " << rowOffset << " + (chunk * " << chunkSize << ");\n"
+    "for ( " << conf.getIntType() << " pass = 0; pass < " << nrPasses << "; pass++ ) {\n"
+    "// Load one slice of every window in local memory\n"
+    "for ( " << conf.getIntType() << " item = get_local_id(0)";
+    if (vectorWidth > 1)
+    {
+        // Slices are copied to local memory vectorWidth samples at a time
+        code << " * " << vectorWidth;
+    }
+    code << "; item < " << conf.getNrThreadsD0() * conf.getNrItemsD0() * slice << "; item += " << conf.getNrThreadsD0() * vectorWidth << " ) {\n"
+    << conf.getIntType() << " sample = ((item / " << slice << ") * " << integration << ") + (pass * " << slice << ") + (item % " << slice << ");\n";
+    if ((dimZeroSize % chunkSize) != 0)
+    {
+        code << "if ( (chunk * " << chunkSize << ") + sample >= " << dimZeroSize << " ) {\n"
+        "break;\n"
+        "}\n";
+    }
+    if (vectorWidth > 1)
+    {
+        code << "vstore" << vectorWidth << "(vload" << vectorWidth << "(0, data + inGlobalMemory + sample), 0, buffer + item);\n";
+    }
+    else
+    {
+        code << "buffer[item] = data[inGlobalMemory + sample];\n";
+    }
+    code << "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "// Integrate the slice\n"
+    "for ( " << conf.getIntType() << " item = 0; item < " << slice << "; item++ ) {\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        code << "integratedSample" << sample << " += buffer[(get_local_id(0) * " << slice << ")";
+        code.appendOffset(sample * slice * conf.getNrThreadsD0()) << " + item];\n";
+    }
+    code << "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "}\n"
+    "// Store integrated data\n"
+    "inGlobalMemory = " << rowOffset << " + (chunk * " << conf.getNrThreadsD0() * conf.getNrItemsD0() << ");\n";
+    for (unsigned int sample = 0; sample < conf.getNrItemsD0(); sample++)
+    {
+        if (conf.getStatistics())
         {
-            temp = isa::utils::replace(temp, " + <%OFFSET%>", "", true);
+            code << dataName << " integratedAverage" << sample << " = ";
+            code.appendReplaced(average, "<%NUM%>", sample) << ";\n"
+            "data[inGlobalMemory + get_local_id(0)";
+            code.appendOffset(sample * conf.getNrThreadsD0()) << "] = integratedAverage" << sample << ";\n";
+            // The last chunk can go past the integrated samples of the row
+            if (((dimZeroSize + chunkSize - 1) / chunkSize) * conf.getNrThreadsD0() * conf.getNrItemsD0() > dimZeroSize / integration)
+            {
+                code << "if ( (chunk * " << conf.getNrThreadsD0() * conf.getNrItemsD0() << ") + get_local_id(0)";
+                code.appendOffset(sample * conf.getNrThreadsD0()) << " < " << dimZeroSize / integration << " ) ";
+            }
+            code << "{\n"
+            << statisticsName << " statisticsValue = integratedAverage" << sample << ";\n"
+            << getIntegrationStatisticsUpdateOpenCL("statisticsValue", "(chunk * " + std::to_string(conf.getNrThreadsD0() * conf.getNrItemsD0()) + ") + get_local_id(0) + " + std::to_string(sample * conf.getNrThreadsD0())) <<
+            "}\n";
         }
         else
         {
-            temp = isa::utils::replace(temp, "<%OFFSET%>", offset_s, true);
+            code << "data[inGlobalMemory + get_local_id(0)";
+            code.appendOffset(sample * conf.getNrThreadsD0()) << "] = ";
+            code.appendReplaced(average, "<%NUM%>", sample) << ";\n";
         }
-        store_s->append(*temp);
-        delete temp;
     }
-    code = isa::utils::replace(code, "<%DEFS%>", *defs_s, true);
-    code = isa::utils::replace(code, "<%SUMS%>", *sum_s, true);
-    code = isa::utils::replace(code, "<%STORES%>", *store_s, true);
-    delete defs_s;
-    delete sum_s;
-    delete store_s;
+    code << "}\n";
+    if (conf.getStatistics())
+    {
+        code << getIntegrationStatisticsReduceOpenCL(conf.getNrThreadsD0()) <<
+        "if ( get_local_id(0) == 0 ) {\n"
+        << getIntegrationStatisticsStoreOpenCL("(get_group_id(2) * " + std::to_string(dimOneSize) + ") + get_group_id(1)") <<
+        "}\n";
+    }
+    code << "}\n";
+    // End kernel's template
 
-    return code;
+    return code.release();
 }
 
 } // namespace Integration
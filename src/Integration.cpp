@@ -15,86 +15,1927 @@
 
 #include <Integration.hpp>
 
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <tuple>
+#include <iterator>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <random>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define INTEGRATION_X86
+#endif
+
 namespace Integration {
 
-integrationConf::integrationConf() : KernelConf(), subbandDedispersion(false) {}
+namespace {
+
+enum class vectorISA { Scalar, AVX2, AVX512 };
+
+vectorISA getVectorISA() {
+#ifdef INTEGRATION_X86
+  if ( __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") ) {
+    return vectorISA::AVX512;
+  } else if ( __builtin_cpu_supports("avx2") ) {
+    return vectorISA::AVX2;
+  }
+#endif
+  return vectorISA::Scalar;
+}
+
+// Number of DMs accumulated at the same time by the vectorized samples-DMs implementation, the accumulators are kept in L1
+const unsigned int samplesDMsTile = 1024;
+
+void integrateSamplesDMsTile(const float * input, const uint64_t rowSize, const unsigned int integration, const unsigned int tile, float * integratedSamples, float * output) {
+  std::fill(integratedSamples, integratedSamples + tile, 0.0f);
+  for ( unsigned int i = 0; i < integration; i++ ) {
+    const float * inputRow = input + (i * rowSize);
+
+    for ( unsigned int dm = 0; dm < tile; dm++ ) {
+      integratedSamples[dm] += inputRow[dm];
+    }
+  }
+  for ( unsigned int dm = 0; dm < tile; dm++ ) {
+    output[dm] = integrationAverage< float >(integratedSamples[dm], integration);
+  }
+}
+
+#ifdef INTEGRATION_X86
+__attribute__((target("avx2")))
+void integrateSamplesDMsTileAVX2(const float * input, const uint64_t rowSize, const unsigned int integration, const unsigned int tile, float * integratedSamples, float * output) {
+  const unsigned int vectorTile = tile - (tile % 8);
+  const __m256 factor = _mm256_set1_ps(1.0f / integration);
+
+  for ( unsigned int dm = 0; dm < vectorTile; dm += 8 ) {
+    _mm256_storeu_ps(integratedSamples + dm, _mm256_setzero_ps());
+  }
+  for ( unsigned int dm = vectorTile; dm < tile; dm++ ) {
+    integratedSamples[dm] = 0.0f;
+  }
+  for ( unsigned int i = 0; i < integration; i++ ) {
+    const float * inputRow = input + (i * rowSize);
+
+    for ( unsigned int dm = 0; dm < vectorTile; dm += 8 ) {
+      _mm256_storeu_ps(integratedSamples + dm, _mm256_add_ps(_mm256_loadu_ps(integratedSamples + dm), _mm256_loadu_ps(inputRow + dm)));
+    }
+    for ( unsigned int dm = vectorTile; dm < tile; dm++ ) {
+      integratedSamples[dm] += inputRow[dm];
+    }
+  }
+  for ( unsigned int dm = 0; dm < vectorTile; dm += 8 ) {
+    _mm256_storeu_ps(output + dm, _mm256_mul_ps(_mm256_loadu_ps(integratedSamples + dm), factor));
+  }
+  for ( unsigned int dm = vectorTile; dm < tile; dm++ ) {
+    output[dm] = integrationAverage< float >(integratedSamples[dm], integration);
+  }
+}
+
+__attribute__((target("avx512f")))
+void integrateSamplesDMsTileAVX512(const float * input, const uint64_t rowSize, const unsigned int integration, const unsigned int tile, float * integratedSamples, float * output) {
+  const unsigned int vectorTile = tile - (tile % 16);
+  const __m512 factor = _mm512_set1_ps(1.0f / integration);
+
+  for ( unsigned int dm = 0; dm < vectorTile; dm += 16 ) {
+    _mm512_storeu_ps(integratedSamples + dm, _mm512_setzero_ps());
+  }
+  for ( unsigned int dm = vectorTile; dm < tile; dm++ ) {
+    integratedSamples[dm] = 0.0f;
+  }
+  for ( unsigned int i = 0; i < integration; i++ ) {
+    const float * inputRow = input + (i * rowSize);
+
+    for ( unsigned int dm = 0; dm < vectorTile; dm += 16 ) {
+      _mm512_storeu_ps(integratedSamples + dm, _mm512_add_ps(_mm512_loadu_ps(integratedSamples + dm), _mm512_loadu_ps(inputRow + dm)));
+    }
+    for ( unsigned int dm = vectorTile; dm < tile; dm++ ) {
+      integratedSamples[dm] += inputRow[dm];
+    }
+  }
+  for ( unsigned int dm = 0; dm < vectorTile; dm += 16 ) {
+    _mm512_storeu_ps(output + dm, _mm512_mul_ps(_mm512_loadu_ps(integratedSamples + dm), factor));
+  }
+  for ( unsigned int dm = vectorTile; dm < tile; dm++ ) {
+    output[dm] = integrationAverage< float >(integratedSamples[dm], integration);
+  }
+}
+#endif // INTEGRATION_X86
+
+// Sum groups of groupSize consecutive 8 bit samples into 32 bit partial sums
+void partialSumsBeforeDedispersion(const uint8_t * input, const unsigned int nrSamples, const unsigned int groupSize, uint32_t * partials) {
+  for ( unsigned int group = 0; group < nrSamples / groupSize; group++ ) {
+    uint32_t partial = 0;
+
+    for ( unsigned int sample = 0; sample < groupSize; sample++ ) {
+      partial += input[(group * groupSize) + sample];
+    }
+    partials[group] = partial;
+  }
+}
+
+#ifdef INTEGRATION_X86
+__attribute__((target("avx2")))
+void partialSumsBeforeDedispersionAVX2(const uint8_t * input, const unsigned int nrSamples, const unsigned int groupSize, uint32_t * partials) {
+  const unsigned int vectorSamples = nrSamples - (nrSamples % 32);
+  const __m256i zeros = _mm256_setzero_si256();
+  const __m256i ones8 = _mm256_set1_epi8(1);
+  const __m256i ones16 = _mm256_set1_epi16(1);
+  const __m256i evenLanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+  for ( unsigned int sample = 0; sample < vectorSamples; sample += 32 ) {
+    const __m256i samples = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(input + sample));
+
+    if ( groupSize == 8 ) {
+      // Sums of 8 samples in the low 16 bits of each 64 bit lane
+      const __m256i sums = _mm256_permutevar8x32_epi32(_mm256_sad_epu8(samples, zeros), evenLanes);
+
+      _mm_storeu_si128(reinterpret_cast< __m128i * >(partials + (sample / 8)), _mm256_castsi256_si128(sums));
+    } else if ( groupSize == 4 ) {
+      const __m256i sums = _mm256_madd_epi16(_mm256_maddubs_epi16(samples, ones8), ones16);
+
+      _mm256_storeu_si256(reinterpret_cast< __m256i * >(partials + (sample / 4)), sums);
+    } else {
+      const __m256i sums = _mm256_maddubs_epi16(samples, ones8);
+
+      _mm256_storeu_si256(reinterpret_cast< __m256i * >(partials + (sample / 2)), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(sums)));
+      _mm256_storeu_si256(reinterpret_cast< __m256i * >(partials + (sample / 2) + 8), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(sums, 1)));
+    }
+  }
+  partialSumsBeforeDedispersion(input + vectorSamples, nrSamples - vectorSamples, groupSize, partials + (vectorSamples / groupSize));
+}
+
+// GCC reports the undefined upper lanes used inside the AVX-512 conversion intrinsics as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f,avx512bw")))
+void partialSumsBeforeDedispersionAVX512(const uint8_t * input, const unsigned int nrSamples, const unsigned int groupSize, uint32_t * partials) {
+  const unsigned int vectorSamples = nrSamples - (nrSamples % 64);
+  const __m512i zeros = _mm512_setzero_si512();
+  const __m512i ones8 = _mm512_set1_epi8(1);
+  const __m512i ones16 = _mm512_set1_epi16(1);
+
+  for ( unsigned int sample = 0; sample < vectorSamples; sample += 64 ) {
+    const __m512i samples = _mm512_loadu_si512(input + sample);
+
+    if ( groupSize == 8 ) {
+      // Sums of 8 samples in the low 16 bits of each 64 bit lane
+      const __m256i sums = _mm512_cvtepi64_epi32(_mm512_sad_epu8(samples, zeros));
+
+      _mm256_storeu_si256(reinterpret_cast< __m256i * >(partials + (sample / 8)), sums);
+    } else if ( groupSize == 4 ) {
+      const __m512i sums = _mm512_madd_epi16(_mm512_maddubs_epi16(samples, ones8), ones16);
+
+      _mm512_storeu_si512(partials + (sample / 4), sums);
+    } else {
+      const __m512i sums = _mm512_maddubs_epi16(samples, ones8);
+
+      _mm512_storeu_si512(partials + (sample / 2), _mm512_cvtepu16_epi32(_mm512_castsi512_si256(sums)));
+      _mm512_storeu_si512(partials + (sample / 2) + 16, _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(sums, 1)));
+    }
+  }
+  partialSumsBeforeDedispersion(input + vectorSamples, nrSamples - vectorSamples, groupSize, partials + (vectorSamples / groupSize));
+}
+#pragma GCC diagnostic pop
+#endif // INTEGRATION_X86
+
+} // namespace
+
+integrationConf::integrationConf() : KernelConf(), intTypeCode(0), subbandDedispersion(false), subgroupReduction(false), vectorWidth(1), inPlaceVariant(integrationInPlaceVariant::LocalMemory), nrPasses(1), statistics(false), maxCandidates(0) {}
+
+integrationConf::~integrationConf() {}
+
+std::string integrationConf::print() const {
+  return std::to_string(subbandDedispersion) + " " + isa::OpenCL::KernelConf::print() + " " + std::to_string(subgroupReduction) + " " + std::to_string(vectorWidth) + " " + std::to_string(static_cast< unsigned int >(inPlaceVariant)) + " " + std::to_string(nrPasses);
+}
+
+integrationCPUConf::integrationCPUConf() : nrThreads(0), dynamicScheduling(false), chunkSize(0) {}
+
+integrationCPUConf::~integrationCPUConf() {}
+
+std::string integrationCPUConf::print() const {
+  return std::to_string(nrThreads) + " " + std::to_string(dynamicScheduling) + " " + std::to_string(chunkSize);
+}
+
+threadPool::threadPool(const unsigned int nrThreads) : stop(false), generation(0), activeWorkers(0), function(nullptr), nrItems(0), chunkSize(0), nrChunks(0), dynamicScheduling(false), nextChunk(0) {
+  unsigned int nrWorkers = nrThreads;
+
+  if ( nrWorkers == 0 ) {
+    nrWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  for ( unsigned int id = 0; id < nrWorkers; id++ ) {
+    threads.emplace_back(&threadPool::worker, this, id);
+  }
+}
+
+threadPool::~threadPool() {
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    stop = true;
+  }
+  wakeUp.notify_all();
+  for ( auto & thread : threads ) {
+    thread.join();
+  }
+}
+
+void threadPool::parallelFor(const integrationCPUConf & conf, const unsigned int nrItems, const std::function< void(unsigned int, unsigned int) > & function) {
+  if ( nrItems == 0 ) {
+    return;
+  }
+  std::lock_guard< std::mutex > submitLock(submitMutex);
+  std::unique_lock< std::mutex > lock(mutex);
+
+  this->function = &function;
+  this->nrItems = nrItems;
+  if ( conf.getChunkSize() > 0 ) {
+    chunkSize = conf.getChunkSize();
+  } else {
+    chunkSize = (nrItems + threads.size() - 1) / threads.size();
+  }
+  nrChunks = (nrItems + chunkSize - 1) / chunkSize;
+  dynamicScheduling = conf.getDynamicScheduling();
+  nextChunk = 0;
+  error = nullptr;
+  activeWorkers = threads.size();
+  generation++;
+  wakeUp.notify_all();
+  done.wait(lock, [this] { return activeWorkers == 0; });
+  this->function = nullptr;
+  if ( error ) {
+    std::rethrow_exception(error);
+  }
+}
+
+void threadPool::worker(const unsigned int id) {
+  uint64_t lastGeneration = 0;
+
+  while ( true ) {
+    {
+      std::unique_lock< std::mutex > lock(mutex);
+
+      wakeUp.wait(lock, [this, lastGeneration] { return stop || (generation != lastGeneration); });
+      if ( stop ) {
+        return;
+      }
+      lastGeneration = generation;
+    }
+    try {
+      if ( dynamicScheduling ) {
+        for ( unsigned int chunk = nextChunk++; chunk < nrChunks; chunk = nextChunk++ ) {
+          (*function)(chunk * chunkSize, std::min(nrItems, (chunk + 1) * chunkSize));
+        }
+      } else {
+        for ( unsigned int chunk = id; chunk < nrChunks; chunk += threads.size() ) {
+          (*function)(chunk * chunkSize, std::min(nrItems, (chunk + 1) * chunkSize));
+        }
+      }
+    } catch ( ... ) {
+      std::lock_guard< std::mutex > lock(mutex);
+
+      if ( !error ) {
+        error = std::current_exception();
+      }
+    }
+    {
+      std::lock_guard< std::mutex > lock(mutex);
+
+      activeWorkers--;
+      if ( activeWorkers == 0 ) {
+        done.notify_one();
+      }
+    }
+  }
+}
+
+template <>
+void integrationSamplesDMsVectorized< float >(const bool subbandDedispersion, const AstroData::Observation & observation, const unsigned int integration, const unsigned int padding, const std::vector< float > & input, std::vector< float > & output) {
+  unsigned int nrDMs = 0;
+  void (* integrateTile)(const float *, const uint64_t, const unsigned int, const unsigned int, float *, float *) = integrateSamplesDMsTile;
+  float integratedSamples[samplesDMsTile];
+
+  if ( subbandDedispersion ) {
+    nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+  } else {
+    nrDMs = observation.getNrDMs();
+  }
+#ifdef INTEGRATION_X86
+  if ( getVectorISA() == vectorISA::AVX512 ) {
+    integrateTile = integrateSamplesDMsTileAVX512;
+  } else if ( getVectorISA() == vectorISA::AVX2 ) {
+    integrateTile = integrateSamplesDMsTileAVX2;
+  }
+#endif
+  const uint64_t rowSize = isa::utils::pad(nrDMs, padding / sizeof(float));
+
+  for ( unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++ ) {
+    for ( unsigned int sample = 0; sample + integration <= observation.getNrSamplesPerBatch(); sample += integration ) {
+      for ( unsigned int firstDM = 0; firstDM < nrDMs; firstDM += samplesDMsTile ) {
+        const float * inputTile = &input[(beam * observation.getNrSamplesPerBatch() * rowSize) + (sample * rowSize) + firstDM];
+        float * outputTile = &output[(beam * (observation.getNrSamplesPerBatch() / integration) * rowSize) + ((sample / integration) * rowSize) + firstDM];
+
+        integrateTile(inputTile, rowSize, integration, std::min(samplesDMsTile, nrDMs - firstDM), integratedSamples, outputTile);
+      }
+    }
+  }
+}
+
+template <>
+void integrationBeforeDedispersionVectorized< uint8_t >(const AstroData::Observation & observation, const unsigned int integration, const unsigned int padding, const std::vector< uint8_t > & input, std::vector< uint8_t > & output) {
+  const unsigned int nrSamples = observation.getNrSamplesPerDispersedBatch();
+  const uint64_t inputRowSize = observation.getNrSamplesPerDispersedBatch(false, padding / sizeof(uint8_t));
+  const uint64_t outputRowSize = isa::utils::pad(nrSamples / integration, padding / sizeof(uint8_t));
+  void (* partialSums)(const uint8_t *, const unsigned int, const unsigned int, uint32_t *) = partialSumsBeforeDedispersion;
+  unsigned int groupSize = 1;
+
+  // The vectorized code sums groups of 8, 4 or 2 samples; groups are then added in the integration loop
+  if ( integration % 8 == 0 ) {
+    groupSize = 8;
+  } else if ( integration % 4 == 0 ) {
+    groupSize = 4;
+  } else if ( integration % 2 == 0 ) {
+    groupSize = 2;
+  }
+#ifdef INTEGRATION_X86
+  if ( groupSize > 1 ) {
+    if ( getVectorISA() == vectorISA::AVX512 ) {
+      partialSums = partialSumsBeforeDedispersionAVX512;
+    } else if ( getVectorISA() == vectorISA::AVX2 ) {
+      partialSums = partialSumsBeforeDedispersionAVX2;
+    }
+  }
+#endif
+  const unsigned int nrGroups = integration / groupSize;
+  std::vector< uint32_t > partials(nrSamples / groupSize);
+
+  for ( unsigned int row = 0; row < observation.getNrBeams() * observation.getNrChannels(); row++ ) {
+    const uint8_t * inputRow = &input[row * inputRowSize];
+    uint8_t * outputRow = &output[row * outputRowSize];
+
+    partialSums(inputRow, nrSamples - (nrSamples % groupSize), groupSize, partials.data());
+    for ( unsigned int sample = 0; sample + integration <= nrSamples; sample += integration ) {
+      uint32_t integratedSample = 0;
+
+      for ( unsigned int group = 0; group < nrGroups; group++ ) {
+        integratedSample += partials[(sample / groupSize) + group];
+      }
+      outputRow[sample / integration] = integrationAverage< uint8_t >(integratedSample, integration);
+    }
+  }
+}
+
+std::vector< unsigned int > getPowerOfTwoIntegrations(const unsigned int maximum) {
+  std::vector< unsigned int > integrations;
+
+  for ( unsigned int integration = 2; integration <= maximum; integration *= 2 ) {
+    integrations.push_back(integration);
+  }
+  return integrations;
+}
+
+unsigned int getNrBoxcarSamples(const AstroData::Observation & observation, const unsigned int width) {
+  if ( width > observation.getNrSamplesPerBatch() / observation.getDownsampling() ) {
+    return 0;
+  }
+  return (observation.getNrSamplesPerBatch() / observation.getDownsampling()) - width + 1;
+}
+
+bool isValidIntegrationBoxcar(const std::vector< unsigned int > & widths, const unsigned int nrSamples) {
+  if ( widths.empty() || widths.front() == 0 ) {
+    return false;
+  }
+  for ( unsigned int width = 1; width < widths.size(); width++ ) {
+    if ( widths[width] <= widths[width - 1] ) {
+      return false;
+    }
+  }
+  return widths.back() <= nrSamples;
+}
+
+bool isValidIntegrationPyramid(const std::vector< unsigned int > & integrations, const unsigned int nrSamples) {
+  if ( integrations.empty() || integrations.front() == 0 ) {
+    return false;
+  }
+  for ( unsigned int level = 1; level < integrations.size(); level++ ) {
+    if ( (integrations[level] <= integrations[level - 1]) || (integrations[level] % integrations[level - 1] != 0) ) {
+      return false;
+    }
+  }
+  return (nrSamples % integrations.back()) == 0;
+}
+
+std::string getVectorInstructionSet() {
+  switch ( getVectorISA() ) {
+    case vectorISA::AVX512:
+      return "AVX-512";
+    case vectorISA::AVX2:
+      return "AVX2";
+    default:
+      return "scalar";
+  }
+}
+
+std::string getIntegrationReciprocalOpenCL(const unsigned int integration, const bool doublePrecision) {
+  std::ostringstream literal;
+
+  // Enough significant digits for the literal to round to the same value as the reciprocal computed on the host
+  literal << std::showpoint;
+  if ( doublePrecision ) {
+    literal << std::setprecision(17) << (1.0 / integration);
+  } else {
+    literal << std::setprecision(9) << (1.0f / integration) << "f";
+  }
+  return literal.str();
+}
+
+std::string getIntegrationScalarDataName(const std::string & dataName) {
+  if ( dataName.compare(0, 9, "unsigned ") == 0 ) {
+    return "u" + dataName.substr(9);
+  } else if ( dataName.compare(0, 7, "signed ") == 0 ) {
+    return dataName.substr(7);
+  }
+  return dataName;
+}
+
+std::string getIntegrationVectorDataName(const std::string & dataName, const unsigned int width) {
+  if ( width == 1 ) {
+    return dataName;
+  }
+  return getIntegrationScalarDataName(dataName) + std::to_string(width);
+}
+
+std::string getIntegrationStatisticsDeclarationOpenCL(const std::string & statisticsName, const std::string & suffix) {
+  return statisticsName + " statisticsSum" + suffix + " = 0;\n" + statisticsName + " statisticsSumSquares" + suffix + " = 0;\n" + statisticsName + " statisticsMaximum" + suffix + " = -INFINITY;\nuint statisticsIndex" + suffix + " = 0;\n";
+}
+
+std::string getIntegrationStatisticsUpdateOpenCL(const std::string & value, const std::string & sample, const std::string & suffix) {
+  return "statisticsSum" + suffix + " += " + value + ";\n"
+    "statisticsSumSquares" + suffix + " += " + value + " * " + value + ";\n"
+    "if ( " + value + " > statisticsMaximum" + suffix + " ) {\n"
+    "statisticsMaximum" + suffix + " = " + value + ";\n"
+    "statisticsIndex" + suffix + " = " + sample + ";\n"
+    "}\n";
+}
+
+std::string getIntegrationStatisticsLocalOpenCL(const std::string & statisticsName, const unsigned int nrThreads) {
+  return "__local " + statisticsName + " statisticsBuffer[" + std::to_string(3 * nrThreads) + "];\n__local uint statisticsIndexBuffer[" + std::to_string(nrThreads) + "];\n";
+}
+
+std::string getIntegrationStatisticsReduceOpenCL(const unsigned int nrThreads) {
+  const std::string threads = std::to_string(nrThreads);
+  const std::string store = "statisticsBuffer[get_local_id(0)] = statisticsSum;\n"
+    "statisticsBuffer[get_local_id(0) + " + threads + "] = statisticsSumSquares;\n"
+    "statisticsBuffer[get_local_id(0) + " + std::to_string(2 * nrThreads) + "] = statisticsMaximum;\n"
+    "statisticsIndexBuffer[get_local_id(0)] = statisticsIndex;\n";
+
+  // Halving the number of active work-items, including odd ones, the maximum with the lowest index is kept
+  return "// Reduce statistics\n" + store +
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "for ( uint size = " + threads + "; size > 1; size = (size + 1) / 2 ) {\n"
+    "if ( get_local_id(0) < size / 2 ) {\n"
+    "uint other = get_local_id(0) + ((size + 1) / 2);\n"
+    "statisticsSum += statisticsBuffer[other];\n"
+    "statisticsSumSquares += statisticsBuffer[other + " + threads + "];\n"
+    "if ( (statisticsBuffer[other + " + std::to_string(2 * nrThreads) + "] > statisticsMaximum) || ((statisticsBuffer[other + " + std::to_string(2 * nrThreads) + "] == statisticsMaximum) && (statisticsIndexBuffer[other] < statisticsIndex)) ) {\n"
+    "statisticsMaximum = statisticsBuffer[other + " + std::to_string(2 * nrThreads) + "];\n"
+    "statisticsIndex = statisticsIndexBuffer[other];\n"
+    "}\n" + store +
+    "}\n"
+    "barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "}\n";
+}
+
+std::string getIntegrationStatisticsStoreOpenCL(const std::string & row, const std::string & suffix) {
+  return "statistics[((" + row + ") * " + std::to_string(integrationStatisticsSize) + ")] = statisticsSum" + suffix + ";\n"
+    "statistics[((" + row + ") * " + std::to_string(integrationStatisticsSize) + ") + 1] = statisticsSumSquares" + suffix + ";\n"
+    "statistics[((" + row + ") * " + std::to_string(integrationStatisticsSize) + ") + 2] = statisticsMaximum" + suffix + ";\n"
+    "statistics[((" + row + ") * " + std::to_string(integrationStatisticsSize) + ") + 3] = statisticsIndex" + suffix + ";\n";
+}
+
+std::string getIntegrationCandidatesArgumentsOpenCL() {
+  return ", __global const float * const restrict thresholds, volatile __global uint * const restrict nrCandidates, __global uint * const restrict candidates";
+}
+
+std::string getIntegrationCandidateOpenCL(const std::string & value, const std::string & beam, const std::string & dm, const std::string & sample, const std::string & row, const unsigned int maxCandidates) {
+  // The counter is incremented also when the list is full, so that the caller knows how many candidates were lost
+  return "if ( " + value + " > thresholds[" + row + "] ) {\n"
+    "uint candidate = atomic_inc(nrCandidates);\n"
+    "if ( candidate < " + std::to_string(maxCandidates) + " ) {\n"
+    "candidates[(candidate * 4)] = " + beam + ";\n"
+    "candidates[(candidate * 4) + 1] = " + dm + ";\n"
+    "candidates[(candidate * 4) + 2] = " + sample + ";\n"
+    "candidates[(candidate * 4) + 3] = as_uint((float)(" + value + "));\n"
+    "}\n"
+    "}\n";
+}
+
+uint16_t integrationFloatToHalf(const float value) {
+  uint32_t bits = 0;
+
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint32_t sign = (bits >> 16) & 0x8000;
+  const int32_t exponent = static_cast< int32_t >((bits >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits & 0x7fffff;
+
+  if ( ((bits >> 23) & 0xff) == 0xff ) {
+    // Infinity and NaN
+    return sign | 0x7c00 | ((mantissa != 0) ? 0x200 : 0);
+  } else if ( exponent >= 31 ) {
+    return sign | 0x7c00;
+  } else if ( exponent <= 0 ) {
+    // Subnormal or zero
+    if ( exponent < -10 ) {
+      return sign;
+    }
+    mantissa |= 0x800000;
+    const uint32_t shift = 14 - exponent;
+    uint32_t half = mantissa >> shift;
+    const uint32_t remainder = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+
+    if ( (remainder > halfway) || ((remainder == halfway) && ((half & 1) != 0)) ) {
+      half++;
+    }
+    return sign | half;
+  }
+  uint32_t half = (static_cast< uint32_t >(exponent) << 10) | (mantissa >> 13);
+  const uint32_t remainder = mantissa & 0x1fff;
+
+  // Round to nearest even, as vstore_half; a carry into the exponent is still correct
+  if ( (remainder > 0x1000) || ((remainder == 0x1000) && ((half & 1) != 0)) ) {
+    half++;
+  }
+  return sign | half;
+}
+
+float integrationHalfToFloat(const uint16_t value) {
+  const uint32_t sign = static_cast< uint32_t >(value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1f;
+  uint32_t mantissa = value & 0x3ff;
+  uint32_t bits = 0;
+  float result = 0.0f;
+
+  if ( exponent == 0x1f ) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if ( exponent == 0 ) {
+    if ( mantissa == 0 ) {
+      bits = sign;
+    } else {
+      // Subnormal, normalized in single precision
+      exponent = 127 - 15 + 1;
+      while ( (mantissa & 0x400) == 0 ) {
+        mantissa <<= 1;
+        exponent--;
+      }
+      bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+  } else {
+    bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+  }
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+unsigned int getIntegrationVectorWidth(const integrationMode mode, const integrationConf & conf, const AstroData::Observation & observation, const unsigned int integration) {
+  const unsigned int width = conf.getVectorWidth();
+  unsigned int nrDMs = observation.getNrDMs();
+
+  // OpenCL vector types used for loads and stores
+  if ( (width != 2) && (width != 4) && (width != 8) && (width != 16) ) {
+    return 1;
+  }
+  if ( conf.getSubbandDedispersion() ) {
+    nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+  }
+  switch ( mode ) {
+    case integrationMode::BeforeDedispersionInPlace:
+    case integrationMode::BeforeDedispersion:
+      return getIntegrationInPlaceVectorWidth(conf, observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion()), integration);
+    case integrationMode::AfterDedispersionInPlace:
+      return getIntegrationInPlaceVectorWidth(conf, observation.getNrSamplesPerBatch() / observation.getDownsampling(), integration);
+    case integrationMode::DMsSamples:
+      // A vector never spans two integrated samples
+      if ( (integration % width) == 0 ) {
+        return width;
+      }
+      break;
+    case integrationMode::SamplesDMs:
+      if ( (nrDMs % (conf.getNrThreadsD0() * conf.getNrItemsD0() * width)) == 0 ) {
+        return width;
+      }
+      break;
+  }
+  return 1;
+}
+
+unsigned int getIntegrationInPlaceVectorWidth(const integrationConf & conf, const unsigned int dimZeroSize, const unsigned int integration) {
+  const unsigned int width = conf.getVectorWidth();
+
+  if ( (width != 2) && (width != 4) && (width != 8) && (width != 16) ) {
+    return 1;
+  }
+  switch ( conf.getInPlaceVariant() ) {
+    case integrationInPlaceVariant::LocalMemory:
+      // A vector never spans two chunks or the end of a row
+      if ( ((conf.getNrThreadsD0() * conf.getNrItemsD0() * integration) % width) == 0 && (dimZeroSize % width) == 0 ) {
+        return width;
+      }
+      break;
+    case integrationInPlaceVariant::Registers:
+      // A vector never spans two integration windows
+      if ( (integration % width) == 0 ) {
+        return width;
+      }
+      break;
+    case integrationInPlaceVariant::MultiPass:
+      // A vector never spans two slices
+      if ( (conf.getNrPasses() > 0) && (integration % conf.getNrPasses()) == 0 && ((integration / conf.getNrPasses()) % width) == 0 ) {
+        return width;
+      }
+      break;
+  }
+  return 1;
+}
+
+std::string getIntegrationKernelName(const integrationMode mode, const unsigned int integration) {
+  if ( mode == integrationMode::DMsSamples ) {
+    return "integrationDMsSamples" + std::to_string(integration);
+  } else if ( mode == integrationMode::SamplesDMs ) {
+    return "integrationSamplesDMs" + std::to_string(integration);
+  } else if ( mode == integrationMode::BeforeDedispersion ) {
+    return "integrationBeforeDedispersion" + std::to_string(integration);
+  }
+  return "integration" + std::to_string(integration);
+}
+
+void getIntegrationNDRange(const integrationMode mode, const integrationConf & conf, const AstroData::Observation & observation, const unsigned int integration, cl::NDRange & global, cl::NDRange & local) {
+  switch ( mode ) {
+    case integrationMode::BeforeDedispersionInPlace:
+      global = cl::NDRange(conf.getNrThreadsD0(), observation.getNrChannels(), observation.getNrBeams());
+      break;
+    case integrationMode::AfterDedispersionInPlace:
+      global = cl::NDRange(conf.getNrThreadsD0(), observation.getNrDMs(true) * observation.getNrDMs(), observation.getNrSynthesizedBeams());
+      break;
+    case integrationMode::DMsSamples:
+      // With statistics a single work-group integrates each DM
+      if ( conf.getStatistics() ) {
+        global = cl::NDRange(conf.getNrThreadsD0(), observation.getNrDMs(true) * observation.getNrDMs(), observation.getNrSynthesizedBeams());
+      } else {
+        global = cl::NDRange(conf.getNrThreadsD0() * ((observation.getNrSamplesPerBatch() / integration) / conf.getNrItemsD0()), observation.getNrDMs(true) * observation.getNrDMs(), observation.getNrSynthesizedBeams());
+      }
+      break;
+    case integrationMode::SamplesDMs:
+      // With statistics a single work-item integrates all the samples of its DMs
+      global = cl::NDRange((observation.getNrDMs(true) * observation.getNrDMs()) / (conf.getNrItemsD0() * getIntegrationVectorWidth(mode, conf, observation, integration)), conf.getStatistics() ? 1 : observation.getNrSamplesPerBatch() / integration, observation.getNrSynthesizedBeams());
+      break;
+    case integrationMode::BeforeDedispersion: {
+      // One work-group per chunk of nrThreadsD0 * nrItemsD0 integrated samples, the last one can be partial
+      const unsigned int nrOutputSamplesPerGroup = conf.getNrThreadsD0() * conf.getNrItemsD0();
+
+      global = cl::NDRange(conf.getNrThreadsD0() * (((observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion()) / integration) + nrOutputSamplesPerGroup - 1) / nrOutputSamplesPerGroup), observation.getNrChannels(), observation.getNrBeams());
+      break;
+    }
+  }
+  local = cl::NDRange(conf.getNrThreadsD0(), 1, 1);
+}
+
+std::string getCopyOpenCL() {
+  return "__kernel void copy(__global const uint4 * const restrict input, __global uint4 * const restrict output) {\n"
+    "output[get_global_id(0)] = input[get_global_id(0)];\n"
+    "}\n";
+}
+
+kernelSourceBuilder::kernelSourceBuilder(const std::size_t capacity) {
+  code.reserve(capacity);
+}
+
+kernelSourceBuilder::~kernelSourceBuilder() {}
+
+kernelSourceBuilder & kernelSourceBuilder::appendOffset(const uint64_t offset) {
+  if ( offset > 0 ) {
+    code.append(" + ");
+    appendInteger(offset);
+  }
+  return *this;
+}
+
+kernelSourceBuilder & kernelSourceBuilder::appendReplaced(const std::string & text, const std::string & placeholder, const uint64_t value) {
+  std::size_t begin = 0;
+  std::size_t position = text.find(placeholder);
+
+  while ( position != std::string::npos ) {
+    code.append(text, begin, position - begin);
+    appendInteger(value);
+    begin = position + placeholder.size();
+    position = text.find(placeholder, begin);
+  }
+  code.append(text, begin, std::string::npos);
+  return *this;
+}
+
+std::string kernelSourceBuilder::release() {
+  return std::move(code);
+}
+
+void kernelSourceBuilder::appendInteger(const uint64_t value) {
+  char digits[20];
+  unsigned int nrDigits = 0;
+  uint64_t remainder = value;
+
+  do {
+    digits[nrDigits++] = static_cast< char >('0' + (remainder % 10));
+    remainder /= 10;
+  } while ( remainder > 0 );
+  while ( nrDigits > 0 ) {
+    code.push_back(digits[--nrDigits]);
+  }
+}
+
+void kernelSourceBuilder::appendInteger(const int64_t value) {
+  if ( value < 0 ) {
+    code.push_back('-');
+    appendInteger(static_cast< uint64_t >(0) - static_cast< uint64_t >(value));
+  } else {
+    appendInteger(static_cast< uint64_t >(value));
+  }
+}
+
+namespace {
+
+// Program binaries cache file: magic, device name, device and driver versions, build options, source, binary
+const char kernelCacheMagic[8] = {'I', 'N', 'T', 'G', 'P', 'R', 'O', 'G'};
+
+// 64 bit FNV-1a, stable across runs and compilers
+uint64_t hashString(const std::string & data, uint64_t hash = 14695981039346656037ULL) {
+  for ( const char character : data ) {
+    hash ^= static_cast< unsigned char >(character);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+void writeCacheString(std::ofstream & cacheFile, const std::string & data) {
+  const uint64_t length = data.size();
+
+  cacheFile.write(reinterpret_cast< const char * >(&length), sizeof(uint64_t));
+  cacheFile.write(data.data(), data.size());
+}
+
+bool readCacheString(std::ifstream & cacheFile, std::string & data) {
+  uint64_t length = 0;
+
+  cacheFile.read(reinterpret_cast< char * >(&length), sizeof(uint64_t));
+  if ( !cacheFile ) {
+    return false;
+  }
+  // A corrupted length is not allowed to allocate more than the rest of the file
+  const std::streampos position = cacheFile.tellg();
+
+  cacheFile.seekg(0, std::ios::end);
+  const std::streamoff remaining = cacheFile.tellg() - position;
+
+  cacheFile.seekg(position);
+  if ( !cacheFile || remaining < 0 || length > static_cast< uint64_t >(remaining) ) {
+    return false;
+  }
+  data.resize(length);
+  cacheFile.read(&data[0], length);
+  return static_cast< bool >(cacheFile);
+}
+
+} // namespace
+
+kernelCache::kernelCache(const std::string & directory, const unsigned int maxPrograms) : directory(directory), maxPrograms(maxPrograms), nrUses(0), nrMemoryHits(0), nrDiskHits(0), nrMisses(0) {}
+
+kernelCache::~kernelCache() {}
+
+cl::Kernel * kernelCache::compile(const std::string & name, const std::string & code, const std::string & flags, cl::Context & context, cl::Device & device) {
+  const std::string deviceName = device.getInfo< CL_DEVICE_NAME >();
+  const std::string deviceVersion = device.getInfo< CL_DEVICE_VERSION >();
+  const std::string driverVersion = device.getInfo< CL_DRIVER_VERSION >();
+  std::string key = std::to_string(reinterpret_cast< uintptr_t >(context())) + " " + std::to_string(reinterpret_cast< uintptr_t >(device())) + " " + flags + "\n" + code;
+  cl::Program program;
+  bool found = false;
+
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    std::map< std::string, std::pair< cl::Program, uint64_t > >::iterator item = programs.find(key);
+
+    if ( item != programs.end() ) {
+      program = item->second.first;
+      item->second.second = nrUses++;
+      nrMemoryHits++;
+      found = true;
+    }
+  }
+  if ( !found ) {
+    std::string filename;
+
+    if ( !directory.empty() ) {
+      std::ostringstream hash;
+
+      hash << std::hex << std::setw(16) << std::setfill('0') << hashString(code, hashString(flags, hashString(deviceName + deviceVersion + driverVersion)));
+      filename = directory + "/" + hash.str() + ".clbin";
+    }
+    program = build(code, flags, context, device, deviceName, deviceVersion, driverVersion, filename);
+    std::lock_guard< std::mutex > lock(mutex);
+    // Kernels keep a reference to their program, so dropping it here does not invalidate them
+    while ( !programs.empty() && programs.size() >= maxPrograms ) {
+      programs.erase(std::min_element(programs.begin(), programs.end(), [](const std::pair< const std::string, std::pair< cl::Program, uint64_t > > & left, const std::pair< const std::string, std::pair< cl::Program, uint64_t > > & right) {
+        return left.second.second < right.second.second;
+      }));
+    }
+    if ( maxPrograms > 0 ) {
+      programs[std::move(key)] = std::make_pair(program, nrUses++);
+    }
+  }
+  try {
+    return new cl::Kernel(program, name.c_str());
+  } catch ( cl::Error & err ) {
+    throw isa::OpenCL::OpenCLError("Impossible to create kernel " + name + ": " + std::to_string(err.err()) + ".");
+  }
+}
+
+cl::Program kernelCache::build(const std::string & code, const std::string & flags, cl::Context & context, cl::Device & device, const std::string & deviceName, const std::string & deviceVersion, const std::string & driverVersion, const std::string & filename) {
+  const std::vector< cl::Device > devices(1, device);
+
+  // Binary from disk, only if built from the same source, for the same device, with the same driver
+  if ( !filename.empty() ) {
+    std::ifstream cacheFile(filename, std::ios::binary);
+    char magic[sizeof(kernelCacheMagic)];
+    std::string fields[5];
+    std::string binary;
+    bool valid = static_cast< bool >(cacheFile.read(magic, sizeof(magic))) && std::memcmp(magic, kernelCacheMagic, sizeof(magic)) == 0;
+
+    for ( unsigned int field = 0; valid && field < 5; field++ ) {
+      valid = readCacheString(cacheFile, fields[field]);
+    }
+    valid = valid && fields[0] == deviceName && fields[1] == deviceVersion && fields[2] == driverVersion && fields[3] == flags && fields[4] == code && readCacheString(cacheFile, binary);
+    if ( valid ) {
+      const unsigned char * binaryPointer = reinterpret_cast< const unsigned char * >(binary.data());
+      const size_t binarySize = binary.size();
+      cl_device_id deviceID = device();
+      cl_int binaryStatus = CL_SUCCESS;
+      cl_int status = CL_SUCCESS;
+      cl_program binaryProgram = clCreateProgramWithBinary(context(), 1, &deviceID, &binarySize, &binaryPointer, &binaryStatus, &status);
+
+      if ( status == CL_SUCCESS && binaryStatus == CL_SUCCESS ) {
+        cl::Program program(binaryProgram);
+
+        try {
+          program.build(devices, flags.c_str());
+          std::lock_guard< std::mutex > lock(mutex);
+          nrDiskHits++;
+          return program;
+        } catch ( cl::Error & err ) {
+          // Rejected by the driver, compiled again from source below
+        }
+      } else if ( status == CL_SUCCESS ) {
+        clReleaseProgram(binaryProgram);
+      }
+    }
+  }
+
+  // Compile from source
+  cl::Program::Sources sources(1, std::make_pair(code.c_str(), code.length()));
+  cl::Program program;
+
+  try {
+    program = cl::Program(context, sources);
+  } catch ( cl::Error & err ) {
+    throw isa::OpenCL::OpenCLError("Impossible to create program: " + std::to_string(err.err()) + ".");
+  }
+  try {
+    program.build(devices, flags.c_str());
+  } catch ( cl::Error & err ) {
+    throw isa::OpenCL::OpenCLError("Error building program: " + std::to_string(err.err()) + ".\n" + program.getBuildInfo< CL_PROGRAM_BUILD_LOG >(device));
+  }
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    nrMisses++;
+  }
+  if ( !filename.empty() ) {
+    size_t binarySize = 0;
+
+    if ( clGetProgramInfo(program(), CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &binarySize, nullptr) == CL_SUCCESS && binarySize > 0 ) {
+      std::string binary(binarySize, '\0');
+      unsigned char * binaryPointer = reinterpret_cast< unsigned char * >(&binary[0]);
+
+      if ( clGetProgramInfo(program(), CL_PROGRAM_BINARIES, sizeof(unsigned char *), &binaryPointer, nullptr) == CL_SUCCESS ) {
+        // Written to a temporary file and renamed, so that concurrent processes and threads never read a partial file
+        const std::string temporaryFilename = filename + "." + std::to_string(getpid()) + "." + std::to_string(std::hash< std::thread::id >()(std::this_thread::get_id()));
+        std::ofstream cacheFile(temporaryFilename, std::ios::binary | std::ios::trunc);
+
+        cacheFile.write(kernelCacheMagic, sizeof(kernelCacheMagic));
+        writeCacheString(cacheFile, deviceName);
+        writeCacheString(cacheFile, deviceVersion);
+        writeCacheString(cacheFile, driverVersion);
+        writeCacheString(cacheFile, flags);
+        writeCacheString(cacheFile, code);
+        writeCacheString(cacheFile, binary);
+        cacheFile.close();
+        if ( !cacheFile || std::rename(temporaryFilename.c_str(), filename.c_str()) != 0 ) {
+          std::remove(temporaryFilename.c_str());
+        }
+      }
+    }
+  }
+  return program;
+}
+
+kernelCompiler::kernelCompiler(kernelCache & cache, const unsigned int nrThreads) : cache(cache), stop(false), nrRunning(0) {
+  unsigned int nrWorkers = nrThreads;
+
+  if ( nrWorkers == 0 ) {
+    nrWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  for ( unsigned int id = 0; id < nrWorkers; id++ ) {
+    threads.emplace_back(&kernelCompiler::worker, this);
+  }
+}
+
+kernelCompiler::~kernelCompiler() {
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+    stop = true;
+  }
+  wakeUp.notify_all();
+  for ( auto & thread : threads ) {
+    thread.join();
+  }
+  for ( auto & item : results ) {
+    delete item.second.kernel;
+  }
+}
+
+unsigned int kernelCompiler::getNrPending() const {
+  std::lock_guard< std::mutex > lock(mutex);
+
+  return results.size();
+}
+
+bool kernelCompiler::isSubmitted(const unsigned int id) const {
+  std::lock_guard< std::mutex > lock(mutex);
+
+  return results.find(id) != results.end();
+}
+
+void kernelCompiler::submit(const unsigned int id, const std::string & name, const std::function< std::string() > & generator, const std::string & flags, cl::Context & context, cl::Device & device) {
+  {
+    std::lock_guard< std::mutex > lock(mutex);
+
+    if ( results.find(id) != results.end() ) {
+      return;
+    }
+    results.emplace(id, result{nullptr, nullptr, false});
+    jobs.push_back(job{id, name, generator, flags, &context, &device});
+  }
+  wakeUp.notify_one();
+}
+
+cl::Kernel * kernelCompiler::get(const unsigned int id) {
+  std::unique_lock< std::mutex > lock(mutex);
+  std::map< unsigned int, result >::iterator item = results.find(id);
 
-integrationConf::~integrationConf() {}
+  if ( item == results.end() ) {
+    throw std::out_of_range("Kernel " + std::to_string(id) + " was not submitted.");
+  }
+  done.wait(lock, [&item] { return item->second.ready; });
+  const result compiled = item->second;
+  results.erase(item);
+  lock.unlock();
+  if ( compiled.error ) {
+    std::rethrow_exception(compiled.error);
+  }
+  return compiled.kernel;
+}
 
-std::string integrationConf::print() const {
-  return std::to_string(subbandDedispersion) + " " + isa::OpenCL::KernelConf::print();
+void kernelCompiler::clear() {
+  std::unique_lock< std::mutex > lock(mutex);
+
+  for ( const auto & waiting : jobs ) {
+    results.erase(waiting.id);
+  }
+  jobs.clear();
+  done.wait(lock, [this] { return nrRunning == 0; });
+  for ( auto & item : results ) {
+    delete item.second.kernel;
+  }
+  results.clear();
+}
+
+void kernelCompiler::worker() {
+  while ( true ) {
+    job current;
+    cl::Kernel * kernel = nullptr;
+    std::exception_ptr error = nullptr;
+
+    {
+      std::unique_lock< std::mutex > lock(mutex);
+
+      wakeUp.wait(lock, [this] { return stop || !jobs.empty(); });
+      if ( stop ) {
+        return;
+      }
+      current = std::move(jobs.front());
+      jobs.pop_front();
+      nrRunning++;
+    }
+    try {
+      kernel = cache.compile(current.name, current.generator(), current.flags, *(current.context), *(current.device));
+    } catch ( ... ) {
+      error = std::current_exception();
+    }
+    {
+      std::lock_guard< std::mutex > lock(mutex);
+
+      results[current.id] = result{kernel, error, true};
+      nrRunning--;
+    }
+    done.notify_all();
+  }
+}
+
+namespace {
+
+// Binary cache of the tuned configurations: header with the source, device names, then entries of tunedConfCacheFields integers
+const char tunedConfCacheMagic[8] = {'I', 'N', 'T', 'G', 'C', 'O', 'N', 'F'};
+const uint32_t tunedConfCacheVersion = 5;
+const unsigned int tunedConfCacheFields = 15;
+// Fields of a line of a configuration file after the device name; the ones after these were added later and are optional
+const unsigned int tunedConfRequiredFields = 10;
+
+// Parse an unsigned integer preceded by spaces, without going past the end of the line
+bool parseField(const char * & position, const char * const end, uint32_t & value) {
+  while ( position < end && *position == ' ' ) {
+    position++;
+  }
+  if ( position == end || !std::isdigit(static_cast< unsigned char >(*position)) ) {
+    return false;
+  }
+  value = 0;
+  while ( position < end && std::isdigit(static_cast< unsigned char >(*position)) ) {
+    value = (value * 10) + (*position - '0');
+    position++;
+  }
+  return true;
+}
+
+// Source of a cache made from a file, changes if the file is replaced or modified
+uint64_t getCacheSource(const struct stat & status) {
+  uint64_t source = 14695981039346656037ull;
+
+  for ( const uint64_t value : {static_cast< uint64_t >(status.st_size), static_cast< uint64_t >(status.st_mtim.tv_sec), static_cast< uint64_t >(status.st_mtim.tv_nsec), static_cast< uint64_t >(status.st_ino)} ) {
+    source = (source ^ value) * 1099511628211ull;
+  }
+  return source;
+}
+
+// Order of the entries of tunedIntegrationConf
+template< typename E >
+bool isBefore(const E & left, const E & right) {
+  return std::make_tuple(left.device, left.integration, left.dim0) < std::make_tuple(right.device, right.integration, right.dim0);
+}
+
+template< typename T >
+void readCacheValue(const char * & position, T & value) {
+  std::memcpy(&value, position, sizeof(T));
+  position += sizeof(T);
+}
+
+template< typename T >
+void writeCacheValue(std::ofstream & cacheFile, const T value) {
+  cacheFile.write(reinterpret_cast< const char * >(&value), sizeof(T));
+}
+
+} // namespace
+
+tunedIntegrationConf::tunedIntegrationConf() {}
+
+tunedIntegrationConf::~tunedIntegrationConf() {}
+
+uint32_t tunedIntegrationConf::getDeviceIndex(const std::string & deviceName) const {
+  std::vector< std::string >::const_iterator device = std::lower_bound(devices.begin(), devices.end(), deviceName);
+
+  if ( device == devices.end() || *device != deviceName ) {
+    return devices.size();
+  }
+  return device - devices.begin();
+}
+
+std::pair< std::vector< tunedIntegrationConf::entry >::const_iterator, std::vector< tunedIntegrationConf::entry >::const_iterator > tunedIntegrationConf::getRange(const std::string & deviceName, const unsigned int integration) const {
+  const uint32_t device = getDeviceIndex(deviceName);
+
+  if ( device == devices.size() ) {
+    return std::make_pair(entries.end(), entries.end());
+  }
+  const entry key = {device, integration, 0, integrationConf()};
+
+  return std::equal_range(entries.begin(), entries.end(), key, [](const entry & left, const entry & right) {
+    return std::make_pair(left.device, left.integration) < std::make_pair(right.device, right.integration);
+  });
+}
+
+const integrationConf * tunedIntegrationConf::find(const std::string & deviceName, const unsigned int dim0, const unsigned int integration) const {
+  const auto range = getRange(deviceName, integration);
+  const auto item = std::lower_bound(range.first, range.second, dim0, [](const entry & left, const unsigned int right) {
+    return left.dim0 < right;
+  });
+
+  if ( item == range.second || item->dim0 != dim0 ) {
+    return nullptr;
+  }
+  return &(item->conf);
+}
+
+const integrationConf * tunedIntegrationConf::findNearest(const std::string & deviceName, const unsigned int dim0, const unsigned int integration) const {
+  const auto range = getRange(deviceName, integration);
+  auto item = std::lower_bound(range.first, range.second, dim0, [](const entry & left, const unsigned int right) {
+    return left.dim0 < right;
+  });
+
+  if ( range.first == range.second ) {
+    return nullptr;
+  }
+  // The closest dim0 is either the first one not smaller than dim0 or the one before it, ties go to the smaller
+  if ( item == range.second || (item != range.first && (dim0 - (item - 1)->dim0) <= (item->dim0 - dim0)) ) {
+    item--;
+  }
+  return &(item->conf);
+}
+
+void tunedIntegrationConf::insert(const std::string & deviceName, const unsigned int dim0, const unsigned int integration, const integrationConf & conf) {
+  uint32_t device = getDeviceIndex(deviceName);
+
+  if ( device == devices.size() ) {
+    device = std::lower_bound(devices.begin(), devices.end(), deviceName) - devices.begin();
+    devices.insert(devices.begin() + device, deviceName);
+    for ( auto & item : entries ) {
+      if ( item.device >= device ) {
+        item.device++;
+      }
+    }
+  }
+  entry item = {device, integration, dim0, conf};
+  auto position = std::lower_bound(entries.begin(), entries.end(), item, [](const entry & left, const entry & right) {
+    return std::make_tuple(left.device, left.integration, left.dim0) < std::make_tuple(right.device, right.integration, right.dim0);
+  });
+
+  if ( position != entries.end() && position->device == device && position->integration == integration && position->dim0 == dim0 ) {
+    return;
+  }
+  entries.insert(position, item);
+}
+
+void tunedIntegrationConf::merge(const tunedIntegrationConf & other) {
+  std::vector< std::string > mergedDevices;
+  std::vector< uint32_t > otherToMerged(other.devices.size());
+  std::vector< entry > mergedEntries;
+
+  if ( devices.empty() ) {
+    devices = other.devices;
+    entries = other.entries;
+    return;
+  }
+  // Both lists of devices are sorted, so are the merged one and the new indices
+  std::set_union(devices.begin(), devices.end(), other.devices.begin(), other.devices.end(), std::back_inserter(mergedDevices));
+  for ( uint32_t device = 0; device < other.devices.size(); device++ ) {
+    otherToMerged[device] = std::lower_bound(mergedDevices.begin(), mergedDevices.end(), other.devices[device]) - mergedDevices.begin();
+  }
+  for ( auto & item : entries ) {
+    item.device = std::lower_bound(mergedDevices.begin(), mergedDevices.end(), devices[item.device]) - mergedDevices.begin();
+  }
+  mergedEntries.reserve(entries.size() + other.entries.size());
+  auto item = entries.begin();
+  for ( auto otherItem : other.entries ) {
+    otherItem.device = otherToMerged[otherItem.device];
+    while ( item != entries.end() && isBefore(*item, otherItem) ) {
+      mergedEntries.push_back(*item);
+      item++;
+    }
+    if ( item == entries.end() || isBefore(otherItem, *item) ) {
+      mergedEntries.push_back(otherItem);
+    }
+  }
+  mergedEntries.insert(mergedEntries.end(), item, entries.end());
+  devices = std::move(mergedDevices);
+  entries = std::move(mergedEntries);
+}
+
+void tunedIntegrationConf::clear() {
+  devices.clear();
+  entries.clear();
+}
+
+void tunedIntegrationConf::writeCache(const std::string & cacheFilename, const uint64_t source) const {
+  std::ofstream cacheFile(cacheFilename, std::ios::binary | std::ios::trunc);
+
+  if ( !cacheFile ) {
+    throw AstroData::FileError("Impossible to open " + cacheFilename);
+  }
+  cacheFile.write(tunedConfCacheMagic, sizeof(tunedConfCacheMagic));
+  writeCacheValue< uint32_t >(cacheFile, tunedConfCacheVersion);
+  writeCacheValue< uint64_t >(cacheFile, source);
+  writeCacheValue< uint32_t >(cacheFile, devices.size());
+  writeCacheValue< uint32_t >(cacheFile, entries.size());
+  for ( const auto & device : devices ) {
+    writeCacheValue< uint32_t >(cacheFile, device.size());
+    cacheFile.write(device.data(), device.size());
+  }
+  for ( const auto & item : entries ) {
+    const uint32_t fields[tunedConfCacheFields] = {item.device, item.integration, item.dim0, item.conf.getSubbandDedispersion(), item.conf.getNrThreadsD0(), item.conf.getNrThreadsD1(), item.conf.getNrThreadsD2(), item.conf.getNrItemsD0(), item.conf.getNrItemsD1(), item.conf.getNrItemsD2(), item.conf.getIntTypeCode(), item.conf.getSubgroupReduction(), item.conf.getVectorWidth(), static_cast< uint32_t >(item.conf.getInPlaceVariant()), item.conf.getNrPasses()};
+
+    cacheFile.write(reinterpret_cast< const char * >(fields), sizeof(fields));
+  }
+  if ( !cacheFile ) {
+    throw AstroData::FileError("Impossible to write " + cacheFilename);
+  }
+}
+
+void tunedIntegrationConf::readCache(const std::string & cacheFilename, const uint64_t source) {
+  struct stat status;
+  int cacheFile = open(cacheFilename.c_str(), O_RDONLY);
+
+  if ( cacheFile < 0 ) {
+    throw AstroData::FileError("Impossible to open " + cacheFilename);
+  }
+  if ( fstat(cacheFile, &status) != 0 || status.st_size < static_cast< off_t >(sizeof(tunedConfCacheMagic) + (3 * sizeof(uint32_t)) + sizeof(uint64_t)) ) {
+    close(cacheFile);
+    throw AstroData::FileError("Invalid cache " + cacheFilename);
+  }
+  void * cache = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, cacheFile, 0);
+  close(cacheFile);
+  if ( cache == MAP_FAILED ) {
+    throw AstroData::FileError("Impossible to map " + cacheFilename);
+  }
+  const char * position = reinterpret_cast< const char * >(cache);
+  const char * const end = position + status.st_size;
+  uint32_t version = 0;
+  uint64_t cacheSource = 0;
+  uint32_t nrDevices = 0;
+  uint32_t nrEntries = 0;
+  bool valid = std::memcmp(position, tunedConfCacheMagic, sizeof(tunedConfCacheMagic)) == 0;
+
+  position += sizeof(tunedConfCacheMagic);
+  readCacheValue(position, version);
+  readCacheValue(position, cacheSource);
+  readCacheValue(position, nrDevices);
+  readCacheValue(position, nrEntries);
+  // Every device name takes at least its length, so a corrupted count cannot allocate more than the file
+  valid = valid && (version == tunedConfCacheVersion) && (cacheSource == source) && (nrDevices <= static_cast< std::size_t >(end - position) / sizeof(uint32_t));
+  clear();
+  if ( valid ) {
+    devices.reserve(nrDevices);
+  }
+  for ( uint32_t device = 0; valid && device < nrDevices; device++ ) {
+    uint32_t length = 0;
+
+    if ( static_cast< std::size_t >(end - position) < sizeof(uint32_t) ) {
+      valid = false;
+      break;
+    }
+    readCacheValue(position, length);
+    if ( static_cast< std::size_t >(end - position) < length ) {
+      valid = false;
+      break;
+    }
+    devices.emplace_back(position, length);
+    position += length;
+    valid = (device == 0) || (devices[device - 1] < devices[device]);
+  }
+  valid = valid && (static_cast< uint64_t >(end - position) == static_cast< uint64_t >(nrEntries) * tunedConfCacheFields * sizeof(uint32_t));
+  if ( valid ) {
+    entries.resize(nrEntries);
+  }
+  for ( uint32_t item = 0; valid && item < nrEntries; item++ ) {
+    uint32_t fields[tunedConfCacheFields];
+
+    std::memcpy(fields, position, sizeof(fields));
+    position += sizeof(fields);
+    entries[item].device = fields[0];
+    entries[item].integration = fields[1];
+    entries[item].dim0 = fields[2];
+    entries[item].conf.setSubbandDedispersion(fields[3] != 0);
+    entries[item].conf.setNrThreadsD0(fields[4]);
+    entries[item].conf.setNrThreadsD1(fields[5]);
+    entries[item].conf.setNrThreadsD2(fields[6]);
+    entries[item].conf.setNrItemsD0(fields[7]);
+    entries[item].conf.setNrItemsD1(fields[8]);
+    entries[item].conf.setNrItemsD2(fields[9]);
+    entries[item].conf.setIntType(fields[10]);
+    entries[item].conf.setSubgroupReduction(fields[11] != 0);
+    entries[item].conf.setVectorWidth(fields[12]);
+    entries[item].conf.setInPlaceVariant(static_cast< integrationInPlaceVariant >(fields[13]));
+    entries[item].conf.setNrPasses(fields[14]);
+    valid = (fields[0] < nrDevices) && (fields[13] <= static_cast< uint32_t >(integrationInPlaceVariant::MultiPass)) && ((item == 0) || isBefore(entries[item - 1], entries[item]));
+  }
+  munmap(cache, status.st_size);
+  if ( !valid ) {
+    clear();
+    throw AstroData::FileError("Invalid cache " + cacheFilename);
+  }
 }
 
 void readTunedIntegrationConf(tunedIntegrationConf & tunedConf, const std::string & confFilename) {
-  unsigned int dim0 = 0;
-  unsigned int integration = 0;
-  std::string temp;
-  std::string deviceName;
-  Integration::integrationConf * parameters = 0;
-  std::ifstream confFile;
-
-  confFile.open(confFilename);
+  std::ifstream confFile(confFilename, std::ios::binary);
+  std::string contents;
+  // Device names of this file, each one with the order of its first line
+  std::map< std::string, uint32_t > fileDevices;
+  std::vector< std::pair< uint32_t, tunedIntegrationConf::entry > > fileEntries;
+
   if ( !confFile ) {
     throw AstroData::FileError("Impossible to open " + confFilename);
   }
-  while ( ! confFile.eof() ) {
-    unsigned int splitPoint = 0;
+  contents.assign(std::istreambuf_iterator< char >(confFile), std::istreambuf_iterator< char >());
+  confFile.close();
+  for ( const char * line = contents.data(); line < contents.data() + contents.size(); ) {
+    const char * lineEnd = static_cast< const char * >(std::memchr(line, '\n', (contents.data() + contents.size()) - line));
+    const char * position = line;
+    const char * nameEnd = nullptr;
+    uint32_t fields[tunedConfCacheFields - 1] = {0};
+    bool valid = true;
+
+    if ( lineEnd == nullptr ) {
+      lineEnd = contents.data() + contents.size();
+    }
+    if ( !std::isalpha(static_cast< unsigned char >(*line)) ) {
+      line = lineEnd + 1;
+      continue;
+    }
+    nameEnd = static_cast< const char * >(std::memchr(line, ' ', lineEnd - line));
+    if ( nameEnd == nullptr ) {
+      throw AstroData::FileError("Invalid line in " + confFilename);
+    }
+    position = nameEnd;
+    // dim0, integration, subbanding, threads, items, and integer type, then the optional sub-group reduction, vector width, in-place variant and number of passes
+    for ( unsigned int field = 0; valid && field < tunedConfRequiredFields; field++ ) {
+      valid = parseField(position, lineEnd, fields[field]);
+    }
+    if ( !valid ) {
+      throw AstroData::FileError("Invalid line in " + confFilename);
+    }
+    for ( unsigned int field = tunedConfRequiredFields; field < tunedConfCacheFields - 1; field++ ) {
+      if ( !parseField(position, lineEnd, fields[field]) ) {
+        break;
+      }
+    }
+    auto device = fileDevices.emplace(std::string(line, nameEnd - line), fileDevices.size()).first;
+    tunedIntegrationConf::entry item = {device->second, fields[1], fields[0], integrationConf()};
+
+    item.conf.setSubbandDedispersion(fields[2] != 0);
+    item.conf.setNrThreadsD0(fields[3]);
+    item.conf.setNrThreadsD1(fields[4]);
+    item.conf.setNrThreadsD2(fields[5]);
+    item.conf.setNrItemsD0(fields[6]);
+    item.conf.setNrItemsD1(fields[7]);
+    item.conf.setNrItemsD2(fields[8]);
+    item.conf.setIntType(fields[9]);
+    item.conf.setSubgroupReduction(fields[10] != 0);
+    item.conf.setVectorWidth(std::max(fields[11], 1u));
+    if ( fields[12] > static_cast< uint32_t >(integrationInPlaceVariant::MultiPass) ) {
+      throw AstroData::FileError("Invalid line in " + confFilename);
+    }
+    item.conf.setInPlaceVariant(static_cast< integrationInPlaceVariant >(fields[12]));
+    item.conf.setNrPasses(std::max(fields[13], 1u));
+    fileEntries.emplace_back(fileEntries.size(), item);
+    line = lineEnd + 1;
+  }
+
+  // Sort the content of the file, keeping the first line for duplicated parameters, then merge it with tunedConf
+  tunedIntegrationConf fileConf;
+  std::vector< uint32_t > fileToSorted(fileDevices.size());
+
+  for ( const auto & device : fileDevices ) {
+    fileToSorted[device.second] = fileConf.devices.size();
+    fileConf.devices.push_back(device.first);
+  }
+  for ( auto & item : fileEntries ) {
+    item.second.device = fileToSorted[item.second.device];
+  }
+  std::sort(fileEntries.begin(), fileEntries.end(), [](const std::pair< uint32_t, tunedIntegrationConf::entry > & left, const std::pair< uint32_t, tunedIntegrationConf::entry > & right) {
+    return std::make_tuple(left.second.device, left.second.integration, left.second.dim0, left.first) < std::make_tuple(right.second.device, right.second.integration, right.second.dim0, right.first);
+  });
+  fileConf.entries.reserve(fileEntries.size());
+  for ( const auto & item : fileEntries ) {
+    if ( fileConf.entries.empty() || isBefore(fileConf.entries.back(), item.second) ) {
+      fileConf.entries.push_back(item.second);
+    }
+  }
+  tunedConf.merge(fileConf);
+}
+
+void readTunedIntegrationConf(tunedIntegrationConf & tunedConf, const std::string & confFilename, const std::string & cacheFilename) {
+  struct stat confStatus;
+  tunedIntegrationConf fileConf;
+
+  if ( stat(confFilename.c_str(), &confStatus) != 0 ) {
+    throw AstroData::FileError("Impossible to open " + confFilename);
+  }
+  try {
+    fileConf.readCache(cacheFilename, getCacheSource(confStatus));
+  } catch ( std::exception & err ) {
+    // Missing, invalid, or old cache, it is replaced below
+    fileConf.clear();
+    readTunedIntegrationConf(fileConf, confFilename);
+    try {
+      fileConf.writeCache(cacheFilename, getCacheSource(confStatus));
+    } catch ( AstroData::FileError & err ) {
+      // The cache is only an optimization
+    }
+  }
+  tunedConf.merge(fileConf);
+}
+
+
+kernelRunTimes::kernelRunTimes() {}
+
+kernelRunTimes::~kernelRunTimes() {}
+
+double kernelRunTimes::getAverageTime() const {
+  if ( times.empty() ) {
+    return 0.0;
+  }
+  return std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+}
+
+double kernelRunTimes::getStandardDeviation() const {
+  const double average = getAverageTime();
+  double variance = 0.0;
+
+  if ( times.size() < 2 ) {
+    return 0.0;
+  }
+  for ( const double time : times ) {
+    variance += (time - average) * (time - average);
+  }
+  return std::sqrt(variance / (times.size() - 1));
+}
+
+double kernelRunTimes::getCoefficientOfVariation() const {
+  const double average = getAverageTime();
+
+  if ( average == 0.0 ) {
+    return 0.0;
+  }
+  return getStandardDeviation() / average;
+}
+
+double kernelRunTimes::getMinimumTime() const {
+  if ( times.empty() ) {
+    return 0.0;
+  }
+  return *std::min_element(times.begin(), times.end());
+}
+
+double kernelRunTimes::getMedianTime() const {
+  if ( times.empty() ) {
+    return 0.0;
+  }
+  if ( sortedTimes.size() != times.size() ) {
+    sortedTimes = times;
+    std::sort(sortedTimes.begin(), sortedTimes.end());
+  }
+  if ( sortedTimes.size() % 2 == 0 ) {
+    return (sortedTimes[(sortedTimes.size() / 2) - 1] + sortedTimes[sortedTimes.size() / 2]) / 2.0;
+  }
+  return sortedTimes[sortedTimes.size() / 2];
+}
+
+double kernelRunTimes::getPercentileTime(const double fraction) const {
+  if ( times.empty() ) {
+    return 0.0;
+  }
+  if ( sortedTimes.size() != times.size() ) {
+    sortedTimes = times;
+    std::sort(sortedTimes.begin(), sortedTimes.end());
+  }
+  // Nearest rank
+  const std::size_t rank = static_cast< std::size_t >(std::ceil(fraction * sortedTimes.size()));
+  return sortedTimes[std::min(std::max(rank, static_cast< std::size_t >(1)), sortedTimes.size()) - 1];
+}
+
+void kernelRunTimes::add(const double time) {
+  times.push_back(time);
+}
+
+void kernelRunTimes::reset() {
+  times.clear();
+  sortedTimes.clear();
+}
+
+namespace {
+
+// Consecutive restarts, or evaluations, without improvement after which a search without budget stops
+const unsigned int maxNrRestartsWithoutImprovement = 3;
+const unsigned int maxNrEvaluationsWithoutImprovement = 20;
+// Random configurations measured before using the surrogate model, if there is no budget
+const unsigned int nrSurrogateInitial = 10;
+// Weight of the distance from measured configurations in the surrogate's acquisition function
+const double surrogateExploration = 0.5;
+
+// Configurations measured with the full number of iterations, and the kernel launches spent so far
+class searchState {
+public:
+  searchState(const std::vector< std::vector< unsigned int > > & parameters, const unsigned int nrIterations, const unsigned int budget, const std::function< double(const unsigned int, const unsigned int, unsigned int &) > & measure, const std::function< void(const std::vector< unsigned int > &) > & prepare) : parameters(parameters), nrIterations(nrIterations), maxNrLaunches(static_cast< uint64_t >(budget) * nrIterations), measure(measure), prepare(prepare), nrLaunches(0), best(parameters.size()), bestPerformance(0.0) {
+    const unsigned int nrDimensions = parameters.empty() ? 0 : parameters.front().size();
+
+    // Configurations are placed on a grid, using the rank of each parameter's value
+    values.resize(nrDimensions);
+    for ( unsigned int dimension = 0; dimension < nrDimensions; dimension++ ) {
+      for ( const auto & configuration : parameters ) {
+        values[dimension].push_back(configuration[dimension]);
+      }
+      std::sort(values[dimension].begin(), values[dimension].end());
+      values[dimension].erase(std::unique(values[dimension].begin(), values[dimension].end()), values[dimension].end());
+    }
+    ranks.resize(parameters.size());
+    coordinates.resize(parameters.size());
+    for ( unsigned int configuration = 0; configuration < parameters.size(); configuration++ ) {
+      for ( unsigned int dimension = 0; dimension < nrDimensions; dimension++ ) {
+        ranks[configuration].push_back(std::lower_bound(values[dimension].begin(), values[dimension].end(), parameters[configuration][dimension]) - values[dimension].begin());
+        if ( values[dimension].size() > 1 ) {
+          coordinates[configuration].push_back(static_cast< double >(ranks[configuration][dimension]) / (values[dimension].size() - 1));
+        } else {
+          coordinates[configuration].push_back(0.0);
+        }
+      }
+      grid.insert(std::make_pair(ranks[configuration], configuration));
+    }
+  }
+
+  unsigned int size() const {
+    return parameters.size();
+  }
+
+  unsigned int getNrMeasured() const {
+    return performance.size();
+  }
+
+  unsigned int getBest() const {
+    return best;
+  }
+
+  double getBestPerformance() const {
+    return bestPerformance;
+  }
+
+  bool isMeasured(const unsigned int configuration) const {
+    return performance.find(configuration) != performance.end();
+  }
+
+  // True if the budget allows another measurement of this configuration
+  bool canMeasure(const unsigned int configuration) const {
+    return canMeasure(configuration, nrIterations);
+  }
+
+  bool canMeasure(const unsigned int configuration, const unsigned int iterations) const {
+    if ( iterations == nrIterations && isMeasured(configuration) ) {
+      return true;
+    }
+    return (maxNrLaunches == 0) || (nrLaunches + iterations <= maxNrLaunches);
+  }
+
+  // Announce the configurations that are going to be measured next, in order
+  void announce(const std::vector< unsigned int > & configurations, const unsigned int iterations) const {
+    std::vector< unsigned int > upcoming;
+
+    if ( !prepare ) {
+      return;
+    }
+    for ( const unsigned int configuration : configurations ) {
+      if ( iterations != nrIterations || !isMeasured(configuration) ) {
+        upcoming.push_back(configuration);
+      }
+    }
+    if ( !upcoming.empty() ) {
+      prepare(upcoming);
+    }
+  }
+
+  void announce(const std::vector< unsigned int > & configurations) const {
+    announce(configurations, nrIterations);
+  }
+
+  // Measurements with the full number of iterations are done only once
+  double evaluate(const unsigned int configuration, const unsigned int iterations) {
+    if ( iterations == nrIterations ) {
+      auto item = performance.find(configuration);
+
+      if ( item != performance.end() ) {
+        return item->second;
+      }
+    }
+    // Adaptive measurements can run the kernel more than iterations times, and are charged for all the runs
+    unsigned int nrRuns = iterations;
+    const double value = measure(configuration, iterations, nrRuns);
+    nrLaunches += std::max(iterations, nrRuns);
+    if ( iterations == nrIterations ) {
+      performance.insert(std::make_pair(configuration, value));
+      if ( value > bestPerformance ) {
+        best = configuration;
+        bestPerformance = value;
+      }
+    }
+    return value;
+  }
 
-    std::getline(confFile, temp);
-    if ( ! std::isalpha(temp[0]) ) {
+  double evaluate(const unsigned int configuration) {
+    return evaluate(configuration, nrIterations);
+  }
+
+  // Closest configurations at 1, 2, 4, ... steps in both directions of every dimension, holes in the grid are skipped
+  std::vector< unsigned int > getNeighbours(const unsigned int configuration) const {
+    std::vector< unsigned int > neighbours;
+
+    for ( unsigned int dimension = 0; dimension < values.size(); dimension++ ) {
+      const int nrValues = values[dimension].size();
+
+      for ( int direction = -1; direction <= 1; direction += 2 ) {
+        int previous = ranks[configuration][dimension];
+
+        for ( int stride = 1; stride < nrValues; stride *= 2 ) {
+          std::vector< unsigned int > rank = ranks[configuration];
+          int step = static_cast< int >(ranks[configuration][dimension]) + (direction * stride);
+
+          if ( step * direction <= previous * direction ) {
+            step = previous + direction;
+          }
+          for ( ; (step >= 0) && (step < nrValues); step += direction ) {
+            rank[dimension] = step;
+            auto item = grid.find(rank);
+
+            if ( item != grid.end() ) {
+              neighbours.push_back(item->second);
+              previous = step;
+              break;
+            }
+          }
+        }
+      }
+    }
+    return neighbours;
+  }
+
+  // Distance between two configurations, with the ranks of each parameter scaled to [0, 1]
+  double getDistance(const unsigned int first, const unsigned int second) const {
+    double distance = 0.0;
+
+    for ( unsigned int dimension = 0; dimension < values.size(); dimension++ ) {
+      const double difference = coordinates[first][dimension] - coordinates[second][dimension];
+
+      distance += difference * difference;
+    }
+    return std::sqrt(distance);
+  }
+
+  const std::map< unsigned int, double > & getPerformance() const {
+    return performance;
+  }
+
+private:
+  const std::vector< std::vector< unsigned int > > & parameters;
+  const unsigned int nrIterations;
+  const uint64_t maxNrLaunches;
+  const std::function< double(const unsigned int, const unsigned int, unsigned int &) > & measure;
+  const std::function< void(const std::vector< unsigned int > &) > & prepare;
+  uint64_t nrLaunches;
+  std::vector< std::vector< unsigned int > > values;
+  std::vector< std::vector< unsigned int > > ranks;
+  std::vector< std::vector< double > > coordinates;
+  std::map< std::vector< unsigned int >, unsigned int > grid;
+  std::map< unsigned int, double > performance;
+  unsigned int best;
+  double bestPerformance;
+};
+
+void searchExhaustive(searchState & state) {
+  std::vector< unsigned int > configurations(state.size());
+
+  std::iota(configurations.begin(), configurations.end(), 0);
+  state.announce(configurations);
+  for ( unsigned int configuration = 0; configuration < state.size(); configuration++ ) {
+    if ( !state.canMeasure(configuration) ) {
+      break;
+    }
+    state.evaluate(configuration);
+  }
+}
+
+// Steepest ascent from random starting points
+void searchHillClimbing(searchState & state, const bool budget, std::mt19937 & generator) {
+  std::vector< unsigned int > starts(state.size());
+  unsigned int nrRestartsWithoutImprovement = 0;
+
+  std::iota(starts.begin(), starts.end(), 0);
+  std::shuffle(starts.begin(), starts.end(), generator);
+  for ( const unsigned int start : starts ) {
+    const double previousBest = state.getBestPerformance();
+    unsigned int current = start;
+
+    if ( state.isMeasured(start) ) {
       continue;
+    } else if ( !state.canMeasure(start) ) {
+      return;
+    }
+    double currentPerformance = state.evaluate(start);
+    while ( true ) {
+      const std::vector< unsigned int > neighbours = state.getNeighbours(current);
+      unsigned int next = current;
+      double nextPerformance = currentPerformance;
+
+      state.announce(neighbours);
+      for ( const unsigned int neighbour : neighbours ) {
+        if ( !state.canMeasure(neighbour) ) {
+          return;
+        }
+        const double performance = state.evaluate(neighbour);
+        if ( performance > nextPerformance ) {
+          next = neighbour;
+          nextPerformance = performance;
+        }
+      }
+      if ( next == current ) {
+        break;
+      }
+      current = next;
+      currentPerformance = nextPerformance;
+    }
+    if ( state.getBestPerformance() > previousBest ) {
+      nrRestartsWithoutImprovement = 0;
+    } else if ( !budget && (++nrRestartsWithoutImprovement >= maxNrRestartsWithoutImprovement) ) {
+      return;
+    }
+  }
+}
+
+// Short runs for many random configurations, the best half is measured again with twice the iterations
+void searchSuccessiveHalving(searchState & state, const unsigned int nrIterations, const unsigned int budget, std::mt19937 & generator) {
+  std::vector< unsigned int > candidates(state.size());
+  auto getNrRungs = [](const unsigned int nrCandidates) {
+    unsigned int nrRungs = 1;
+
+    while ( (1U << (nrRungs - 1)) < nrCandidates ) {
+      nrRungs++;
+    }
+    return nrRungs;
+  };
+  auto getNrIterations = [nrIterations](const unsigned int rung, const unsigned int nrRungs) {
+    const unsigned int shift = nrRungs - 1 - rung;
+
+    return (shift >= 32) ? 1U : std::max(1U, nrIterations >> shift);
+  };
+  auto getCost = [&](const unsigned int nrCandidates) {
+    const unsigned int nrRungs = getNrRungs(nrCandidates);
+    uint64_t cost = 0;
+
+    for ( unsigned int rung = 0; rung < nrRungs; rung++ ) {
+      cost += static_cast< uint64_t >((nrCandidates + (1U << rung) - 1) >> rung) * getNrIterations(rung, nrRungs);
+    }
+    return cost;
+  };
+  unsigned int nrCandidates = state.size();
+
+  if ( budget > 0 ) {
+    while ( (nrCandidates > 1) && (getCost(nrCandidates) > static_cast< uint64_t >(budget) * nrIterations) ) {
+      nrCandidates = std::max(1U, (nrCandidates * 3) / 4);
+    }
+  }
+  std::iota(candidates.begin(), candidates.end(), 0);
+  std::shuffle(candidates.begin(), candidates.end(), generator);
+  candidates.resize(nrCandidates);
+  const unsigned int nrRungs = getNrRungs(nrCandidates);
+  for ( unsigned int rung = 0; (rung < nrRungs) && !candidates.empty(); rung++ ) {
+    const unsigned int iterations = getNrIterations(rung, nrRungs);
+    std::vector< std::pair< double, unsigned int > > results;
+
+    state.announce(candidates, iterations);
+    for ( const unsigned int candidate : candidates ) {
+      if ( !state.canMeasure(candidate, iterations) ) {
+        return;
+      }
+      const double performance = state.evaluate(candidate, iterations);
+      if ( performance > 0.0 ) {
+        results.push_back(std::make_pair(performance, candidate));
+      }
+    }
+    std::stable_sort(results.begin(), results.end(), [](const std::pair< double, unsigned int > & first, const std::pair< double, unsigned int > & second) {
+      return first.first > second.first;
+    });
+    results.resize(std::min(results.size(), static_cast< std::size_t >((candidates.size() + 1) / 2)));
+    candidates.clear();
+    for ( const auto & result : results ) {
+      candidates.push_back(result.second);
+    }
+  }
+}
+
+// Inverse distance weighted model of the measured configurations, the next configuration is the one with the best predicted performance plus a bonus for being far from measured ones
+void searchSurrogate(searchState & state, const unsigned int budget, std::mt19937 & generator) {
+  std::vector< unsigned int > configurations(state.size());
+  unsigned int nrInitial = 0;
+  unsigned int nrEvaluationsWithoutImprovement = 0;
+
+  if ( budget > 0 ) {
+    nrInitial = std::max(1U, budget / 4);
+  } else {
+    nrInitial = nrSurrogateInitial;
+  }
+  nrInitial = std::min(nrInitial, state.size());
+  std::iota(configurations.begin(), configurations.end(), 0);
+  std::shuffle(configurations.begin(), configurations.end(), generator);
+  state.announce(std::vector< unsigned int >(configurations.begin(), configurations.begin() + nrInitial));
+  for ( unsigned int configuration = 0; configuration < nrInitial; configuration++ ) {
+    if ( !state.canMeasure(configurations[configuration]) ) {
+      return;
     }
-    parameters = new Integration::integrationConf();
-
-    splitPoint = temp.find(" ");
-    deviceName = temp.substr(0, splitPoint);
-    temp = temp.substr(splitPoint + 1);
-    splitPoint = temp.find(" ");
-    dim0 = isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint));
-    temp = temp.substr(splitPoint + 1);
-    splitPoint = temp.find(" ");
-    integration = isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint));
-    temp = temp.substr(splitPoint + 1);
-    splitPoint = temp.find(" ");
-    parameters->setSubbandDedispersion(isa::utils::castToType< std::string, bool >(temp.substr(0, splitPoint)));
-    temp = temp.substr(splitPoint + 1);
-    splitPoint = temp.find(" ");
-    parameters->setNrThreadsD0(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
-    temp = temp.substr(splitPoint + 1);
-    splitPoint = temp.find(" ");
-    parameters->setNrThreadsD1(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
-    temp = temp.substr(splitPoint + 1);
-    splitPoint = temp.find(" ");
-    parameters->setNrThreadsD2(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
-    temp = temp.substr(splitPoint + 1);
-    splitPoint = temp.find(" ");
-    parameters->setNrItemsD0(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
-    temp = temp.substr(splitPoint + 1);
-    splitPoint = temp.find(" ");
-    parameters->setNrItemsD1(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
-    temp = temp.substr(splitPoint + 1);
-    splitPoint = temp.find(" ");
-    parameters->setNrItemsD2(isa::utils::castToType< std::string, unsigned int >(temp.substr(0, splitPoint)));
-    temp = temp.substr(splitPoint + 1);
-    parameters->setIntType(isa::utils::castToType< std::string, unsigned int >(temp));
-
-    if ( tunedConf.count(deviceName) == 0 ) {
-      std::map< unsigned int, std::map< unsigned int, Integration::integrationConf * > * >  * externalContainer = new std::map< unsigned int, std::map< unsigned int, Integration::integrationConf * > * >();
-      std::map< unsigned int, Integration::integrationConf * > * internalContainer = new std::map< unsigned int, Integration::integrationConf * >();
-
-      internalContainer->insert(std::make_pair(integration, parameters));
-      externalContainer->insert(std::make_pair(dim0, internalContainer));
-      tunedConf.insert(std::make_pair(deviceName, externalContainer));
-    } else if ( tunedConf.at(deviceName)->count(dim0) == 0 ) {
-      std::map< unsigned int, Integration::integrationConf * > * internalContainer = new std::map< unsigned int, Integration::integrationConf * >();
-
-      internalContainer->insert(std::make_pair(integration, parameters));
-      tunedConf.at(deviceName)->insert(std::make_pair(dim0, internalContainer));
+    state.evaluate(configurations[configuration]);
+  }
+  while ( state.getNrMeasured() < state.size() ) {
+    unsigned int next = state.size();
+    double nextAcquisition = -1.0;
+
+    if ( budget == 0 && nrEvaluationsWithoutImprovement >= maxNrEvaluationsWithoutImprovement ) {
+      return;
+    }
+    for ( const unsigned int configuration : configurations ) {
+      double weights = 0.0;
+      double prediction = 0.0;
+      double minDistance = std::numeric_limits< double >::max();
+
+      if ( state.isMeasured(configuration) ) {
+        continue;
+      }
+      for ( const auto & measured : state.getPerformance() ) {
+        const double distance = state.getDistance(configuration, measured.first);
+        const double weight = 1.0 / std::max(distance * distance, std::numeric_limits< double >::min());
+
+        weights += weight;
+        prediction += weight * measured.second;
+        minDistance = std::min(minDistance, distance);
+      }
+      const double acquisition = (prediction / weights) + (surrogateExploration * state.getBestPerformance() * minDistance);
+      if ( acquisition > nextAcquisition ) {
+        next = configuration;
+        nextAcquisition = acquisition;
+      }
+    }
+    if ( (next == state.size()) || !state.canMeasure(next) ) {
+      return;
+    }
+    const double previousBest = state.getBestPerformance();
+    state.evaluate(next);
+    if ( state.getBestPerformance() > previousBest ) {
+      nrEvaluationsWithoutImprovement = 0;
     } else {
-      tunedConf.at(deviceName)->at(dim0)->insert(std::make_pair(integration, parameters));
+      nrEvaluationsWithoutImprovement++;
     }
   }
-  confFile.close();
+}
+
+} // namespace
+
+searchStrategy getSearchStrategy(const std::string & name) {
+  if ( name == "exhaustive" ) {
+    return searchStrategy::Exhaustive;
+  } else if ( name == "hill_climbing" ) {
+    return searchStrategy::HillClimbing;
+  } else if ( name == "successive_halving" ) {
+    return searchStrategy::SuccessiveHalving;
+  } else if ( name == "surrogate" ) {
+    return searchStrategy::Surrogate;
+  }
+  throw std::invalid_argument("Unknown search strategy " + name + ".");
+}
+
+unsigned int searchConfigurations(const searchStrategy strategy, const std::vector< std::vector< unsigned int > > & parameters, const unsigned int nrIterations, const unsigned int budget, const std::function< double(const unsigned int, const unsigned int, unsigned int &) > & measure, const unsigned int seed, const std::function< void(const std::vector< unsigned int > &) > & prepare) {
+  searchState state(parameters, nrIterations, budget, measure, prepare);
+  std::mt19937 generator(seed);
+
+  switch ( strategy ) {
+    case searchStrategy::Exhaustive:
+      searchExhaustive(state);
+      break;
+    case searchStrategy::HillClimbing:
+      searchHillClimbing(state, budget > 0, generator);
+      break;
+    case searchStrategy::SuccessiveHalving:
+      searchSuccessiveHalving(state, nrIterations, budget, generator);
+      break;
+    case searchStrategy::Surrogate:
+      searchSurrogate(state, budget, generator);
+      break;
+  }
+  return state.getBest();
 }
 
 } // Integration
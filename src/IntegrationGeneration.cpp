@@ -0,0 +1,153 @@
+// Copyright 2017 Netherlands Institute for Radio Astronomy (ASTRON)
+// Copyright 2017 Netherlands eScience Center
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <exception>
+#include <iomanip>
+#include <functional>
+
+#include <configuration.hpp>
+
+#include <ArgumentList.hpp>
+#include <Observation.hpp>
+#include <utils.hpp>
+#include <Integration.hpp>
+#include <Timer.hpp>
+
+
+void benchmarkGeneration(const std::string & name, const unsigned int nrIterations, const std::function< std::string() > & generator);
+
+int main(int argc, char * argv[]) {
+  unsigned int padding = 0;
+  unsigned int integration = 0;
+  unsigned int nrIterations = 0;
+  AstroData::Observation observation;
+  Integration::integrationConf conf;
+
+  try
+  {
+    isa::utils::ArgumentList args(argc, argv);
+    nrIterations = args.getSwitchArgument< unsigned int >("-iterations");
+    // Kernel configuration
+    conf.setNrThreadsD0(args.getSwitchArgument< unsigned int >("-threadsD0"));
+    conf.setNrItemsD0(args.getSwitchArgument< unsigned int >("-itemsD0"));
+    try
+    {
+      conf.setNrItemsD1(args.getSwitchArgument< unsigned int >("-itemsD1"));
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      conf.setNrItemsD1(1);
+    }
+    conf.setIntType(args.getSwitchArgument< unsigned int >("-int_type"));
+    conf.setSubgroupReduction(args.getSwitch("-subgroups"));
+    try
+    {
+      conf.setVectorWidth(args.getSwitchArgument< unsigned int >("-vector"));
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      conf.setVectorWidth(1);
+    }
+    // In-place variant, the local memory one unless -registers or -passes; passes that do not divide the integration factor fall back to one
+    if ( args.getSwitch("-registers") )
+    {
+      conf.setInPlaceVariant(Integration::integrationInPlaceVariant::Registers);
+    }
+    try
+    {
+      conf.setNrPasses(args.getSwitchArgument< unsigned int >("-passes"));
+      if ( conf.getInPlaceVariant() == Integration::integrationInPlaceVariant::Registers )
+      {
+        std::cerr << "-registers and -passes are mutually exclusive." << std::endl;
+        return 1;
+      }
+      conf.setInPlaceVariant(Integration::integrationInPlaceVariant::MultiPass);
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      conf.setNrPasses(1);
+    }
+    // Scenario
+    padding = args.getSwitchArgument< unsigned int >("-padding");
+    integration = args.getSwitchArgument< unsigned int >("-integration");
+    observation.setNrBeams(args.getSwitchArgument< unsigned int >("-beams"));
+    observation.setNrSynthesizedBeams(observation.getNrBeams());
+    observation.setNrSamplesPerBatch(args.getSwitchArgument< unsigned int >("-samples"));
+    observation.setNrSamplesPerDispersedBatch(observation.getNrSamplesPerBatch());
+    observation.setFrequencyRange(1, args.getSwitchArgument< unsigned int >("-channels"), 0.0f, 0.0f);
+    conf.setSubbandDedispersion(args.getSwitch("-subband"));
+    if ( conf.getSubbandDedispersion() )
+    {
+      observation.setDMRange(args.getSwitchArgument< unsigned int >("-subbanding_dms"), 0.0f, 0.0f, true);
+    }
+    else
+    {
+      observation.setDMRange(1, 0.0f, 0.0f, true);
+    }
+    observation.setDMRange(args.getSwitchArgument< unsigned int >("-dms"), 0.0f, 0.0f);
+  }
+  catch ( isa::utils::EmptyCommandLine & err )
+  {
+    std::cerr << argv[0] << " -iterations ... -padding ... -threadsD0 ... -itemsD0 ... [-itemsD1 ...] -int_type ... [-subgroups] [-vector ...] [-registers | -passes ...] -integration ... [-subband] -beams ... -channels ... -samples ... -dms ..." << std::endl;
+    std::cerr << "\t -subband : -subbanding_dms ..." << std::endl;
+    return 1;
+  }
+  catch ( std::exception & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << std::fixed << std::endl;
+  std::cout << "# kernel size time stdDeviation COV" << std::endl << std::endl;
+  benchmarkGeneration("integration" + std::to_string(integration) + " (before dedispersion)", nrIterations, [&]() { return Integration::getIntegrationBeforeDedispersionInPlaceOpenCL<BeforeDedispersionNumericType>(conf, observation, BeforeDedispersionDataName, integration, padding); });
+  benchmarkGeneration("integrationBeforeDedispersion" + std::to_string(integration), nrIterations, [&]() { return Integration::getIntegrationBeforeDedispersionOpenCL<BeforeDedispersionNumericType>(conf, observation, BeforeDedispersionDataName, integration, padding); });
+  benchmarkGeneration("integration" + std::to_string(integration) + " (after dedispersion)", nrIterations, [&]() { return Integration::getIntegrationAfterDedispersionInPlaceOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding); });
+  benchmarkGeneration("integrationDMsSamples" + std::to_string(integration), nrIterations, [&]() { return Integration::getIntegrationDMsSamplesOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding); });
+  benchmarkGeneration("integrationSamplesDMs" + std::to_string(integration), nrIterations, [&]() { return Integration::getIntegrationSamplesDMsOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding); });
+  benchmarkGeneration("integrationDMsSamplesStream" + std::to_string(integration), nrIterations, [&]() { return Integration::getIntegrationDMsSamplesStreamOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding); });
+  benchmarkGeneration("integrationDMsSamplesToSamplesDMs" + std::to_string(integration), nrIterations, [&]() { return Integration::getIntegrationDMsSamplesToSamplesDMsOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding); });
+  benchmarkGeneration("integrationSamplesDMsToDMsSamples" + std::to_string(integration), nrIterations, [&]() { return Integration::getIntegrationSamplesDMsToDMsSamplesOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding); });
+  const std::vector< unsigned int > integrations = Integration::getPowerOfTwoIntegrations(integration);
+  if ( !integrations.empty() )
+  {
+    benchmarkGeneration("integrationDMsSamplesPyramid" + std::to_string(integrations.back()), nrIterations, [&]() { return Integration::getIntegrationDMsSamplesPyramidOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integrations, padding); });
+    benchmarkGeneration("integrationDMsSamplesBoxcar" + std::to_string(integrations.back()), nrIterations, [&]() { return Integration::getIntegrationDMsSamplesBoxcarOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integrations, padding); });
+  }
+
+  return 0;
+}
+
+void benchmarkGeneration(const std::string & name, const unsigned int nrIterations, const std::function< std::string() > & generator)
+{
+  isa::utils::Timer timer;
+  std::size_t size = 0;
+
+  for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ )
+  {
+    timer.start();
+    std::string code = generator();
+    timer.stop();
+    size = code.size();
+  }
+  std::cout << name << " " << size << " ";
+  std::cout << std::setprecision(9);
+  std::cout << timer.getAverageTime() << " " << timer.getStandardDeviation() << " ";
+  std::cout << std::setprecision(3);
+  std::cout << timer.getCoefficientOfVariation() << std::endl;
+}
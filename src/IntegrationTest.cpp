@@ -18,6 +18,16 @@
 #include <vector>
 #include <exception>
 #include <ctime>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <tuple>
+#include <cstdio>
+#include <cctype>
+#include <random>
 
 #include <configuration.hpp>
 
@@ -28,6 +38,36 @@
 #include <utils.hpp>
 #include <Integration.hpp>
 
+// Fill a DMs-samples input with the test data
+void generateDMsSamplesInput(const AstroData::Observation & observation, const unsigned int padding, const bool random, std::vector<AfterDedispersionNumericType> & input);
+// Test the single-pass multi-factor mode against the CPU pyramid and the single factor CPU implementation
+int testPyramid(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const std::vector<unsigned int> & integrations, const unsigned int padding, const bool random, const bool printCode);
+// Test the sliding-window mode against the CPU boxcar, on data with a fractional part and a large offset
+int testBoxcar(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const std::vector<unsigned int> & widths, const unsigned int padding, const bool random, const bool printCode);
+// Test the integrate-and-transpose mode against the CPU, DMsSamples is the layout of the input
+int testTranspose(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const bool DMsSamples, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode);
+// Test the streaming mode, on the host and on the device, against the integration of the whole stream at once
+int testStream(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const unsigned int nrBatches, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode);
+// Test the double-buffered pipeline, every batch and the order of completion, against the CPU
+int testPipeline(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const unsigned int nrBatches, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode);
+// Test the out-of-place before dedispersion mode against the CPU, and check that the input is left untouched
+int testBeforeDedispersion(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode);
+// Test the kernels writing the output as O against the CPU, DMsSamples is the layout; a sample is wrong if it differs by more than one unit in the last place
+template<typename O>
+int testOutputType(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const bool DMsSamples, const std::string & outputDataName, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode);
+// Test the statistics of every beam and DM written by the kernels with statistics against the CPU, the index of the maximum exactly and the rest within a relative tolerance
+int testStatistics(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const Integration::integrationMode mode, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode);
+// Test the candidates appended by the kernels with candidates against the CPU, in any order, and that the number of candidates found is counted past the maximum
+int testCandidates(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const bool DMsSamples, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode);
+// Test a configuration file against its binary cache, with every line looked up in both, and check that corrupted or truncated caches are rejected; does not use OpenCL
+int testTunedConf(const std::string & confFilename);
+// Test the guided search strategies on synthetic landscapes shaped like the tuner's, the best configuration found with a small budget must be close to the optimum and the kernel runs within the budget; does not use OpenCL
+int testSearch();
+// Distance between two outputs in units of the last place
+template<typename O>
+unsigned int getOutputDistance(const O first, const O second);
+unsigned int getOutputDistance(const Integration::integrationHalf first, const Integration::integrationHalf second);
+
 
 int main(int argc, char *argv[]) {
   bool printCode = false;
@@ -41,12 +81,38 @@ int main(int argc, char *argv[]) {
   unsigned int clPlatformID = 0;
   unsigned int clDeviceID = 0;
   uint64_t wrongSamples = 0;
+  uint64_t wrongSamplesParallel = 0;
   Integration::integrationConf conf;
+  Integration::integrationCPUConf cpuConf;
+  bool testParallel = false;
+  bool testVectorized = false;
+  uint64_t wrongSamplesVectorized = 0;
+  bool pyramid = false;
+  bool boxcar = false;
+  unsigned int nrBatches = 0;
+  unsigned int nrPipelineBatches = 0;
+  bool transpose = false;
+  std::string outputType;
+  std::vector<unsigned int> integrations;
+  std::string kernelCacheDirectory;
   AstroData::Observation observation;
 
   try
   {
     isa::utils::ArgumentList args(argc, argv);
+    // Configuration files
+    try
+    {
+      return testTunedConf(args.getSwitchArgument< std::string >("-tuned_conf"));
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+    }
+    // Search strategies
+    if ( args.getSwitch("-search") )
+    {
+      return testSearch();
+    }
     // Modes
     inPlace = args.getSwitch("-in_place");
     if ( inPlace )
@@ -61,30 +127,209 @@ int main(int argc, char *argv[]) {
     }
     else
     {
+      // Out-of-place before dedispersion, the output is a separate buffer
+      beforeDedispersion = args.getSwitch("-before_dedispersion");
       DMsSamples = args.getSwitch("-dms_samples");
       bool samplesDMs = args.getSwitch("-samples_dms");
-      if ( (DMsSamples && samplesDMs) || (!DMsSamples && !samplesDMs) )
+      if ( !beforeDedispersion && ((DMsSamples && samplesDMs) || (!DMsSamples && !samplesDMs)) )
       {
         std::cerr << "-dms_samples and -samples_dms are mutually exclusive." << std::endl;
         return 1;
       }
+      else if ( beforeDedispersion && (DMsSamples || samplesDMs) )
+      {
+        std::cerr << "-before_dedispersion is not available with -dms_samples and -samples_dms." << std::endl;
+        return 1;
+      }
     }
     printCode = args.getSwitch("-print_code");
     printResults = args.getSwitch("-print_results");
     random = args.getSwitch("-random");
+    // Parallel CPU implementation, tested against the sequential one
+    try
+    {
+      cpuConf.setNrThreads(args.getSwitchArgument< unsigned int >("-cpu_threads"));
+      cpuConf.setDynamicScheduling(args.getSwitch("-cpu_dynamic"));
+      testParallel = true;
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      testParallel = false;
+    }
+    // Vectorized CPU implementation, tested against the sequential one
+    testVectorized = args.getSwitch("-cpu_vectorized");
+    // Multi-factor integration, all levels from a single read of the input
+    pyramid = args.getSwitch("-pyramid");
+    // Non-decimated sums, integration is the width of the window
+    boxcar = args.getSwitch("-boxcar");
+    if ( (pyramid || boxcar) && !DMsSamples )
+    {
+      std::cerr << "-pyramid and -boxcar are only available with -dms_samples." << std::endl;
+      return 1;
+    }
+    if ( pyramid && boxcar )
+    {
+      std::cerr << "-pyramid and -boxcar are mutually exclusive." << std::endl;
+      return 1;
+    }
+    // Stream of batches, samples is the size of each batch and does not need to be a multiple of integration
+    try
+    {
+      nrBatches = args.getSwitchArgument< unsigned int >("-stream");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      nrBatches = 0;
+    }
+    if ( nrBatches > 0 && (!DMsSamples || pyramid || boxcar) )
+    {
+      std::cerr << "-stream is only available with -dms_samples, without -pyramid and -boxcar." << std::endl;
+      return 1;
+    }
+    // Batches integrated by the double-buffered pipeline
+    try
+    {
+      nrPipelineBatches = args.getSwitchArgument< unsigned int >("-pipeline");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      nrPipelineBatches = 0;
+    }
+    if ( nrPipelineBatches > 0 && (!DMsSamples || pyramid || boxcar || nrBatches > 0) )
+    {
+      std::cerr << "-pipeline is only available with -dms_samples, without -pyramid, -boxcar and -stream." << std::endl;
+      return 1;
+    }
+    // Output in the other layout
+    transpose = args.getSwitch("-transpose");
+    if ( transpose && (inPlace || beforeDedispersion || pyramid || boxcar || nrBatches > 0 || nrPipelineBatches > 0) )
+    {
+      std::cerr << "-transpose is not available with -in_place, -before_dedispersion, -pyramid, -boxcar, -stream and -pipeline." << std::endl;
+      return 1;
+    }
+    // Output narrower than the input
+    try
+    {
+      outputType = args.getSwitchArgument< std::string >("-output_type");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      outputType = std::string();
+    }
+    if ( !outputType.empty() && (inPlace || beforeDedispersion || pyramid || boxcar || nrBatches > 0 || nrPipelineBatches > 0 || transpose) )
+    {
+      std::cerr << "-output_type is not available with -in_place, -before_dedispersion, -pyramid, -boxcar, -stream, -pipeline and -transpose." << std::endl;
+      return 1;
+    }
+    // Statistics of every beam and DM, written with the integrated samples
+    conf.setStatistics(args.getSwitch("-statistics"));
+    if ( conf.getStatistics() && (beforeDedispersion || pyramid || boxcar || nrBatches > 0 || nrPipelineBatches > 0 || transpose || !outputType.empty()) )
+    {
+      std::cerr << "-statistics is not available with -before_dedispersion, -pyramid, -boxcar, -stream, -pipeline, -transpose and -output_type." << std::endl;
+      return 1;
+    }
+    // Integrated samples above a threshold, appended to a list of candidates
+    try
+    {
+      conf.setMaxCandidates(args.getSwitchArgument< unsigned int >("-candidates"));
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      conf.setMaxCandidates(0);
+    }
+    if ( conf.getMaxCandidates() > 0 && (inPlace || beforeDedispersion || pyramid || boxcar || nrBatches > 0 || nrPipelineBatches > 0 || transpose || !outputType.empty() || conf.getStatistics()) )
+    {
+      std::cerr << "-candidates is only available with -dms_samples or -samples_dms, without -pyramid, -boxcar, -stream, -pipeline, -transpose, -output_type and -statistics." << std::endl;
+      return 1;
+    }
     // OpenCL
     clPlatformID = args.getSwitchArgument< unsigned int >("-opencl_platform");
     clDeviceID = args.getSwitchArgument< unsigned int >("-opencl_device");
+    try
+    {
+      kernelCacheDirectory = args.getSwitchArgument< std::string >("-kernel_cache");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      kernelCacheDirectory = std::string();
+    }
     // Configuration
     conf.setNrThreadsD0(args.getSwitchArgument< unsigned int >("-threadsD0"));
     conf.setNrItemsD0(args.getSwitchArgument< unsigned int >("-itemsD0"));
+    if ( transpose )
+    {
+      conf.setNrItemsD1(args.getSwitchArgument< unsigned int >("-itemsD1"));
+    }
     conf.setIntType(args.getSwitchArgument<unsigned int>("-int_type"));
+    conf.setSubgroupReduction(args.getSwitch("-subgroups"));
+    try
+    {
+      conf.setVectorWidth(args.getSwitchArgument< unsigned int >("-vector"));
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      conf.setVectorWidth(1);
+    }
+    // In-place variant, the local memory one unless -registers or -passes; passes that do not divide the integration factor fall back to one
+    if ( args.getSwitch("-registers") )
+    {
+      conf.setInPlaceVariant(Integration::integrationInPlaceVariant::Registers);
+    }
+    try
+    {
+      conf.setNrPasses(args.getSwitchArgument< unsigned int >("-passes"));
+      if ( conf.getInPlaceVariant() == Integration::integrationInPlaceVariant::Registers )
+      {
+        std::cerr << "-registers and -passes are mutually exclusive." << std::endl;
+        return 1;
+      }
+      conf.setInPlaceVariant(Integration::integrationInPlaceVariant::MultiPass);
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      conf.setNrPasses(1);
+    }
     // Scenario
     padding = args.getSwitchArgument< unsigned int >("-padding");
-    integration = args.getSwitchArgument< unsigned int >("-integration");
+    if ( pyramid || boxcar )
+    {
+      try
+      {
+        std::string levels = args.getSwitchArgument< std::string >("-integrations");
+        std::string::size_type begin = 0;
+
+        while ( begin < levels.size() )
+        {
+          std::string::size_type end = levels.find(',', begin);
+
+          if ( end == std::string::npos )
+          {
+            end = levels.size();
+          }
+          integrations.push_back(isa::utils::castToType< std::string, unsigned int >(levels.substr(begin, end - begin)));
+          begin = end + 1;
+        }
+      }
+      catch ( isa::utils::SwitchNotFound & err )
+      {
+        if ( pyramid )
+        {
+          integrations = Integration::getPowerOfTwoIntegrations(args.getSwitchArgument< unsigned int >("-integration"));
+        }
+        else
+        {
+          integrations.push_back(args.getSwitchArgument< unsigned int >("-integration"));
+        }
+      }
+      integration = integrations.empty() ? 0 : integrations.back();
+    }
+    else
+    {
+      integration = args.getSwitchArgument< unsigned int >("-integration");
+    }
     observation.setNrSynthesizedBeams(args.getSwitchArgument< unsigned int >("-beams"));
     observation.setNrSamplesPerBatch(args.getSwitchArgument< unsigned int >("-samples"));
-    if ( inPlace && beforeDedispersion )
+    if ( beforeDedispersion )
     {
       observation.setFrequencyRange(1, args.getSwitchArgument<unsigned int>("-channels"), 0.0f, 0.0f);
       observation.setNrBeams(observation.getNrSynthesizedBeams());
@@ -119,10 +364,15 @@ int main(int argc, char *argv[]) {
   }
   catch ( std::exception & err )
   {
-    std::cerr << "Usage: " << argv[0] << " [-in_place] [-dms_samples | -samples_dms] [-print_code] [-print_results] [-random] -opencl_platform ... -opencl_device ... -padding ... -int_type ... -integration ... -threadsD0 ... -itemsD0 ... [-subband] -beams ... -samples ... -dms ..." << std::endl;
+    std::cerr << "Usage: " << argv[0] << " [-in_place] [-dms_samples | -samples_dms | -before_dedispersion] [-print_code] [-print_results] [-random] [-cpu_threads ... [-cpu_dynamic]] [-cpu_vectorized] [-pyramid | -boxcar | -stream ... | -pipeline ... | -transpose | -output_type ...] [-statistics | -candidates ...] -opencl_platform ... -opencl_device ... [-kernel_cache ...] -padding ... -int_type ... [-subgroups] [-vector ...] [-registers | -passes ...] -integration ... -threadsD0 ... -itemsD0 ... [-subband] -beams ... -samples ... -dms ..." << std::endl;
+    std::cerr << "       " << argv[0] << " -tuned_conf ..." << std::endl;
+    std::cerr << "       " << argv[0] << " -search" << std::endl;
     std::cerr << " -subband -subbanding_dms ..." << std::endl;
     std::cerr << " -in_place [-before_dedispersion | -after_dedispersion]" << std::endl;
     std::cerr << " -before_dedispersion -channels ..." << std::endl;
+    std::cerr << " -dms_samples -pyramid [-integration ... | -integrations ...,...,...]" << std::endl;
+    std::cerr << " -dms_samples -boxcar [-integration ... | -integrations ...,...,...]" << std::endl;
+    std::cerr << " -transpose -itemsD1 ..." << std::endl;
     return 1;
   }
 
@@ -131,6 +381,78 @@ int main(int argc, char *argv[]) {
 
   isa::OpenCL::initializeOpenCL(clPlatformID, 1, openCLRunTime);
 
+  if ( pyramid )
+  {
+    if ( !Integration::isValidIntegrationPyramid(integrations, observation.getNrSamplesPerBatch()) )
+    {
+      std::cerr << "Integration factors must be increasing, each one must divide the next, and the last one must divide the number of samples." << std::endl;
+      return 1;
+    }
+    return testPyramid(openCLRunTime, clDeviceID, conf, observation, integrations, padding, random, printCode);
+  }
+  else if ( boxcar )
+  {
+    if ( !Integration::isValidIntegrationBoxcar(integrations, observation.getNrSamplesPerBatch()) )
+    {
+      std::cerr << "Boxcar widths must be increasing, the first one must be at least 1, and the last one must not be larger than the number of samples." << std::endl;
+      return 1;
+    }
+    return testBoxcar(openCLRunTime, clDeviceID, conf, observation, integrations, padding, random, printCode);
+  }
+  else if ( nrBatches > 0 )
+  {
+    return testStream(openCLRunTime, clDeviceID, conf, observation, nrBatches, integration, padding, random, printCode);
+  }
+  else if ( nrPipelineBatches > 0 )
+  {
+    return testPipeline(openCLRunTime, clDeviceID, conf, observation, nrPipelineBatches, integration, padding, random, printCode);
+  }
+  else if ( beforeDedispersion && !inPlace )
+  {
+    return testBeforeDedispersion(openCLRunTime, clDeviceID, conf, observation, integration, padding, random, printCode);
+  }
+  else if ( transpose )
+  {
+    return testTranspose(openCLRunTime, clDeviceID, conf, observation, DMsSamples, integration, padding, random, printCode);
+  }
+  else if ( outputType == "half" )
+  {
+    return testOutputType<Integration::integrationHalf>(openCLRunTime, clDeviceID, conf, observation, DMsSamples, outputType, integration, padding, random, printCode);
+  }
+  else if ( outputType == "char" )
+  {
+    return testOutputType<int8_t>(openCLRunTime, clDeviceID, conf, observation, DMsSamples, outputType, integration, padding, random, printCode);
+  }
+  else if ( outputType == "uchar" )
+  {
+    return testOutputType<uint8_t>(openCLRunTime, clDeviceID, conf, observation, DMsSamples, outputType, integration, padding, random, printCode);
+  }
+  else if ( outputType == "short" )
+  {
+    return testOutputType<int16_t>(openCLRunTime, clDeviceID, conf, observation, DMsSamples, outputType, integration, padding, random, printCode);
+  }
+  else if ( outputType == "ushort" )
+  {
+    return testOutputType<uint16_t>(openCLRunTime, clDeviceID, conf, observation, DMsSamples, outputType, integration, padding, random, printCode);
+  }
+  else if ( !outputType.empty() )
+  {
+    std::cerr << "Output type must be half, char, uchar, short, or ushort." << std::endl;
+    return 1;
+  }
+  else if ( conf.getMaxCandidates() > 0 )
+  {
+    return testCandidates(openCLRunTime, clDeviceID, conf, observation, DMsSamples, integration, padding, random, printCode);
+  }
+  else if ( conf.getStatistics() )
+  {
+    if ( inPlace )
+    {
+      return testStatistics(openCLRunTime, clDeviceID, conf, observation, Integration::integrationMode::AfterDedispersionInPlace, integration, padding, random, printCode);
+    }
+    return testStatistics(openCLRunTime, clDeviceID, conf, observation, DMsSamples ? Integration::integrationMode::DMsSamples : Integration::integrationMode::SamplesDMs, integration, padding, random, printCode);
+  }
+
   // Allocate memory
   cl::Buffer input_d;
   cl::Buffer output_d;
@@ -324,41 +646,37 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  // Generate kernel
-  std::string * code;
+  // Generate and compile kernel
+  Integration::integrationMode mode = Integration::integrationMode::SamplesDMs;
   if ( inPlace && beforeDedispersion )
   {
-    code = Integration::getIntegrationBeforeDedispersionInPlaceOpenCL<BeforeDedispersionNumericType>(conf, observation, BeforeDedispersionDataName, integration, padding);
+    mode = Integration::integrationMode::BeforeDedispersionInPlace;
   }
-  else if ( inPlace && !beforeDedispersion )
+  else if ( inPlace )
   {
-    code = Integration::getIntegrationAfterDedispersionInPlaceOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
+    mode = Integration::integrationMode::AfterDedispersionInPlace;
   }
   else if ( DMsSamples )
   {
-    code = Integration::getIntegrationDMsSamplesOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
+    mode = Integration::integrationMode::DMsSamples;
   }
-  else
-  {
-    code = Integration::getIntegrationSamplesDMsOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
-  }
-  cl::Kernel * kernel;
+  Integration::integrationPlan<BeforeDedispersionNumericType> planBefore(conf, observation, mode, BeforeDedispersionDataName, integration, padding);
+  Integration::integrationPlan<AfterDedispersionNumericType> planAfter(conf, observation, mode, AfterDedispersionDataName, integration, padding);
+  Integration::kernelCache kernels(kernelCacheDirectory);
   if ( printCode ) {
-    std::cout << *code << std::endl;
+    std::cout << ((inPlace && beforeDedispersion) ? planBefore.getCode() : planAfter.getCode()) << std::endl;
   }
   try
   {
-    if ( inPlace )
-    {
-      kernel = isa::OpenCL::compile("integration" + std::to_string(integration), *code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
-    }
-    else if ( DMsSamples )
+    if ( inPlace && beforeDedispersion )
     {
-      kernel = isa::OpenCL::compile("integrationDMsSamples" + std::to_string(integration), *code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+      planBefore.compile(*(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID), &kernels);
+      planBefore.bind(input_d);
     }
     else
     {
-      kernel = isa::OpenCL::compile("integrationSamplesDMs" + std::to_string(integration), *code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+      planAfter.compile(*(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID), &kernels);
+      planAfter.bind(input_d, output_d);
     }
   }
   catch ( isa::OpenCL::OpenCLError & err )
@@ -369,9 +687,6 @@ int main(int argc, char *argv[]) {
 
   // Run OpenCL kernel and CPU control
   try {
-    cl::NDRange global;
-    cl::NDRange local;
-
     if ( inPlace && beforeDedispersion )
     {
       Integration::integrationBeforeDedispersion(observation, integration, padding, input_before, output_control_before);
@@ -384,33 +699,78 @@ int main(int argc, char *argv[]) {
     {
       Integration::integrationSamplesDMs(conf.getSubbandDedispersion(), observation, integration, padding, input_after, output_control_after);
     }
-    if ( inPlace && beforeDedispersion )
+    if ( testParallel )
     {
-      global = cl::NDRange(conf.getNrThreadsD0(), observation.getNrChannels(), observation.getNrBeams());
-      local = cl::NDRange(conf.getNrThreadsD0(), 1, 1);
+      Integration::threadPool pool(cpuConf.getNrThreads());
+
+      if ( inPlace && beforeDedispersion )
+      {
+        std::vector<BeforeDedispersionNumericType> output_parallel(output_control_before.size());
+
+        Integration::integrationBeforeDedispersionParallel(pool, cpuConf, observation, integration, padding, input_before, output_parallel);
+        for ( uint64_t item = 0; item < output_parallel.size(); item++ )
+        {
+          if ( output_parallel[item] != output_control_before[item] )
+          {
+            wrongSamplesParallel++;
+          }
+        }
+      }
+      else
+      {
+        std::vector<AfterDedispersionNumericType> output_parallel(output_control_after.size());
+
+        if ( (inPlace && !beforeDedispersion) || DMsSamples )
+        {
+          Integration::integrationDMsSamplesParallel(pool, cpuConf, conf.getSubbandDedispersion(), observation, integration, padding, input_after, output_parallel);
+        }
+        else
+        {
+          Integration::integrationSamplesDMsParallel(pool, cpuConf, conf.getSubbandDedispersion(), observation, integration, padding, input_after, output_parallel);
+        }
+        for ( uint64_t item = 0; item < output_parallel.size(); item++ )
+        {
+          if ( output_parallel[item] != output_control_after[item] )
+          {
+            wrongSamplesParallel++;
+          }
+        }
+      }
     }
-    else if ( inPlace && !beforeDedispersion )
+    if ( testVectorized && inPlace && beforeDedispersion )
     {
-      global = cl::NDRange(conf.getNrThreadsD0(), observation.getNrDMs(true) * observation.getNrDMs(), observation.getNrSynthesizedBeams());
-      local = cl::NDRange(conf.getNrThreadsD0(), 1, 1);
+      std::vector<BeforeDedispersionNumericType> output_vectorized(output_control_before.size());
+
+      Integration::integrationBeforeDedispersionVectorized(observation, integration, padding, input_before, output_vectorized);
+      for ( uint64_t item = 0; item < output_vectorized.size(); item++ )
+      {
+        if ( output_vectorized[item] != output_control_before[item] )
+        {
+          wrongSamplesVectorized++;
+        }
+      }
     }
-    else if ( DMsSamples )
+    else if ( testVectorized && !inPlace && !DMsSamples )
     {
-      global = cl::NDRange(conf.getNrThreadsD0() * ((observation.getNrSamplesPerBatch() / integration) / conf.getNrItemsD0()), observation.getNrDMs(true) * observation.getNrDMs(), observation.getNrSynthesizedBeams());
-      local = cl::NDRange(conf.getNrThreadsD0(), 1, 1);
+      std::vector<AfterDedispersionNumericType> output_vectorized(output_control_after.size());
+
+      Integration::integrationSamplesDMsVectorized(conf.getSubbandDedispersion(), observation, integration, padding, input_after, output_vectorized);
+      for ( uint64_t item = 0; item < output_vectorized.size(); item++ )
+      {
+        if ( output_vectorized[item] != output_control_after[item] )
+        {
+          wrongSamplesVectorized++;
+        }
+      }
     }
-    else
+    if ( inPlace && beforeDedispersion )
     {
-      global = cl::NDRange((observation.getNrDMs(true) * observation.getNrDMs()) / conf.getNrItemsD0(), observation.getNrSamplesPerBatch() / integration, observation.getNrSynthesizedBeams());
-      local = cl::NDRange(conf.getNrThreadsD0(), 1, 1);
+      planBefore.execute(openCLRunTime.queues->at(clDeviceID)[0]);
     }
-
-    kernel->setArg(0, input_d);
-    if ( !inPlace )
+    else
     {
-      kernel->setArg(1, output_d);
+      planAfter.execute(openCLRunTime.queues->at(clDeviceID)[0]);
     }
-    openCLRunTime.queues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local);
     if ( inPlace && beforeDedispersion )
     {
       openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(input_d, CL_TRUE, 0, input_before.size() * sizeof(BeforeDedispersionNumericType), reinterpret_cast< void * >(input_before.data()));
@@ -549,6 +909,28 @@ int main(int argc, char *argv[]) {
   }
 
   // Output
+  if ( testParallel )
+  {
+    if ( wrongSamplesParallel > 0 )
+    {
+      std::cout << "Wrong samples (parallel CPU): " << wrongSamplesParallel << "." << std::endl;
+    }
+    else
+    {
+      std::cout << "Parallel CPU output identical to sequential." << std::endl;
+    }
+  }
+  if ( testVectorized && ((inPlace && beforeDedispersion) || (!inPlace && !DMsSamples)) )
+  {
+    if ( wrongSamplesVectorized > 0 )
+    {
+      std::cout << "Wrong samples (vectorized CPU, " << Integration::getVectorInstructionSet() << "): " << wrongSamplesVectorized << "." << std::endl;
+    }
+    else
+    {
+      std::cout << "Vectorized CPU output (" << Integration::getVectorInstructionSet() << ") identical to sequential." << std::endl;
+    }
+  }
   if ( wrongSamples > 0 )
   {
     if ( inPlace && beforeDedispersion )
@@ -567,3 +949,1287 @@ int main(int argc, char *argv[]) {
 
   return 0;
 }
+
+int testPyramid(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const std::vector<unsigned int> & integrations, const unsigned int padding, const bool random, const bool printCode) {
+  uint64_t wrongSamples = 0;
+  uint64_t wrongSamplesSingle = 0;
+  const unsigned int nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+  const std::vector<uint64_t> offsets = Integration::getIntegrationPyramidOffsets<AfterDedispersionNumericType>(conf.getSubbandDedispersion(), observation, integrations, padding);
+  std::vector<AfterDedispersionNumericType> input;
+  std::vector<AfterDedispersionNumericType> output(offsets.back());
+  std::vector<AfterDedispersionNumericType> output_control(offsets.back());
+  cl::Buffer input_d;
+  cl::Buffer output_d;
+
+  srand(time(0));
+  generateDMsSamplesInput(observation, padding, random, input);
+  std::string code = Integration::getIntegrationDMsSamplesPyramidOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integrations, padding);
+  cl::Kernel * kernel;
+
+  if ( printCode )
+  {
+    std::cout << code << std::endl;
+  }
+  try
+  {
+    kernel = isa::OpenCL::compile("integrationDMsSamplesPyramid" + std::to_string(integrations.back()), code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  try
+  {
+    cl::NDRange global(conf.getNrThreadsD0() * static_cast< unsigned int >(std::ceil(static_cast< float >(observation.getNrSamplesPerBatch()) / (integrations.back() * conf.getNrItemsD0()))), nrDMs, observation.getNrSynthesizedBeams());
+    cl::NDRange local(conf.getNrThreadsD0(), 1, 1);
+
+    input_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_WRITE, input.size() * sizeof(AfterDedispersionNumericType), 0, 0);
+    output_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_WRITE, output.size() * sizeof(AfterDedispersionNumericType), 0, 0);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(input_d, CL_FALSE, 0, input.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(input.data()), 0, 0);
+    kernel->setArg(0, input_d);
+    kernel->setArg(1, output_d);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(output.data()));
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error kernel execution: " << std::to_string(err.err()) << "." << std::endl;
+    return 1;
+  }
+  delete kernel;
+
+  // Every level must match both the CPU pyramid and the single factor CPU implementation
+  Integration::integrationDMsSamplesPyramid(conf.getSubbandDedispersion(), observation, integrations, padding, input, output_control);
+  for ( unsigned int level = 0; level < integrations.size(); level++ )
+  {
+    const unsigned int nrOutputSamples = observation.getNrSamplesPerBatch() / integrations.at(level);
+    std::vector<AfterDedispersionNumericType> output_single(observation.getNrSynthesizedBeams() * nrDMs * isa::utils::pad(nrOutputSamples, padding / sizeof(AfterDedispersionNumericType)));
+
+    Integration::integrationDMsSamples(conf.getSubbandDedispersion(), observation, integrations.at(level), padding, input, output_single);
+    for ( unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++ )
+    {
+      for ( unsigned int sample = 0; sample < nrOutputSamples; sample++ )
+      {
+        const uint64_t item = (row * isa::utils::pad(nrOutputSamples, padding / sizeof(AfterDedispersionNumericType))) + sample;
+
+        if ( !isa::utils::same(output_control.at(offsets.at(level) + item), output.at(offsets.at(level) + item)) )
+        {
+          wrongSamples++;
+        }
+        if ( !isa::utils::same(output_control.at(offsets.at(level) + item), output_single.at(item)) )
+        {
+          wrongSamplesSingle++;
+        }
+      }
+    }
+  }
+
+  if ( wrongSamplesSingle > 0 )
+  {
+    std::cout << "Wrong samples (CPU pyramid vs single factor): " << wrongSamplesSingle << "." << std::endl;
+  }
+  if ( wrongSamples > 0 )
+  {
+    std::cout << "Wrong samples: " << wrongSamples << " (" << (wrongSamples * 100.0) / (offsets.back()) << "%)." << std::endl;
+  }
+  else
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+int testBoxcar(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const std::vector<unsigned int> & widths, const unsigned int padding, const bool random, const bool printCode) {
+  uint64_t wrongSamples = 0;
+  uint64_t nrOutputSamples = 0;
+  const unsigned int nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+  const std::vector<uint64_t> offsets = Integration::getIntegrationBoxcarOffsets<AfterDedispersionNumericType>(conf.getSubbandDedispersion(), observation, widths, padding);
+  std::vector<AfterDedispersionNumericType> input;
+  std::vector<AfterDedispersionNumericType> output(offsets.back());
+  std::vector<AfterDedispersionNumericType> output_control(offsets.back());
+  cl::Buffer input_d;
+  cl::Buffer output_d;
+
+  srand(time(0));
+  generateDMsSamplesInput(observation, padding, random, input);
+  // A running window without compensation would lose the fractional part next to the offset
+  if ( std::is_floating_point<AfterDedispersionNumericType>::value )
+  {
+    for ( auto & sample : input )
+    {
+      sample = static_cast<AfterDedispersionNumericType>((sample * 0.125) + 65536);
+    }
+  }
+  std::string code = Integration::getIntegrationDMsSamplesBoxcarOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, widths, padding);
+  cl::Kernel * kernel;
+
+  if ( printCode )
+  {
+    std::cout << code << std::endl;
+  }
+  try
+  {
+    kernel = isa::OpenCL::compile("integrationDMsSamplesBoxcar" + std::to_string(widths.back()), code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  try
+  {
+    const unsigned int nrOutputSamplesPerGroup = conf.getNrThreadsD0() * conf.getNrItemsD0();
+    cl::NDRange global(conf.getNrThreadsD0() * ((Integration::getNrBoxcarSamples(observation, widths.front()) + nrOutputSamplesPerGroup - 1) / nrOutputSamplesPerGroup), nrDMs, observation.getNrSynthesizedBeams());
+    cl::NDRange local(conf.getNrThreadsD0(), 1, 1);
+
+    input_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_WRITE, input.size() * sizeof(AfterDedispersionNumericType), 0, 0);
+    output_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_WRITE, output.size() * sizeof(AfterDedispersionNumericType), 0, 0);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(input_d, CL_FALSE, 0, input.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(input.data()), 0, 0);
+    kernel->setArg(0, input_d);
+    kernel->setArg(1, output_d);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(output.data()));
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error kernel execution: " << std::to_string(err.err()) << "." << std::endl;
+    return 1;
+  }
+  delete kernel;
+
+  Integration::integrationDMsSamplesBoxcar(conf.getSubbandDedispersion(), observation, widths, padding, input, output_control);
+  for ( unsigned int width = 0; width < widths.size(); width++ )
+  {
+    for ( unsigned int row = 0; row < observation.getNrSynthesizedBeams() * nrDMs; row++ )
+    {
+      for ( unsigned int sample = 0; sample < Integration::getNrBoxcarSamples(observation, widths.at(width)); sample++ )
+      {
+        const uint64_t item = offsets.at(width) + (row * observation.getNrSamplesPerBatch(false, padding / sizeof(AfterDedispersionNumericType))) + sample;
+
+        if ( !isa::utils::same(output_control.at(item), output.at(item)) )
+        {
+          wrongSamples++;
+        }
+        nrOutputSamples++;
+      }
+    }
+  }
+
+  if ( wrongSamples > 0 )
+  {
+    std::cout << "Wrong samples: " << wrongSamples << " (" << (wrongSamples * 100.0) / nrOutputSamples << "%)." << std::endl;
+  }
+  else
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+int testStream(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const unsigned int nrBatches, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode) {
+  uint64_t wrongSamples = 0;
+  uint64_t wrongSamplesHost = 0;
+  uint64_t nrOutputSamples = 0;
+  const unsigned int nrRows = observation.getNrSynthesizedBeams() * observation.getNrDMs(true) * observation.getNrDMs();
+  const unsigned int inputRowSize = observation.getNrSamplesPerBatch(false, padding / sizeof(AfterDedispersionNumericType));
+  Integration::streamingIntegration<AfterDedispersionNumericType> hostStream(conf.getSubbandDedispersion(), observation, integration, padding);
+  Integration::streamingIntegration<AfterDedispersionNumericType> deviceStream(conf.getSubbandDedispersion(), observation, integration, padding);
+  const unsigned int outputRowSize = isa::utils::pad(hostStream.getMaxNrOutputSamples(), padding / sizeof(AfterDedispersionNumericType));
+  std::vector<std::vector<AfterDedispersionNumericType>> input(nrBatches);
+  std::vector<AfterDedispersionNumericType> output(nrRows * outputRowSize);
+  std::vector<AfterDedispersionNumericType> output_host(nrRows * outputRowSize);
+  cl::Buffer input_d;
+  cl::Buffer output_d;
+
+  srand(time(0));
+  for ( unsigned int batch = 0; batch < nrBatches; batch++ )
+  {
+    generateDMsSamplesInput(observation, padding, random, input.at(batch));
+  }
+  std::string code = Integration::getIntegrationDMsSamplesStreamOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
+  cl::Kernel * kernel;
+
+  if ( printCode )
+  {
+    std::cout << code << std::endl;
+  }
+  try
+  {
+    kernel = isa::OpenCL::compile("integrationDMsSamplesStream" + std::to_string(integration), code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  try
+  {
+    input_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_WRITE, input.at(0).size() * sizeof(AfterDedispersionNumericType), 0, 0);
+    output_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_WRITE, output.size() * sizeof(AfterDedispersionNumericType), 0, 0);
+    deviceStream.initializeDevice(*(openCLRunTime.context), conf);
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error allocating memory: " << std::to_string(err.err()) << "." << std::endl;
+    return 1;
+  }
+
+  // Every complete integration of the stream must match, whatever the batch it ends in
+  for ( unsigned int batch = 0; batch < nrBatches; batch++ )
+  {
+    const unsigned int nrStreamSamples = deviceStream.getNrPartialSamples();
+    unsigned int nrBatchOutputSamples = 0;
+
+    try
+    {
+      openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(input_d, CL_FALSE, 0, input.at(batch).size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(input.at(batch).data()), 0, 0);
+      nrBatchOutputSamples = deviceStream.integrate(openCLRunTime.queues->at(clDeviceID)[0], *kernel, input_d, output_d);
+      openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(output.data()));
+    }
+    catch ( cl::Error & err )
+    {
+      std::cerr << "OpenCL error kernel execution: " << std::to_string(err.err()) << "." << std::endl;
+      return 1;
+    }
+    hostStream.integrate(input.at(batch), output_host);
+    for ( unsigned int row = 0; row < nrRows; row++ )
+    {
+      for ( unsigned int sample = 0; sample < nrBatchOutputSamples; sample++ )
+      {
+        AfterDedispersionNumericType integratedSample = 0;
+
+        for ( unsigned int item = 0; item < integration; item++ )
+        {
+          // Position in the whole stream, integrations can span more than two batches
+          const uint64_t streamSample = (static_cast< uint64_t >(batch) * observation.getNrSamplesPerBatch()) - nrStreamSamples + (sample * integration) + item;
+
+          integratedSample += input.at(streamSample / observation.getNrSamplesPerBatch()).at((row * inputRowSize) + (streamSample % observation.getNrSamplesPerBatch()));
+        }
+        integratedSample /= integration;
+        if ( !isa::utils::same(integratedSample, output.at((row * outputRowSize) + sample)) )
+        {
+          wrongSamples++;
+        }
+        if ( !isa::utils::same(integratedSample, output_host.at((row * outputRowSize) + sample)) )
+        {
+          wrongSamplesHost++;
+        }
+      }
+    }
+    nrOutputSamples += nrBatchOutputSamples;
+  }
+  delete kernel;
+
+  if ( wrongSamplesHost > 0 )
+  {
+    std::cout << "Wrong samples (host stream): " << wrongSamplesHost << "." << std::endl;
+  }
+  if ( wrongSamples > 0 )
+  {
+    std::cout << "Wrong samples: " << wrongSamples << " (" << (wrongSamples * 100.0) / (static_cast< uint64_t >(nrRows) * nrOutputSamples) << "%)." << std::endl;
+  }
+  else
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+int testPipeline(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const unsigned int nrBatches, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode) {
+  uint64_t wrongSamples = 0;
+  uint64_t wrongOrder = 0;
+  bool acceptedShortBatch = false;
+  const unsigned int nrRows = observation.getNrSynthesizedBeams() * observation.getNrDMs(true) * observation.getNrDMs();
+  const unsigned int nrOutputSamples = observation.getNrSamplesPerBatch() / integration;
+  const unsigned int outputRowSize = isa::utils::pad(nrOutputSamples, padding / sizeof(AfterDedispersionNumericType));
+  std::vector<std::vector<AfterDedispersionNumericType>> input(nrBatches);
+  std::vector<std::vector<AfterDedispersionNumericType>> output(nrBatches);
+  std::vector<AfterDedispersionNumericType> output_control;
+  std::string code = Integration::getIntegrationDMsSamplesOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
+  cl::Kernel * kernel;
+
+  srand(time(0));
+  for ( unsigned int batch = 0; batch < nrBatches; batch++ )
+  {
+    generateDMsSamplesInput(observation, padding, random, input.at(batch));
+    output.at(batch).resize(nrRows * static_cast< uint64_t >(outputRowSize));
+  }
+  output_control.resize(output.at(0).size());
+  if ( printCode )
+  {
+    std::cout << code << std::endl;
+  }
+  try
+  {
+    kernel = isa::OpenCL::compile("integrationDMsSamples" + std::to_string(integration), code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  cl::NDRange global;
+  cl::NDRange local;
+  Integration::getIntegrationNDRange(Integration::integrationMode::DMsSamples, conf, observation, integration, global, local);
+  try
+  {
+    Integration::integrationPipeline<AfterDedispersionNumericType> pipeline(*(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID), *kernel, global, local, input.at(0).size(), output.at(0).size());
+    uint64_t nrCompleted = 0;
+
+    // A batch smaller than the buffers is rejected before anything is enqueued
+    try
+    {
+      std::vector<AfterDedispersionNumericType> shortInput(input.at(0).size() - 1);
+
+      pipeline.submit(shortInput, output.at(0));
+      acceptedShortBatch = true;
+    }
+    catch ( std::invalid_argument & err )
+    {
+    }
+    if ( pipeline.getNrInFlight() > 0 )
+    {
+      acceptedShortBatch = true;
+      pipeline.finish();
+    }
+    // Keep the pipeline full, completing batches as soon as they are ready
+    for ( unsigned int batch = 0; batch < nrBatches; batch++ )
+    {
+      if ( pipeline.getNrInFlight() == pipeline.getDepth() )
+      {
+        wrongOrder += (pipeline.complete() != nrCompleted) ? 1 : 0;
+        nrCompleted++;
+      }
+      if ( pipeline.submit(input.at(batch), output.at(batch)) != batch )
+      {
+        wrongOrder++;
+      }
+      while ( pipeline.poll() )
+      {
+        nrCompleted++;
+      }
+    }
+    while ( pipeline.getNrInFlight() > 0 )
+    {
+      wrongOrder += (pipeline.complete() != nrCompleted) ? 1 : 0;
+      nrCompleted++;
+    }
+    if ( nrCompleted != nrBatches )
+    {
+      wrongOrder++;
+    }
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error kernel execution: " << std::to_string(err.err()) << "." << std::endl;
+    delete kernel;
+    return 1;
+  }
+  delete kernel;
+
+  for ( unsigned int batch = 0; batch < nrBatches; batch++ )
+  {
+    Integration::integrationDMsSamples(conf.getSubbandDedispersion(), observation, integration, padding, input.at(batch), output_control);
+    for ( unsigned int row = 0; row < nrRows; row++ )
+    {
+      for ( unsigned int sample = 0; sample < nrOutputSamples; sample++ )
+      {
+        const uint64_t item = (row * static_cast< uint64_t >(outputRowSize)) + sample;
+
+        if ( !isa::utils::same(output_control.at(item), output.at(batch).at(item)) )
+        {
+          wrongSamples++;
+        }
+      }
+    }
+  }
+
+  if ( wrongOrder > 0 )
+  {
+    std::cout << "Batches completed out of order: " << wrongOrder << "." << std::endl;
+  }
+  if ( acceptedShortBatch )
+  {
+    std::cout << "A batch smaller than the buffers was not rejected." << std::endl;
+  }
+  if ( wrongSamples > 0 )
+  {
+    std::cout << "Wrong samples: " << wrongSamples << " (" << (wrongSamples * 100.0) / (static_cast< uint64_t >(nrBatches) * nrRows * nrOutputSamples) << "%)." << std::endl;
+  }
+  else if ( wrongOrder == 0 && !acceptedShortBatch )
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+int testTranspose(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const bool DMsSamples, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode) {
+  uint64_t wrongSamples = 0;
+  const unsigned int nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+  const unsigned int nrOutputSamples = observation.getNrSamplesPerBatch() / integration;
+  std::vector<AfterDedispersionNumericType> input;
+  std::vector<AfterDedispersionNumericType> output;
+  std::vector<AfterDedispersionNumericType> output_control;
+  cl::Buffer input_d;
+  cl::Buffer output_d;
+  std::string code;
+  cl::Kernel * kernel;
+
+  srand(time(0));
+  if ( DMsSamples )
+  {
+    generateDMsSamplesInput(observation, padding, random, input);
+    output.resize(observation.getNrSynthesizedBeams() * nrOutputSamples * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType)));
+    code = Integration::getIntegrationDMsSamplesToSamplesDMsOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
+  }
+  else
+  {
+    input.resize(observation.getNrSynthesizedBeams() * observation.getNrSamplesPerBatch() * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType)));
+    for ( unsigned int row = 0; row < observation.getNrSynthesizedBeams() * observation.getNrSamplesPerBatch(); row++ )
+    {
+      for ( unsigned int dm = 0; dm < nrDMs; dm++ )
+      {
+        if ( random )
+        {
+          input[(row * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + dm] = rand() % 10;
+        }
+        else
+        {
+          input[(row * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + dm] = (row % observation.getNrSamplesPerBatch()) % 10;
+        }
+      }
+    }
+    output.resize(observation.getNrSynthesizedBeams() * nrDMs * isa::utils::pad(nrOutputSamples, padding / sizeof(AfterDedispersionNumericType)));
+    code = Integration::getIntegrationSamplesDMsToDMsSamplesOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
+  }
+  output_control.resize(output.size());
+  if ( printCode )
+  {
+    std::cout << code << std::endl;
+  }
+  try
+  {
+    if ( DMsSamples )
+    {
+      kernel = isa::OpenCL::compile("integrationDMsSamplesToSamplesDMs" + std::to_string(integration), code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+    }
+    else
+    {
+      kernel = isa::OpenCL::compile("integrationSamplesDMsToDMsSamples" + std::to_string(integration), code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+    }
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  try
+  {
+    cl::NDRange global(conf.getNrThreadsD0() * ((nrOutputSamples + conf.getNrItemsD0() - 1) / conf.getNrItemsD0()), (nrDMs + conf.getNrItemsD1() - 1) / conf.getNrItemsD1(), observation.getNrSynthesizedBeams());
+    cl::NDRange local(conf.getNrThreadsD0(), 1, 1);
+
+    input_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_WRITE, input.size() * sizeof(AfterDedispersionNumericType), 0, 0);
+    output_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_WRITE, output.size() * sizeof(AfterDedispersionNumericType), 0, 0);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(input_d, CL_FALSE, 0, input.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(input.data()), 0, 0);
+    kernel->setArg(0, input_d);
+    kernel->setArg(1, output_d);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(output.data()));
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error kernel execution: " << std::to_string(err.err()) << "." << std::endl;
+    return 1;
+  }
+  delete kernel;
+
+  if ( DMsSamples )
+  {
+    Integration::integrationDMsSamplesToSamplesDMs(conf.getSubbandDedispersion(), observation, integration, padding, input, output_control);
+  }
+  else
+  {
+    Integration::integrationSamplesDMsToDMsSamples(conf.getSubbandDedispersion(), observation, integration, padding, input, output_control);
+  }
+  for ( unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++ )
+  {
+    for ( unsigned int dm = 0; dm < nrDMs; dm++ )
+    {
+      for ( unsigned int sample = 0; sample < nrOutputSamples; sample++ )
+      {
+        uint64_t item = 0;
+
+        if ( DMsSamples )
+        {
+          item = (beam * nrOutputSamples * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + (sample * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + dm;
+        }
+        else
+        {
+          item = (beam * nrDMs * isa::utils::pad(nrOutputSamples, padding / sizeof(AfterDedispersionNumericType))) + (dm * isa::utils::pad(nrOutputSamples, padding / sizeof(AfterDedispersionNumericType))) + sample;
+        }
+        if ( !isa::utils::same(output_control.at(item), output.at(item)) )
+        {
+          wrongSamples++;
+        }
+      }
+    }
+  }
+
+  if ( wrongSamples > 0 )
+  {
+    std::cout << "Wrong samples: " << wrongSamples << " (" << (wrongSamples * 100.0) / (static_cast< uint64_t >(observation.getNrSynthesizedBeams()) * nrDMs * nrOutputSamples) << "%)." << std::endl;
+  }
+  else
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+int testBeforeDedispersion(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode) {
+  uint64_t wrongSamples = 0;
+  const unsigned int nrRows = observation.getNrBeams() * observation.getNrChannels();
+  const unsigned int nrSamples = observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion());
+  const unsigned int inputRowSize = observation.getNrSamplesPerDispersedBatch(conf.getSubbandDedispersion(), padding / sizeof(BeforeDedispersionNumericType));
+  const unsigned int outputRowSize = isa::utils::pad(nrSamples / integration, padding / sizeof(BeforeDedispersionNumericType));
+  Integration::integrationPlan< BeforeDedispersionNumericType > plan(conf, observation, Integration::integrationMode::BeforeDedispersion, BeforeDedispersionDataName, integration, padding);
+  std::vector< BeforeDedispersionNumericType > input(plan.getInputSize());
+  std::vector< BeforeDedispersionNumericType > input_device(input.size());
+  std::vector< BeforeDedispersionNumericType > output(plan.getOutputSize());
+  std::vector< BeforeDedispersionNumericType > output_control(output.size());
+
+  srand(time(0));
+  for ( unsigned int row = 0; row < nrRows; row++ )
+  {
+    for ( unsigned int sample = 0; sample < nrSamples; sample++ )
+    {
+      if ( random )
+      {
+        input[(row * inputRowSize) + sample] = rand() % 10;
+      }
+      else
+      {
+        input[(row * inputRowSize) + sample] = sample % 10;
+      }
+    }
+  }
+  if ( printCode )
+  {
+    std::cout << plan.getCode() << std::endl;
+  }
+  try
+  {
+    plan.compile(*(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+    plan.allocate(*(openCLRunTime.context));
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  try
+  {
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(plan.getInput(), CL_FALSE, 0, input.size() * sizeof(BeforeDedispersionNumericType), reinterpret_cast< void * >(input.data()), 0, 0);
+    plan.execute(openCLRunTime.queues->at(clDeviceID)[0]);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(plan.getOutput(), CL_FALSE, 0, output.size() * sizeof(BeforeDedispersionNumericType), reinterpret_cast< void * >(output.data()));
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(plan.getInput(), CL_TRUE, 0, input_device.size() * sizeof(BeforeDedispersionNumericType), reinterpret_cast< void * >(input_device.data()));
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error kernel execution: " << std::to_string(err.err()) << "." << std::endl;
+    return 1;
+  }
+
+  Integration::integrationBeforeDedispersion(conf.getSubbandDedispersion(), observation, integration, padding, input, output_control);
+  for ( unsigned int row = 0; row < nrRows; row++ )
+  {
+    for ( unsigned int sample = 0; sample < nrSamples / integration; sample++ )
+    {
+      if ( !isa::utils::same(output_control[(row * outputRowSize) + sample], output[(row * outputRowSize) + sample]) )
+      {
+        wrongSamples++;
+      }
+    }
+  }
+  // The full resolution input can be reused by the caller
+  if ( input_device != input )
+  {
+    std::cout << "The input has been modified." << std::endl;
+  }
+
+  if ( wrongSamples > 0 )
+  {
+    std::cout << "Wrong samples: " << wrongSamples << " (" << (wrongSamples * 100.0) / (static_cast< uint64_t >(nrRows) * (nrSamples / integration)) << "%)." << std::endl;
+  }
+  else if ( input_device == input )
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+template<typename O>
+int testOutputType(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const bool DMsSamples, const std::string & outputDataName, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode) {
+  uint64_t wrongSamples = 0;
+  const unsigned int nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+  const unsigned int nrOutputSamples = observation.getNrSamplesPerBatch() / integration;
+  const Integration::integrationMode mode = DMsSamples ? Integration::integrationMode::DMsSamples : Integration::integrationMode::SamplesDMs;
+  std::vector<AfterDedispersionNumericType> input;
+  std::vector<O> output;
+  std::vector<O> output_control;
+  std::vector<float> scales(observation.getNrSynthesizedBeams() * nrDMs);
+  std::vector<float> offsets(scales.size());
+  cl::Buffer input_d;
+  cl::Buffer output_d;
+  cl::Buffer scales_d;
+  cl::Buffer offsets_d;
+  std::string code;
+  cl::Kernel * kernel;
+
+  srand(time(0));
+  // Different scales and offsets for neighbouring DMs, some of the averages saturate the char output
+  for ( unsigned int row = 0; row < scales.size(); row++ )
+  {
+    scales[row] = ((row % 4) + 1) * 0.05f;
+    offsets[row] = row % 3;
+  }
+  if ( DMsSamples )
+  {
+    generateDMsSamplesInput(observation, padding, random, input);
+    output.resize(observation.getNrSynthesizedBeams() * nrDMs * isa::utils::pad(nrOutputSamples, padding / sizeof(O)));
+    code = Integration::getIntegrationDMsSamplesOpenCL<AfterDedispersionNumericType, O>(conf, observation, AfterDedispersionDataName, outputDataName, integration, padding);
+  }
+  else
+  {
+    input.resize(observation.getNrSynthesizedBeams() * observation.getNrSamplesPerBatch() * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType)));
+    for ( unsigned int row = 0; row < observation.getNrSynthesizedBeams() * observation.getNrSamplesPerBatch(); row++ )
+    {
+      for ( unsigned int dm = 0; dm < nrDMs; dm++ )
+      {
+        if ( random )
+        {
+          input[(row * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + dm] = rand() % 10;
+        }
+        else
+        {
+          input[(row * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + dm] = (row % observation.getNrSamplesPerBatch()) % 10;
+        }
+      }
+    }
+    output.resize(observation.getNrSynthesizedBeams() * nrOutputSamples * isa::utils::pad(nrDMs, padding / sizeof(O)));
+    code = Integration::getIntegrationSamplesDMsOpenCL<AfterDedispersionNumericType, O>(conf, observation, AfterDedispersionDataName, outputDataName, integration, padding);
+  }
+  output_control.resize(output.size());
+  if ( printCode )
+  {
+    std::cout << code << std::endl;
+  }
+  try
+  {
+    kernel = isa::OpenCL::compile(Integration::getIntegrationKernelName(mode, integration), code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  try
+  {
+    cl::NDRange global;
+    cl::NDRange local;
+
+    Integration::getIntegrationNDRange(mode, conf, observation, integration, global, local);
+    input_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_ONLY, input.size() * sizeof(AfterDedispersionNumericType), 0, 0);
+    output_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_WRITE_ONLY, output.size() * sizeof(O), 0, 0);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(input_d, CL_FALSE, 0, input.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(input.data()), 0, 0);
+    kernel->setArg(0, input_d);
+    kernel->setArg(1, output_d);
+    if ( Integration::integrationTypes< AfterDedispersionNumericType, O >::scaled )
+    {
+      scales_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_ONLY, scales.size() * sizeof(float), 0, 0);
+      offsets_d = cl::Buffer(*(openCLRunTime.context), CL_MEM_READ_ONLY, offsets.size() * sizeof(float), 0, 0);
+      openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(scales_d, CL_FALSE, 0, scales.size() * sizeof(float), reinterpret_cast< void * >(scales.data()), 0, 0);
+      openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(offsets_d, CL_FALSE, 0, offsets.size() * sizeof(float), reinterpret_cast< void * >(offsets.data()), 0, 0);
+      kernel->setArg(2, scales_d);
+      kernel->setArg(3, offsets_d);
+    }
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(output_d, CL_TRUE, 0, output.size() * sizeof(O), reinterpret_cast< void * >(output.data()));
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error kernel execution: " << std::to_string(err.err()) << "." << std::endl;
+    delete kernel;
+    return 1;
+  }
+  delete kernel;
+
+  if ( DMsSamples )
+  {
+    Integration::integrationDMsSamples(conf.getSubbandDedispersion(), observation, integration, padding, input, output_control, scales, offsets);
+  }
+  else
+  {
+    Integration::integrationSamplesDMs(conf.getSubbandDedispersion(), observation, integration, padding, input, output_control, scales, offsets);
+  }
+  for ( unsigned int beam = 0; beam < observation.getNrSynthesizedBeams(); beam++ )
+  {
+    for ( unsigned int dm = 0; dm < nrDMs; dm++ )
+    {
+      for ( unsigned int sample = 0; sample < nrOutputSamples; sample++ )
+      {
+        uint64_t item = 0;
+
+        if ( DMsSamples )
+        {
+          item = (((beam * static_cast< uint64_t >(nrDMs)) + dm) * isa::utils::pad(nrOutputSamples, padding / sizeof(O))) + sample;
+        }
+        else
+        {
+          item = (((beam * static_cast< uint64_t >(nrOutputSamples)) + sample) * isa::utils::pad(nrDMs, padding / sizeof(O))) + dm;
+        }
+        // The order of the additions differs between the CPU and the kernels, so the rounding can differ
+        if ( getOutputDistance(output_control.at(item), output.at(item)) > 1 )
+        {
+          wrongSamples++;
+        }
+      }
+    }
+  }
+
+  if ( wrongSamples > 0 )
+  {
+    std::cout << "Wrong samples: " << wrongSamples << " (" << (wrongSamples * 100.0) / (static_cast< uint64_t >(observation.getNrSynthesizedBeams()) * nrDMs * nrOutputSamples) << "%)." << std::endl;
+  }
+  else
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+int testStatistics(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const Integration::integrationMode mode, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode) {
+  typedef Integration::integrationTypes< AfterDedispersionNumericType >::statistics Statistics;
+  uint64_t wrongRows = 0;
+  const unsigned int nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+  const uint64_t nrRows = observation.getNrSynthesizedBeams() * static_cast< uint64_t >(nrDMs);
+  std::vector<AfterDedispersionNumericType> input;
+  std::vector<AfterDedispersionNumericType> output_control;
+  std::vector<Statistics> statistics(nrRows * Integration::integrationStatisticsSize);
+  std::vector<Statistics> statistics_control;
+  Integration::integrationPlan< AfterDedispersionNumericType > plan(conf, observation, mode, AfterDedispersionDataName, integration, padding);
+
+  srand(time(0));
+  if ( mode == Integration::integrationMode::SamplesDMs )
+  {
+    input.resize(plan.getInputSize());
+    for ( unsigned int row = 0; row < observation.getNrSynthesizedBeams() * observation.getNrSamplesPerBatch(); row++ )
+    {
+      for ( unsigned int dm = 0; dm < nrDMs; dm++ )
+      {
+        if ( random )
+        {
+          input[(row * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + dm] = rand() % 10;
+        }
+        else
+        {
+          input[(row * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + dm] = (row % observation.getNrSamplesPerBatch()) % 10;
+        }
+      }
+    }
+  }
+  else
+  {
+    generateDMsSamplesInput(observation, padding, random, input);
+  }
+  if ( printCode )
+  {
+    std::cout << plan.getCode() << std::endl;
+  }
+  try
+  {
+    plan.compile(*(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  try
+  {
+    plan.allocate(*(openCLRunTime.context));
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(plan.getInput(), CL_FALSE, 0, input.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(input.data()), 0, 0);
+    plan.execute(openCLRunTime.queues->at(clDeviceID)[0]);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(plan.getStatistics(), CL_TRUE, 0, statistics.size() * sizeof(Statistics), reinterpret_cast< void * >(statistics.data()));
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error kernel execution: " << std::to_string(err.err()) << "." << std::endl;
+    return 1;
+  }
+
+  // The in-place kernel integrates the rows of the DMs-samples layout
+  if ( mode == Integration::integrationMode::SamplesDMs )
+  {
+    output_control.resize(observation.getNrSynthesizedBeams() * static_cast< uint64_t >(observation.getNrSamplesPerBatch() / integration) * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType)));
+    Integration::integrationSamplesDMs(conf.getSubbandDedispersion(), observation, integration, padding, input, output_control, std::vector<float>(), std::vector<float>(), statistics_control);
+  }
+  else
+  {
+    output_control.resize(nrRows * isa::utils::pad(observation.getNrSamplesPerBatch() / integration, padding / sizeof(AfterDedispersionNumericType)));
+    Integration::integrationDMsSamples(conf.getSubbandDedispersion(), observation, integration, padding, input, output_control, std::vector<float>(), std::vector<float>(), statistics_control);
+  }
+  for ( uint64_t row = 0; row < nrRows; row++ )
+  {
+    const Statistics * rowStatistics = statistics.data() + (row * Integration::integrationStatisticsSize);
+    const Statistics * rowControl = statistics_control.data() + (row * Integration::integrationStatisticsSize);
+    bool wrong = false;
+
+    // The order of the additions differs between the CPU and the kernels, so the sums and the maximum can differ in the last places
+    for ( unsigned int item = 0; item < 3; item++ )
+    {
+      if ( std::abs(rowStatistics[item] - rowControl[item]) > 1.0e-4 * std::max(std::abs(rowControl[item]), static_cast< Statistics >(1)) )
+      {
+        wrong = true;
+      }
+    }
+    if ( rowStatistics[3] != rowControl[3] )
+    {
+      wrong = true;
+    }
+    if ( wrong )
+    {
+      wrongRows++;
+    }
+  }
+
+  if ( wrongRows > 0 )
+  {
+    std::cout << "Wrong statistics: " << wrongRows << " (" << (wrongRows * 100.0) / nrRows << "%)." << std::endl;
+  }
+  else
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+int testCandidates(isa::OpenCL::OpenCLRunTime & openCLRunTime, const unsigned int clDeviceID, const Integration::integrationConf & conf, const AstroData::Observation & observation, const bool DMsSamples, const unsigned int integration, const unsigned int padding, const bool random, const bool printCode) {
+  uint64_t wrongCandidates = 0;
+  uint32_t nrCandidates = 0;
+  const unsigned int nrDMs = observation.getNrDMs(true) * observation.getNrDMs();
+  const Integration::integrationMode mode = DMsSamples ? Integration::integrationMode::DMsSamples : Integration::integrationMode::SamplesDMs;
+  std::vector<AfterDedispersionNumericType> input;
+  std::vector<AfterDedispersionNumericType> output_control;
+  std::vector<float> thresholds(observation.getNrSynthesizedBeams() * nrDMs);
+  std::vector<Integration::integrationCandidate> candidates(conf.getMaxCandidates());
+  std::vector<Integration::integrationCandidate> candidates_control;
+  Integration::integrationPlan< AfterDedispersionNumericType > plan(conf, observation, mode, AfterDedispersionDataName, integration, padding);
+  auto order = [](const Integration::integrationCandidate & first, const Integration::integrationCandidate & second) {
+    return (first.beam < second.beam) || (first.beam == second.beam && first.dm < second.dm) || (first.beam == second.beam && first.dm == second.dm && first.sample < second.sample);
+  };
+
+  srand(time(0));
+  // Different thresholds for neighbouring DMs
+  for ( unsigned int row = 0; row < thresholds.size(); row++ )
+  {
+    thresholds[row] = 4.0f + (row % 4);
+  }
+  if ( DMsSamples )
+  {
+    generateDMsSamplesInput(observation, padding, random, input);
+  }
+  else
+  {
+    input.resize(plan.getInputSize());
+    for ( unsigned int row = 0; row < observation.getNrSynthesizedBeams() * observation.getNrSamplesPerBatch(); row++ )
+    {
+      for ( unsigned int dm = 0; dm < nrDMs; dm++ )
+      {
+        if ( random )
+        {
+          input[(row * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + dm] = rand() % 10;
+        }
+        else
+        {
+          input[(row * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType))) + dm] = (row % observation.getNrSamplesPerBatch()) % 10;
+        }
+      }
+    }
+  }
+  if ( printCode )
+  {
+    std::cout << plan.getCode() << std::endl;
+  }
+  try
+  {
+    plan.compile(*(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  try
+  {
+    plan.allocate(*(openCLRunTime.context));
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(plan.getInput(), CL_FALSE, 0, input.size() * sizeof(AfterDedispersionNumericType), reinterpret_cast< void * >(input.data()), 0, 0);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueWriteBuffer(plan.getThresholds(), CL_FALSE, 0, thresholds.size() * sizeof(float), reinterpret_cast< void * >(thresholds.data()), 0, 0);
+    plan.execute(openCLRunTime.queues->at(clDeviceID)[0]);
+    openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(plan.getNrCandidates(), CL_TRUE, 0, sizeof(uint32_t), reinterpret_cast< void * >(&nrCandidates));
+    candidates.resize(std::min(nrCandidates, conf.getMaxCandidates()));
+    if ( !candidates.empty() )
+    {
+      openCLRunTime.queues->at(clDeviceID)[0].enqueueReadBuffer(plan.getCandidates(), CL_TRUE, 0, candidates.size() * sizeof(Integration::integrationCandidate), reinterpret_cast< void * >(candidates.data()));
+    }
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error kernel execution: " << std::to_string(err.err()) << "." << std::endl;
+    return 1;
+  }
+
+  output_control.resize(plan.getOutputSize());
+  if ( DMsSamples )
+  {
+    Integration::integrationDMsSamples(conf.getSubbandDedispersion(), observation, integration, padding, input, output_control, std::vector<float>(), std::vector<float>(), thresholds, candidates_control);
+  }
+  else
+  {
+    Integration::integrationSamplesDMs(conf.getSubbandDedispersion(), observation, integration, padding, input, output_control, std::vector<float>(), std::vector<float>(), thresholds, candidates_control);
+  }
+  if ( nrCandidates != candidates_control.size() )
+  {
+    std::cout << "Wrong number of candidates: " << nrCandidates << " instead of " << candidates_control.size() << "." << std::endl;
+    return 0;
+  }
+  // The kernels append the candidates in any order; with a full list, only the number of candidates can be checked
+  if ( candidates.size() == candidates_control.size() )
+  {
+    std::sort(candidates.begin(), candidates.end(), order);
+    std::sort(candidates_control.begin(), candidates_control.end(), order);
+    for ( unsigned int candidate = 0; candidate < candidates.size(); candidate++ )
+    {
+      if ( order(candidates.at(candidate), candidates_control.at(candidate)) || order(candidates_control.at(candidate), candidates.at(candidate)) || !isa::utils::same(candidates.at(candidate).value, candidates_control.at(candidate).value) )
+      {
+        wrongCandidates++;
+      }
+    }
+  }
+
+  if ( wrongCandidates > 0 )
+  {
+    std::cout << "Wrong candidates: " << wrongCandidates << " (" << (wrongCandidates * 100.0) / candidates.size() << "%)." << std::endl;
+  }
+  else
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+template<typename O>
+unsigned int getOutputDistance(const O first, const O second) {
+  return std::abs(static_cast< int >(first) - static_cast< int >(second));
+}
+
+int testTunedConf(const std::string & confFilename) {
+  const std::string cacheFilename = confFilename + ".test_cache";
+  // Source given to the cache, any value other than the one of the text file
+  const uint64_t source = 42;
+  uint64_t wrongLookups = 0;
+  uint64_t acceptedCaches = 0;
+  uint64_t wrongFallbacks = 0;
+  std::vector<std::tuple<std::string, unsigned int, unsigned int>> parameters;
+  std::ifstream confFile(confFilename);
+  std::string cache;
+  Integration::tunedIntegrationConf text;
+  Integration::tunedIntegrationConf cached;
+
+  // Parameters of every line of the file, device name, dim0, and integration
+  for ( std::string line; std::getline(confFile, line); )
+  {
+    std::istringstream fields(line);
+    std::string deviceName;
+    unsigned int dim0 = 0;
+    unsigned int integration = 0;
+
+    if ( !line.empty() && std::isalpha(static_cast< unsigned char >(line.front())) && (fields >> deviceName >> dim0 >> integration) )
+    {
+      parameters.emplace_back(deviceName, dim0, integration);
+    }
+  }
+  confFile.close();
+  // Number of lookups of the file that differ between two tuned configurations
+  auto compare = [&parameters](const Integration::tunedIntegrationConf & first, const Integration::tunedIntegrationConf & second) {
+    uint64_t wrong = (first.size() != second.size()) ? 1 : 0;
+
+    for ( const auto & item : parameters )
+    {
+      const Integration::integrationConf * firstConf = first.find(std::get<0>(item), std::get<1>(item), std::get<2>(item));
+      const Integration::integrationConf * secondConf = second.find(std::get<0>(item), std::get<1>(item), std::get<2>(item));
+      const Integration::integrationConf * firstNearest = first.findNearest(std::get<0>(item), std::get<1>(item) + 1, std::get<2>(item));
+      const Integration::integrationConf * secondNearest = second.findNearest(std::get<0>(item), std::get<1>(item) + 1, std::get<2>(item));
+
+      if ( firstConf == nullptr || secondConf == nullptr || firstConf->print() != secondConf->print() )
+      {
+        wrong++;
+      }
+      else if ( firstNearest == nullptr || secondNearest == nullptr || firstNearest->print() != secondNearest->print() )
+      {
+        wrong++;
+      }
+    }
+    return wrong;
+  };
+
+  try
+  {
+    // Text, cache, lookups
+    Integration::readTunedIntegrationConf(text, confFilename);
+    text.writeCache(cacheFilename, source);
+    cached.readCache(cacheFilename, source);
+    wrongLookups += compare(text, cached);
+    std::ifstream cacheFile(cacheFilename, std::ios::binary);
+    cache.assign(std::istreambuf_iterator< char >(cacheFile), std::istreambuf_iterator< char >());
+  }
+  catch ( AstroData::FileError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  // Corrupted caches: truncated, huge number of devices and entries, wrong source, and entries out of order
+  std::vector<std::string> corrupted;
+  const std::size_t nrDevicesOffset = 8 + sizeof(uint32_t) + sizeof(uint64_t);
+  const std::size_t entrySize = 15 * sizeof(uint32_t);
+
+  corrupted.push_back(cache.substr(0, cache.size() / 2));
+  corrupted.push_back(cache.substr(0, cache.size() - 1));
+  corrupted.push_back(cache);
+  corrupted.back().replace(nrDevicesOffset, sizeof(uint32_t), 4, '\xff');
+  corrupted.push_back(cache);
+  corrupted.back().replace(nrDevicesOffset + sizeof(uint32_t), sizeof(uint32_t), std::string("\0\0\0\x40", 4));
+  corrupted.push_back(cache);
+  corrupted.back()[8 + sizeof(uint32_t)] ^= 1;
+  if ( text.size() > 1 )
+  {
+    const std::size_t first = cache.size() - (text.size() * entrySize);
+
+    corrupted.push_back(cache);
+    std::swap_ranges(corrupted.back().begin() + first, corrupted.back().begin() + first + entrySize, corrupted.back().begin() + first + entrySize);
+  }
+  for ( const auto & contents : corrupted )
+  {
+    Integration::tunedIntegrationConf fallback;
+
+    std::ofstream(cacheFilename, std::ios::binary | std::ios::trunc).write(contents.data(), contents.size());
+    try
+    {
+      cached.readCache(cacheFilename, source);
+      acceptedCaches++;
+    }
+    catch ( AstroData::FileError & err )
+    {
+    }
+    catch ( std::exception & err )
+    {
+      acceptedCaches++;
+    }
+    // With an invalid cache the text file is read again
+    try
+    {
+      Integration::readTunedIntegrationConf(fallback, confFilename, cacheFilename);
+      wrongFallbacks += compare(text, fallback);
+    }
+    catch ( std::exception & err )
+    {
+      wrongFallbacks++;
+    }
+  }
+
+  // Both versions of readTunedIntegrationConf add to the content of tunedConf, and a valid cache is used
+  Integration::tunedIntegrationConf merged;
+  Integration::tunedIntegrationConf mergedCached;
+  Integration::integrationConf extra;
+
+  try
+  {
+    merged.insert("IntegrationTesting", 1, 1, extra);
+    mergedCached.insert("IntegrationTesting", 1, 1, extra);
+    Integration::readTunedIntegrationConf(merged, confFilename);
+    Integration::readTunedIntegrationConf(mergedCached, confFilename, cacheFilename);
+    Integration::readTunedIntegrationConf(mergedCached, confFilename, cacheFilename);
+    wrongLookups += compare(merged, mergedCached);
+    if ( merged.size() != text.size() + 1 || merged.find("IntegrationTesting", 1, 1) == nullptr || mergedCached.find("IntegrationTesting", 1, 1) == nullptr )
+    {
+      wrongLookups++;
+    }
+  }
+  catch ( AstroData::FileError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  std::remove(cacheFilename.c_str());
+
+  if ( wrongLookups > 0 )
+  {
+    std::cout << "Wrong lookups: " << wrongLookups << " (" << parameters.size() << " lines)." << std::endl;
+  }
+  if ( acceptedCaches > 0 )
+  {
+    std::cout << "Corrupted caches not rejected with a FileError: " << acceptedCaches << " of " << corrupted.size() << "." << std::endl;
+  }
+  if ( wrongFallbacks > 0 )
+  {
+    std::cout << "Wrong fallbacks to the text file: " << wrongFallbacks << "." << std::endl;
+  }
+  if ( wrongLookups == 0 && acceptedCaches == 0 && wrongFallbacks == 0 )
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+int testSearch() {
+  const unsigned int nrIterations = 10;
+  const unsigned int nrLandscapes = 20;
+  // Average fraction of the optimum that every strategy must reach
+  const double minFraction = 0.95;
+  const std::vector<std::pair<std::string, Integration::searchStrategy>> strategies = {{"hill_climbing", Integration::searchStrategy::HillClimbing}, {"successive_halving", Integration::searchStrategy::SuccessiveHalving}, {"surrogate", Integration::searchStrategy::Surrogate}};
+  std::vector<std::vector<unsigned int>> parameters;
+  uint64_t overBudget = 0;
+  unsigned int wrongStrategies = 0;
+
+  // Threads, items, vector width, and integer type, as enumerated by the tuner
+  for ( unsigned int threads = 16; threads <= 1024; threads *= 2 )
+  {
+    for ( unsigned int items = 1; items <= 64; items++ )
+    {
+      for ( unsigned int width = 1; width <= 8; width *= 2 )
+      {
+        for ( unsigned int intType = 0; intType < 2; intType++ )
+        {
+          parameters.push_back(std::vector<unsigned int>{threads, items, width, intType});
+        }
+      }
+    }
+  }
+  // Five percent of the configurations measured with all the iterations
+  const unsigned int budget = std::max(static_cast<std::size_t>(1), parameters.size() / 20);
+
+  for ( const auto & strategy : strategies )
+  {
+    double fraction = 0.0;
+
+    for ( unsigned int landscape = 0; landscape < nrLandscapes; landscape++ )
+    {
+      std::mt19937 generator(landscape);
+      std::uniform_real_distribution<double> distribution(0.0, 1.0);
+      std::vector<double> performance(parameters.size());
+
+      // A smooth peak at a random point, with a second lower one, and no performance where the work-group uses too many registers
+      std::vector<double> peak = {4.0 + (6.0 * distribution(generator)), 64.0 * distribution(generator), 3.0 * distribution(generator)};
+      std::vector<double> secondPeak = {4.0 + (6.0 * distribution(generator)), 64.0 * distribution(generator), 3.0 * distribution(generator)};
+      const double intTypeGain = 0.1 * distribution(generator);
+      for ( unsigned int configuration = 0; configuration < parameters.size(); configuration++ )
+      {
+        const std::vector<unsigned int> & values = parameters[configuration];
+        const std::vector<double> point = {std::log2(values[0]), static_cast<double>(values[1]), std::log2(values[2])};
+        double distance = 0.0;
+        double secondDistance = 0.0;
+
+        if ( values[0] * values[1] * values[2] > 16384 )
+        {
+          performance[configuration] = 0.0;
+          continue;
+        }
+        for ( unsigned int dimension = 0; dimension < point.size(); dimension++ )
+        {
+          const double scale = (dimension == 1) ? 16.0 : 2.0;
+
+          distance += ((point[dimension] - peak[dimension]) / scale) * ((point[dimension] - peak[dimension]) / scale);
+          secondDistance += ((point[dimension] - secondPeak[dimension]) / scale) * ((point[dimension] - secondPeak[dimension]) / scale);
+        }
+        performance[configuration] = std::max(100.0 * std::exp(-distance), 80.0 * std::exp(-secondDistance)) * (1.0 + (values[3] * intTypeGain));
+      }
+      const double optimum = *std::max_element(performance.begin(), performance.end());
+
+      // The second search runs the measurements with all the iterations twice as many times, as with -max_cov, and is only checked against the budget
+      for ( unsigned int adaptive = 0; adaptive < 2; adaptive++ )
+      {
+        uint64_t nrRuns = 0;
+
+        // Measurements with fewer iterations are noisier
+        auto measure = [&](const unsigned int configuration, const unsigned int iterations, unsigned int & runs) -> double
+        {
+          runs = ((adaptive != 0) && (iterations == nrIterations)) ? 2 * iterations : iterations;
+          nrRuns += runs;
+          return performance.at(configuration) * (1.0 + ((distribution(generator) - 0.5) * 0.05 / std::sqrt(iterations)));
+        };
+        const unsigned int best = Integration::searchConfigurations(strategy.second, parameters, nrIterations, budget, measure, landscape);
+        if ( (adaptive == 0) && (best < parameters.size()) )
+        {
+          fraction += performance[best] / optimum;
+        }
+        // Only the last measurement can go past the budget
+        if ( nrRuns > (static_cast<uint64_t>(budget) * nrIterations) + (2 * nrIterations) )
+        {
+          overBudget++;
+        }
+      }
+    }
+    fraction /= nrLandscapes;
+    std::cout << strategy.first << ": " << std::fixed << std::setprecision(1) << fraction * 100.0 << "% of the optimum, " << parameters.size() << " configurations, budget " << budget << "." << std::endl;
+    if ( fraction < minFraction )
+    {
+      wrongStrategies++;
+    }
+  }
+
+  if ( wrongStrategies > 0 )
+  {
+    std::cout << "Strategies below " << minFraction * 100.0 << "% of the optimum: " << wrongStrategies << "." << std::endl;
+  }
+  if ( overBudget > 0 )
+  {
+    std::cout << "Searches over budget: " << overBudget << "." << std::endl;
+  }
+  if ( wrongStrategies == 0 && overBudget == 0 )
+  {
+    std::cout << "TEST PASSED." << std::endl;
+  }
+  return 0;
+}
+
+unsigned int getOutputDistance(const Integration::integrationHalf first, const Integration::integrationHalf second) {
+  // Half values of the same sign are ordered as their bits
+  if ( (first.bits & 0x8000) != (second.bits & 0x8000) )
+  {
+    return (first.bits & 0x7fff) + (second.bits & 0x7fff);
+  }
+  return std::abs(static_cast< int >(first.bits) - static_cast< int >(second.bits));
+}
+
+void generateDMsSamplesInput(const AstroData::Observation & observation, const unsigned int padding, const bool random, std::vector<AfterDedispersionNumericType> & input) {
+  const unsigned int nrRows = observation.getNrSynthesizedBeams() * observation.getNrDMs(true) * observation.getNrDMs();
+
+  input.resize(nrRows * observation.getNrSamplesPerBatch(false, padding / sizeof(AfterDedispersionNumericType)));
+  for ( unsigned int row = 0; row < nrRows; row++ )
+  {
+    for ( unsigned int sample = 0; sample < observation.getNrSamplesPerBatch(); sample++ )
+    {
+      if ( random )
+      {
+        input[(row * observation.getNrSamplesPerBatch(false, padding / sizeof(AfterDedispersionNumericType))) + sample] = rand() % 10;
+      }
+      else
+      {
+        input[(row * observation.getNrSamplesPerBatch(false, padding / sizeof(AfterDedispersionNumericType))) + sample] = sample % 10;
+      }
+    }
+  }
+}
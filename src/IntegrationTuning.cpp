@@ -18,6 +18,12 @@
 #include <vector>
 #include <exception>
 #include <iomanip>
+#include <ctime>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <fstream>
 
 #include <configuration.hpp>
 
@@ -27,10 +33,11 @@
 #include <Kernel.hpp>
 #include <utils.hpp>
 #include <Integration.hpp>
-#include <Timer.hpp>
 
 
-void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue, cl::Buffer * input_d, const unsigned int input_size, cl::Buffer * output_d, const unsigned int output_size, bool before = false);
+void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue, cl::Buffer * input_d, const uint64_t input_size, cl::Buffer * output_d, const uint64_t output_size, bool before = false);
+std::vector< unsigned int > getList(const std::string & list);
+double measureCopyBandwidth(Integration::kernelCache & kernels, cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, const uint64_t size, const unsigned int nrIterations);
 
 int main(int argc, char * argv[]) {
   bool reinitializeDeviceMemory = true;
@@ -38,19 +45,34 @@ int main(int argc, char * argv[]) {
   bool inPlace = false;
   bool beforeDedispersion = false;
   bool bestMode = false;
+  bool gridMode = false;
   unsigned int padding = 0;
   unsigned int integration = 0;
   unsigned int nrIterations = 0;
+  unsigned int maxNrIterations = 0;
+  double maxCOV = 0.0;
   unsigned int clPlatformID = 0;
   unsigned int clDeviceID = 0;
   unsigned int minThreads = 0;
   unsigned int maxThreads = 0;
   unsigned int maxItems = 0;
-  unsigned int vectorWidth = 0;
-  double bestGFLOPs = 0.0;
+  unsigned int maxVectorWidth = 0;
+  unsigned int budget = 0;
+  unsigned int seed = 0;
+  unsigned int compileThreads = 0;
+  Integration::searchStrategy strategy = Integration::searchStrategy::Exhaustive;
+  std::string kernelCacheDirectory;
+  std::string outputFormat;
+  std::string confFilename;
+  std::string deviceName;
+  std::vector< unsigned int > integrations;
+  std::vector< unsigned int > samplesList;
+  std::vector< unsigned int > dim0List;
   AstroData::Observation observation;
   Integration::integrationConf conf;
   Integration::integrationConf bestConf;
+  std::vector< Integration::integrationConf > configurations;
+  std::vector< std::vector< unsigned int > > parameters;
   cl::Event event;
 
   try
@@ -81,22 +103,113 @@ int main(int argc, char * argv[]) {
     // OpenCL
     clPlatformID = args.getSwitchArgument< unsigned int >("-opencl_platform");
     clDeviceID = args.getSwitchArgument< unsigned int >("-opencl_device");
+    try
+    {
+      kernelCacheDirectory = args.getSwitchArgument< std::string >("-kernel_cache");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      kernelCacheDirectory = std::string();
+    }
+    try
+    {
+      compileThreads = args.getSwitchArgument< unsigned int >("-compile_threads");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      compileThreads = 0;
+    }
     // Tuning
     bestMode = args.getSwitch("-best");
+    try
+    {
+      outputFormat = args.getSwitchArgument< std::string >("-output_format");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      outputFormat = "text";
+    }
+    if ( outputFormat != "text" && outputFormat != "csv" && outputFormat != "json" )
+    {
+      std::cerr << "-output_format must be text, csv, or json." << std::endl;
+      return 1;
+    }
     nrIterations = args.getSwitchArgument< unsigned int >("-iterations");
+    try
+    {
+      maxNrIterations = std::max(nrIterations, args.getSwitchArgument< unsigned int >("-max_iterations"));
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      maxNrIterations = nrIterations;
+    }
+    try
+    {
+      maxCOV = args.getSwitchArgument< double >("-max_cov");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      maxCOV = 0.0;
+    }
     minThreads = args.getSwitchArgument< unsigned int >("-min_threads");
     maxThreads = args.getSwitchArgument< unsigned int >("-max_threads");
     maxItems = args.getSwitchArgument< unsigned int >("-max_items");
-    // Scenario
+    try
+    {
+      strategy = Integration::getSearchStrategy(args.getSwitchArgument< std::string >("-strategy"));
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      strategy = Integration::searchStrategy::Exhaustive;
+    }
+    try
+    {
+      budget = args.getSwitchArgument< unsigned int >("-budget");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      budget = 0;
+    }
+    try
+    {
+      seed = args.getSwitchArgument< unsigned int >("-seed");
+    }
+    catch ( isa::utils::SwitchNotFound & err )
+    {
+      seed = std::time(nullptr);
+    }
+    // Scenario, in grid mode integration factors, samples, channels and DMs are comma separated lists
+    gridMode = args.getSwitch("-grid");
+    if ( gridMode )
+    {
+      confFilename = args.getSwitchArgument< std::string >("-conf_file");
+      deviceName = args.getSwitchArgument< std::string >("-device_name");
+      if ( deviceName.find(' ') != std::string::npos )
+      {
+        std::cerr << "-device_name can not contain spaces." << std::endl;
+        return 1;
+      }
+      integrations = getList(args.getSwitchArgument< std::string >("-integrations"));
+      samplesList = getList(args.getSwitchArgument< std::string >("-samples"));
+    }
+    else
+    {
+      integrations.push_back(args.getSwitchArgument< unsigned int >("-integration"));
+      samplesList.push_back(args.getSwitchArgument< unsigned int >("-samples"));
+    }
     padding = args.getSwitchArgument< unsigned int >("-padding");
-    integration = args.getSwitchArgument< unsigned int >("-integration");
-    vectorWidth = args.getSwitchArgument< unsigned int >("-vector");
+    maxVectorWidth = args.getSwitchArgument< unsigned int >("-vector");
     observation.setNrSynthesizedBeams(args.getSwitchArgument< unsigned int >("-beams"));
-    observation.setNrSamplesPerBatch(args.getSwitchArgument< unsigned int >("-samples"));
     if ( inPlace && beforeDedispersion )
     {
-      observation.setFrequencyRange(1, args.getSwitchArgument<unsigned int>("-channels"), 0.0f, 0.0f);
-      observation.setNrSamplesPerDispersedBatch(observation.getNrSamplesPerBatch());
+      if ( gridMode )
+      {
+        dim0List = getList(args.getSwitchArgument< std::string >("-channels"));
+      }
+      else
+      {
+        dim0List.push_back(args.getSwitchArgument< unsigned int >("-channels"));
+      }
       observation.setNrBeams(observation.getNrSynthesizedBeams());
       conf.setSubbandDedispersion(args.getSwitch("-subband"));
     }
@@ -111,15 +224,23 @@ int main(int argc, char * argv[]) {
       {
         observation.setDMRange(1, 0.0f, 0.0f, true);
       }
-      observation.setDMRange(args.getSwitchArgument< unsigned int >("-dms"), 0.0f, 0.0f);
+      if ( gridMode )
+      {
+        dim0List = getList(args.getSwitchArgument< std::string >("-dms"));
+      }
+      else
+      {
+        dim0List.push_back(args.getSwitchArgument< unsigned int >("-dms"));
+      }
     }
   }
   catch ( isa::utils::EmptyCommandLine & err )
   {
-    std::cerr << argv[0] << " [-in_place] [-dms_samples | -samples_dms] [-best] -iterations ... -opencl_platform ... -opencl_device ... -padding ... -integration ... -min_threads ... -max_threads ... -max_items ... -vector ... [-subband] -beams ... -samples ... -dms ... " << std::endl;
+    std::cerr << argv[0] << " [-in_place] [-dms_samples | -samples_dms] [-best] [-output_format ...] [-strategy ...] [-budget ...] [-seed ...] -iterations ... [-max_iterations ...] [-max_cov ...] -opencl_platform ... -opencl_device ... [-kernel_cache ...] [-compile_threads ...] -padding ... [-grid] -integration ... -min_threads ... -max_threads ... -max_items ... -vector ... [-subband] -beams ... -samples ... -dms ... " << std::endl;
     std::cerr << "\t -subband : -subbanding_dms ..." << std::endl;
     std::cerr << " -in_place [-before_dedispersion | -after_dedispersion]" << std::endl;
     std::cerr << " -before_dedispersion -channels ..." << std::endl;
+    std::cerr << " -grid -conf_file ... -device_name ... -integrations ... : -samples, -channels and -dms are comma separated lists" << std::endl;
     return 1;
   }
   catch ( std::exception & err )
@@ -128,297 +249,525 @@ int main(int argc, char * argv[]) {
     return 1;
   }
 
-  // Allocate host memory
-  std::vector<BeforeDedispersionNumericType> input_before;
-  std::vector<AfterDedispersionNumericType> input_after, output;
-  if ( inPlace )
+  Integration::integrationMode mode = Integration::integrationMode::SamplesDMs;
+  if ( inPlace && beforeDedispersion )
+  {
+    mode = Integration::integrationMode::BeforeDedispersionInPlace;
+  }
+  else if ( inPlace )
+  {
+    mode = Integration::integrationMode::AfterDedispersionInPlace;
+  }
+  else if ( DMsSamples )
+  {
+    mode = Integration::integrationMode::DMsSamples;
+  }
+
+  // Set the scenario of a point of the grid
+  auto setScenario = [&](const unsigned int samples, const unsigned int dim0)
   {
-    if ( beforeDedispersion )
+    observation.setNrSamplesPerBatch(samples);
+    if ( inPlace && beforeDedispersion )
     {
-      input_before.resize(observation.getNrBeams() * observation.getNrChannels() * observation.getNrSamplesPerDispersedBatch(false, padding / sizeof(BeforeDedispersionNumericType)));
+      observation.setFrequencyRange(1, dim0, 0.0f, 0.0f);
+      observation.setNrSamplesPerDispersedBatch(samples);
     }
     else
     {
-      input_after.resize(observation.getNrSynthesizedBeams() * observation.getNrDMs(true) * observation.getNrDMs() * observation.getNrSamplesPerBatch(false, padding / sizeof(AfterDedispersionNumericType)));
+      observation.setDMRange(dim0, 0.0f, 0.0f);
     }
-  }
-  else
+  };
+
+  // dim0 of the current scenario as in the tuned configuration files, channels before dedispersion and all DMs after
+  auto getDim0 = [&]() -> unsigned int
   {
-    if ( DMsSamples )
+    if ( inPlace && beforeDedispersion )
     {
-      input_after.resize(observation.getNrSynthesizedBeams() * observation.getNrDMs(true) * observation.getNrDMs() * observation.getNrSamplesPerBatch(false, padding / sizeof(AfterDedispersionNumericType)));
-      output.resize(observation.getNrSynthesizedBeams() * observation.getNrDMs(true) * observation.getNrDMs() * isa::utils::pad(observation.getNrSamplesPerBatch() / integration, padding / sizeof(AfterDedispersionNumericType)));
+      return observation.getNrChannels();
     }
-    else
+    return observation.getNrDMs(true) * observation.getNrDMs();
+  };
+
+  // Device memory is sized for the largest point of the grid
+  uint64_t inputSize = 0;
+  uint64_t outputSize = 0;
+  for ( auto samples : samplesList )
+  {
+    for ( auto dim0 : dim0List )
     {
-      input_after.resize(observation.getNrSynthesizedBeams() * observation.getNrSamplesPerBatch() * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType)));
-      output.resize(observation.getNrSynthesizedBeams() * (observation.getNrSamplesPerBatch() / integration) * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType)));
+      for ( auto factor : integrations )
+      {
+        setScenario(samples, dim0);
+        if ( inPlace )
+        {
+          if ( beforeDedispersion )
+          {
+            inputSize = std::max(inputSize, static_cast< uint64_t >(observation.getNrBeams()) * observation.getNrChannels() * observation.getNrSamplesPerDispersedBatch(false, padding / sizeof(BeforeDedispersionNumericType)));
+          }
+          else
+          {
+            inputSize = std::max(inputSize, static_cast< uint64_t >(observation.getNrSynthesizedBeams()) * observation.getNrDMs(true) * observation.getNrDMs() * observation.getNrSamplesPerBatch(false, padding / sizeof(AfterDedispersionNumericType)));
+          }
+        }
+        else
+        {
+          if ( DMsSamples )
+          {
+            inputSize = std::max(inputSize, static_cast< uint64_t >(observation.getNrSynthesizedBeams()) * observation.getNrDMs(true) * observation.getNrDMs() * observation.getNrSamplesPerBatch(false, padding / sizeof(AfterDedispersionNumericType)));
+            outputSize = std::max(outputSize, static_cast< uint64_t >(observation.getNrSynthesizedBeams()) * observation.getNrDMs(true) * observation.getNrDMs() * isa::utils::pad(observation.getNrSamplesPerBatch() / factor, padding / sizeof(AfterDedispersionNumericType)));
+          }
+          else
+          {
+            inputSize = std::max(inputSize, static_cast< uint64_t >(observation.getNrSynthesizedBeams()) * observation.getNrSamplesPerBatch() * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType)));
+            outputSize = std::max(outputSize, static_cast< uint64_t >(observation.getNrSynthesizedBeams()) * (observation.getNrSamplesPerBatch() / factor) * observation.getNrDMs(true) * observation.getNrDMs(false, padding / sizeof(AfterDedispersionNumericType)));
+          }
+        }
+      }
     }
   }
 
   isa::OpenCL::OpenCLRunTime openCLRunTime;
   cl::Buffer input_d;
   cl::Buffer output_d;
+  cl::CommandQueue profilingQueue;
+  Integration::kernelCache kernels(kernelCacheDirectory);
+  Integration::kernelCompiler compiler(kernels, compileThreads);
+
+  // Create the OpenCL context, the profiling queue, and the device buffers; kernels compiled for the old context cannot be used anymore
+  auto initializeDevice = [&]()
+  {
+    compiler.clear();
+    isa::OpenCL::initializeOpenCL(clPlatformID, 1, openCLRunTime);
+    // Kernels are timed with the device's timestamps, excluding queue and driver latency
+    profilingQueue = cl::CommandQueue(*(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID), CL_QUEUE_PROFILING_ENABLE);
+    try
+    {
+      if ( beforeDedispersion )
+      {
+        initializeDeviceMemory(*(openCLRunTime.context), &(openCLRunTime.queues->at(clDeviceID)[0]), &input_d, inputSize, &output_d, outputSize, true);
+      }
+      else
+      {
+        initializeDeviceMemory(*(openCLRunTime.context), &(openCLRunTime.queues->at(clDeviceID)[0]), &input_d, inputSize, &output_d, outputSize);
+      }
+    }
+    catch ( cl::Error & err )
+    {
+      std::cerr << "Error in memory allocation: ";
+      std::cerr << std::to_string(err.err()) << "." << std::endl;
+      throw;
+    }
+    reinitializeDeviceMemory = false;
+  };
 
+  // Memory bandwidth achievable by a copy kernel, the integration kernels are memory bound
+  double copyBandwidth = 0.0;
+  try
+  {
+    initializeDevice();
+    // Only used to report the efficiency of the measured configurations
+    if ( !bestMode && beforeDedispersion )
+    {
+      copyBandwidth = measureCopyBandwidth(kernels, *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID), profilingQueue, inputSize * sizeof(BeforeDedispersionNumericType), nrIterations);
+    }
+    else if ( !bestMode )
+    {
+      copyBandwidth = measureCopyBandwidth(kernels, *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID), profilingQueue, inputSize * sizeof(AfterDedispersionNumericType), nrIterations);
+    }
+  }
+  catch ( cl::Error & err )
+  {
+    std::cerr << "OpenCL error measuring the copy bandwidth: " << std::to_string(err.err()) << "." << std::endl;
+    return -1;
+  }
+  catch ( isa::OpenCL::OpenCLError & err )
+  {
+    std::cerr << err.what() << std::endl;
+    return -1;
+  }
+
+  bool firstMeasurement = true;
   if ( !bestMode )
   {
-    std::cout << std::fixed << std::endl;
-    if ( inPlace && beforeDedispersion )
+    const std::string dim0Name = (inPlace && beforeDedispersion) ? "Channels" : "DMs";
+
+    if ( outputFormat == "csv" )
+    {
+      std::cout << "nr_beams,nr_" << (inPlace && beforeDedispersion ? "channels" : "dms") << ",nr_samples,integration,subband_dedispersion,threads_d0,threads_d1,threads_d2,items_d0,items_d1,items_d2,int_type,subgroup_reduction,vector_width,in_place_variant,nr_passes,gflops,gbs,peak_percentage,copy_gbs,time,std_deviation,cov,median,p95,min,runs" << std::endl;
+    }
+    else if ( outputFormat == "json" )
     {
-      std::cout << "# nrBeams nrChannels nrSamples integration *configuration* GFLOP/s GB/s time stdDeviation COV" << std::endl << std::endl;
+      std::cout << "{\"copy_gbs\": " << copyBandwidth << ", \"measurements\": [";
     }
     else
     {
-      std::cout << "# nrBeams nrDMs nrSamples integration *configuration* GFLOP/s GB/s time stdDeviation COV" << std::endl << std::endl;
+      std::cout << std::fixed << std::endl;
+      std::cout << "# copy bandwidth " << std::setprecision(3) << copyBandwidth << " GB/s" << std::endl;
+      std::cout << "# nrBeams nr" << dim0Name << " nrSamples integration *configuration* GFLOP/s GB/s %peak time stdDeviation COV median p95 min runs" << std::endl << std::endl;
     }
   }
 
-  for ( unsigned int threads = minThreads; threads <= maxThreads; )
+  // Generate the code of a configuration, safe to call from the compiler threads
+  auto generate = [&configurations, &observation, inPlace, beforeDedispersion, DMsSamples, &integration, padding](const unsigned int configuration) -> std::string
   {
-    conf.setNrThreadsD0(threads);
-    if ( DMsSamples || inPlace )
+    const Integration::integrationConf & candidate = configurations.at(configuration);
+
+    if ( inPlace && beforeDedispersion )
+    {
+      return Integration::getIntegrationBeforeDedispersionInPlaceOpenCL<BeforeDedispersionNumericType>(candidate, observation, BeforeDedispersionDataName, integration, padding);
+    }
+    else if ( inPlace && !beforeDedispersion )
     {
-      threads *= 2;
+      return Integration::getIntegrationAfterDedispersionInPlaceOpenCL<AfterDedispersionNumericType>(candidate, observation, AfterDedispersionDataName, integration, padding);
+    }
+    else if ( DMsSamples )
+    {
+      return Integration::getIntegrationDMsSamplesOpenCL<AfterDedispersionNumericType>(candidate, observation, AfterDedispersionDataName, integration, padding);
+    }
+    return Integration::getIntegrationSamplesDMsOpenCL<AfterDedispersionNumericType>(candidate, observation, AfterDedispersionDataName, integration, padding);
+  };
+  std::string kernelName;
+  // Configurations the search strategy is going to measure next, compiled ahead of time
+  std::deque< unsigned int > upcoming;
+  auto prepare = [&upcoming](const std::vector< unsigned int > & next)
+  {
+    upcoming.assign(next.begin(), next.end());
+  };
+  // If a configuration does not compile or run, the same configuration with the other integer type is not tried
+  std::set< std::vector< unsigned int > > failed;
+  auto getFailureKey = [&parameters](const unsigned int configuration)
+  {
+    std::vector< unsigned int > key = parameters.at(configuration);
+
+    // The fourth parameter is the integer type
+    key.at(3) = 0;
+    return key;
+  };
+  auto submit = [&](const unsigned int configuration)
+  {
+    if ( !compiler.isSubmitted(configuration) && (failed.count(getFailureKey(configuration)) == 0) )
+    {
+      compiler.submit(configuration, kernelName, [generate, configuration]() { return generate(configuration); }, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
+    }
+  };
+
+  // Measure the performance of a configuration, in GFLOP/s
+  auto measure = [&](const unsigned int configuration, const unsigned int iterations, unsigned int & nrRuns) -> double
+  {
+    conf = configurations.at(configuration);
+    if ( failed.count(getFailureKey(configuration)) > 0 )
+    {
+      return 0.0;
+    }
+    // Bytes read and written, in GB
+    double gflops, gbs;
+    if ( inPlace && beforeDedispersion )
+    {
+      gflops = isa::utils::giga(observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * observation.getNrSamplesPerDispersedBatch());
+      gbs = isa::utils::giga(((observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * observation.getNrSamplesPerDispersedBatch()) + (observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * (observation.getNrSamplesPerDispersedBatch() / integration))) * sizeof(BeforeDedispersionNumericType));
     }
     else
     {
-      threads++;
+      gflops = isa::utils::giga(observation.getNrSynthesizedBeams() * static_cast<uint64_t>(observation.getNrDMs(true) * observation.getNrDMs()) * observation.getNrSamplesPerBatch());
+      gbs = isa::utils::giga(((observation.getNrSynthesizedBeams() * static_cast<uint64_t>(observation.getNrDMs(true) * observation.getNrDMs()) * observation.getNrSamplesPerBatch()) + (observation.getNrSynthesizedBeams() * static_cast<uint64_t>(observation.getNrDMs(true) * observation.getNrDMs()) * (observation.getNrSamplesPerBatch() / integration))) * sizeof(AfterDedispersionNumericType));
+    }
+    Integration::kernelRunTimes runTimes;
+    cl::Kernel * kernel;
+
+    if ( reinitializeDeviceMemory )
+    {
+      initializeDevice();
+    }
+    // Generate and compile kernel, keeping the compiler threads busy with the next candidates
+    submit(configuration);
+    while ( !upcoming.empty() && (compiler.getNrPending() < 2 * compiler.getNrThreads()) )
+    {
+      submit(upcoming.front());
+      upcoming.pop_front();
+    }
+    try
+    {
+      kernel = compiler.get(configuration);
+    }
+    catch ( isa::OpenCL::OpenCLError & err )
+    {
+      std::cerr << err.what() << std::endl;
+      failed.insert(getFailureKey(configuration));
+      return 0.0;
+    }
+
+    cl::NDRange global;
+    cl::NDRange local;
+    Integration::getIntegrationNDRange(mode, conf, observation, integration, global, local);
+    kernel->setArg(0, input_d);
+    if ( !inPlace )
+    {
+      kernel->setArg(1, output_d);
     }
-    if ( conf.getNrThreadsD0() % vectorWidth != 0 )
+    try
     {
-      continue;
+      // Warm-up run
+      openCLRunTime.queues->at(clDeviceID)[0].finish();
+      profilingQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+      event.wait();
+      // Tuning runs, measurements with all the iterations continue until the coefficient of variation is below maxCOV
+      while ( (runTimes.getNrRuns() < iterations) || ((iterations == nrIterations) && (runTimes.getNrRuns() < maxNrIterations) && (runTimes.getCoefficientOfVariation() > maxCOV)) )
+      {
+        profilingQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
+        event.wait();
+        runTimes.add((event.getProfilingInfo< CL_PROFILING_COMMAND_END >() - event.getProfilingInfo< CL_PROFILING_COMMAND_START >()) * 1.0e-9);
+      }
+      nrRuns = runTimes.getNrRuns();
+    }
+    catch ( cl::Error & err )
+    {
+      std::cerr << "OpenCL error kernel execution (";
+      std::cerr << conf.print() << "): ";
+      std::cerr << std::to_string(err.err()) << "." << std::endl;
+      delete kernel;
+      if ( err.err() == -4 || err.err() == -61 )
+      {
+        throw;
+      }
+      reinitializeDeviceMemory = true;
+      failed.insert(getFailureKey(configuration));
+      return 0.0;
     }
-    for ( unsigned int itemsPerThread = 1; itemsPerThread <= maxItems; itemsPerThread++ )
+    delete kernel;
+
+    // Only measurements with all the iterations are reported
+    if ( !bestMode && iterations == nrIterations )
     {
-      conf.setNrItemsD0(itemsPerThread);
+      unsigned int nrBeams, dim0, nrSamples;
       if ( inPlace && beforeDedispersion )
       {
-        if ( conf.getNrItemsD0() + 2 >= maxItems )
-        {
-          break;
-        }
-        else if ( (conf.getNrThreadsD0() * conf.getNrItemsD0() * integration) > observation.getNrSamplesPerDispersedBatch() )
-        {
-          break;
-        }
-        else if ( (observation.getNrSamplesPerDispersedBatch() % (integration * conf.getNrItemsD0())) != 0 )
-        {
-          continue;
-        }
+        nrBeams = observation.getNrBeams();
+        dim0 = getDim0();
+        nrSamples = observation.getNrSamplesPerDispersedBatch();
       }
-      else if ( inPlace && !beforeDedispersion)
+      else
       {
-        if ( conf.getNrItemsD0() + 2 >= maxItems )
-        {
-          break;
-        }
-        else if ( (conf.getNrThreadsD0() * conf.getNrItemsD0() * integration) > observation.getNrSamplesPerBatch() )
-        {
-          break;
-        }
-        else if ( (observation.getNrSamplesPerBatch() % (integration * conf.getNrItemsD0())) != 0 )
-        {
-          continue;
-        }
+        nrBeams = observation.getNrSynthesizedBeams();
+        dim0 = getDim0();
+        nrSamples = observation.getNrSamplesPerBatch();
       }
-      else if ( DMsSamples )
+      const double peakPercentage = 100.0 * (gbs / runTimes.getMedianTime()) / copyBandwidth;
+      if ( outputFormat == "csv" )
       {
-        if ( (observation.getNrSamplesPerBatch() % (integration * conf.getNrItemsD0())) != 0 )
-        {
-          continue;
-        }
+        std::cout << nrBeams << "," << dim0 << "," << nrSamples << "," << integration << ",";
+        std::cout << conf.getSubbandDedispersion() << "," << conf.getNrThreadsD0() << "," << conf.getNrThreadsD1() << "," << conf.getNrThreadsD2() << ",";
+        std::cout << conf.getNrItemsD0() << "," << conf.getNrItemsD1() << "," << conf.getNrItemsD2() << "," << conf.getIntTypeCode() << ",";
+        std::cout << conf.getSubgroupReduction() << "," << conf.getVectorWidth() << "," << static_cast< unsigned int >(conf.getInPlaceVariant()) << "," << conf.getNrPasses() << ",";
+        std::cout << gflops / runTimes.getMedianTime() << "," << gbs / runTimes.getMedianTime() << "," << peakPercentage << "," << copyBandwidth << ",";
+        std::cout << runTimes.getAverageTime() << "," << runTimes.getStandardDeviation() << "," << runTimes.getCoefficientOfVariation() << ",";
+        std::cout << runTimes.getMedianTime() << "," << runTimes.getPercentileTime(0.95) << "," << runTimes.getMinimumTime() << "," << runTimes.getNrRuns() << std::endl;
+      }
+      else if ( outputFormat == "json" )
+      {
+        std::cout << (firstMeasurement ? "\n" : ",\n");
+        std::cout << "{\"nr_beams\": " << nrBeams << ", \"" << ((inPlace && beforeDedispersion) ? "nr_channels" : "nr_dms") << "\": " << dim0 << ", \"nr_samples\": " << nrSamples << ", \"integration\": " << integration << ", ";
+        std::cout << "\"subband_dedispersion\": " << (conf.getSubbandDedispersion() ? "true" : "false") << ", \"threads_d0\": " << conf.getNrThreadsD0() << ", \"threads_d1\": " << conf.getNrThreadsD1() << ", \"threads_d2\": " << conf.getNrThreadsD2() << ", ";
+        std::cout << "\"items_d0\": " << conf.getNrItemsD0() << ", \"items_d1\": " << conf.getNrItemsD1() << ", \"items_d2\": " << conf.getNrItemsD2() << ", \"int_type\": " << conf.getIntTypeCode() << ", ";
+        std::cout << "\"subgroup_reduction\": " << (conf.getSubgroupReduction() ? "true" : "false") << ", \"vector_width\": " << conf.getVectorWidth() << ", \"in_place_variant\": " << static_cast< unsigned int >(conf.getInPlaceVariant()) << ", \"nr_passes\": " << conf.getNrPasses() << ", ";
+        std::cout << "\"gflops\": " << gflops / runTimes.getMedianTime() << ", \"gbs\": " << gbs / runTimes.getMedianTime() << ", \"peak_percentage\": " << peakPercentage << ", \"copy_gbs\": " << copyBandwidth << ", ";
+        std::cout << "\"time\": " << runTimes.getAverageTime() << ", \"std_deviation\": " << runTimes.getStandardDeviation() << ", \"cov\": " << runTimes.getCoefficientOfVariation() << ", ";
+        std::cout << "\"median\": " << runTimes.getMedianTime() << ", \"p95\": " << runTimes.getPercentileTime(0.95) << ", \"min\": " << runTimes.getMinimumTime() << ", \"runs\": " << runTimes.getNrRuns() << "}";
+        std::cout.flush();
       }
       else
       {
-        if ( observation.getNrDMs() % (conf.getNrThreadsD0() * conf.getNrItemsD0()) != 0 )
-        {
-          continue;
-        }
+        std::cout << nrBeams << " " << dim0 << " " << nrSamples << " " << integration << " ";
+        std::cout << conf.print() << " ";
+        std::cout << std::setprecision(3);
+        std::cout << gflops / runTimes.getMedianTime() << " ";
+        std::cout << gbs / runTimes.getMedianTime() << " ";
+        std::cout << peakPercentage << " ";
+        std::cout << std::setprecision(6);
+        std::cout << runTimes.getAverageTime() << " " << runTimes.getStandardDeviation() << " ";
+        std::cout << runTimes.getCoefficientOfVariation() << " ";
+        std::cout << runTimes.getMedianTime() << " " << runTimes.getPercentileTime(0.95) << " " << runTimes.getMinimumTime() << " ";
+        std::cout << runTimes.getNrRuns() << std::endl;
       }
-      for ( unsigned int intType = 0; intType < 2; intType++ )
+      firstMeasurement = false;
+    }
+    // The median is not affected by occasional slow runs
+    return gflops / runTimes.getMedianTime();
+  };
+  // Tuned configurations in the format of readTunedIntegrationConf, one file per number of samples
+  std::map< unsigned int, std::string > confFiles;
+  for ( auto samples : samplesList )
+  {
+    for ( auto dim0 : dim0List )
+    {
+      for ( auto factor : integrations )
       {
-        conf.setIntType(intType);
-        // Generate kernel
-        double gflops, gbs;
-        if ( inPlace && beforeDedispersion )
-        {
-          gflops = isa::utils::giga(observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * observation.getNrSamplesPerDispersedBatch());
-          gbs = isa::utils::giga((observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * observation.getNrSamplesPerDispersedBatch()) + (observation.getNrBeams() * static_cast<uint64_t>(observation.getNrChannels()) * (observation.getNrSamplesPerDispersedBatch() / integration)));
-        }
-        else
+        // Kernels and candidates of the previous point belong to a different scenario; the compiler threads read the scenario, so they are stopped before it changes
+        compiler.clear();
+        upcoming.clear();
+        failed.clear();
+        integration = factor;
+        setScenario(samples, dim0);
+        configurations.clear();
+        parameters.clear();
+        bestConf = Integration::integrationConf();
+        // Samples of a row integrated by the in-place kernels
+        const unsigned int inPlaceSamples = beforeDedispersion ? observation.getNrSamplesPerDispersedBatch() : observation.getNrSamplesPerBatch();
+        for ( unsigned int threads = minThreads; threads <= maxThreads; )
         {
-          gflops = isa::utils::giga(observation.getNrSynthesizedBeams() * static_cast<uint64_t>(observation.getNrDMs(true) * observation.getNrDMs()) * observation.getNrSamplesPerBatch());
-          gbs = isa::utils::giga((observation.getNrSynthesizedBeams() * static_cast<uint64_t>(observation.getNrDMs(true) * observation.getNrDMs()) * observation.getNrSamplesPerBatch()) + (observation.getNrSynthesizedBeams() * static_cast<uint64_t>(observation.getNrDMs(true) * observation.getNrDMs()) * (observation.getNrSamplesPerBatch() / integration)));
-        }
-        isa::utils::Timer timer;
-        cl::Kernel * kernel;
-
-        std::string * code;
-        if ( inPlace && beforeDedispersion )
-        {
-          code = Integration::getIntegrationBeforeDedispersionInPlaceOpenCL<BeforeDedispersionNumericType>(conf, observation, BeforeDedispersionDataName, integration, padding);
-        }
-        else if ( inPlace && !beforeDedispersion )
-        {
-          code = Integration::getIntegrationAfterDedispersionInPlaceOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
-        }
-        else if ( DMsSamples )
-        {
-          code = Integration::getIntegrationDMsSamplesOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
-        }
-        else
-        {
-          code = Integration::getIntegrationSamplesDMsOpenCL<AfterDedispersionNumericType>(conf, observation, AfterDedispersionDataName, integration, padding);
-        }
-        if ( reinitializeDeviceMemory )
-        {
-          isa::OpenCL::initializeOpenCL(clPlatformID, 1, openCLRunTime);
-          try
+          conf.setNrThreadsD0(threads);
+          if ( DMsSamples || inPlace )
+          {
+            threads *= 2;
+          }
+          else
           {
-            if ( beforeDedispersion )
+            threads++;
+          }
+          for ( unsigned int itemsPerThread = 1; itemsPerThread <= maxItems; itemsPerThread++ )
+          {
+            conf.setNrItemsD0(itemsPerThread);
+            if ( inPlace )
+            {
+              if ( conf.getNrItemsD0() + 2 >= maxItems )
+              {
+                break;
+              }
+              else if ( (conf.getNrItemsD0() * integration) > inPlaceSamples )
+              {
+                break;
+              }
+              else if ( (inPlaceSamples % (integration * conf.getNrItemsD0())) != 0 )
+              {
+                continue;
+              }
+            }
+            else if ( DMsSamples )
             {
-              initializeDeviceMemory(*(openCLRunTime.context), &(openCLRunTime.queues->at(clDeviceID)[0]), &input_d, input_before.size(), &output_d, output.size(), true);
+              if ( (observation.getNrSamplesPerBatch() % (integration * conf.getNrItemsD0())) != 0 )
+              {
+                continue;
+              }
             }
             else
             {
-              initializeDeviceMemory(*(openCLRunTime.context), &(openCLRunTime.queues->at(clDeviceID)[0]), &input_d, input_after.size(), &output_d, output.size());
+              if ( observation.getNrDMs() % (conf.getNrThreadsD0() * conf.getNrItemsD0()) != 0 )
+              {
+                continue;
+              }
+            }
+            // The in-place kernels have a local memory, a registers and a multi-pass variant, the other kernels only the first
+            for ( unsigned int variant = 0; variant <= (inPlace ? static_cast< unsigned int >(Integration::integrationInPlaceVariant::MultiPass) : 0u); variant++ )
+            {
+              conf.setInPlaceVariant(static_cast< Integration::integrationInPlaceVariant >(variant));
+              // Only the registers variant reads less than nrThreadsD0 * nrItemsD0 windows at a time
+              if ( inPlace && (conf.getInPlaceVariant() != Integration::integrationInPlaceVariant::Registers) && ((conf.getNrThreadsD0() * conf.getNrItemsD0() * integration) > inPlaceSamples) )
+              {
+                continue;
+              }
+              for ( unsigned int passes = 1; passes <= integration; passes *= 2 )
+              {
+                conf.setNrPasses(passes);
+                // The multi-pass variant splits windows in at least two slices of the same size
+                if ( (conf.getInPlaceVariant() == Integration::integrationInPlaceVariant::MultiPass) != (passes > 1) )
+                {
+                  continue;
+                }
+                else if ( (integration % passes) != 0 )
+                {
+                  break;
+                }
+                for ( unsigned int width = 1; width <= maxVectorWidth; width *= 2 )
+                {
+                  conf.setVectorWidth(width);
+                  // Widths the layout does not allow would generate the same kernel as the scalar one
+                  if ( width > 1 && Integration::getIntegrationVectorWidth(mode, conf, observation, integration) != width )
+                  {
+                    continue;
+                  }
+                  for ( unsigned int intType = 0; intType < 2; intType++ )
+                  {
+                    conf.setIntType(intType);
+                    // Only the DMs-samples kernel has a sub-group reduction
+                    for ( unsigned int subgroup = 0; subgroup < (DMsSamples ? 2u : 1u); subgroup++ )
+                    {
+                      conf.setSubgroupReduction(subgroup != 0);
+                      configurations.push_back(conf);
+                      parameters.push_back(std::vector< unsigned int >{conf.getNrThreadsD0(), conf.getNrItemsD0(), width, intType, subgroup, variant, passes});
+                    }
+                  }
+                }
+              }
             }
           }
-          catch ( cl::Error & err )
-          {
-            std::cerr << "Error in memory allocation: ";
-            std::cerr << std::to_string(err.err()) << "." << std::endl;
-            return -1;
-          }
-          reinitializeDeviceMemory = false;
-        }
-        try
-        {
-          if ( inPlace )
-          {
-            kernel = isa::OpenCL::compile("integration" + std::to_string(integration), *code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
-          }
-          else if ( DMsSamples )
-          {
-            kernel = isa::OpenCL::compile("integrationDMsSamples" + std::to_string(integration), *code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
-          }
-          else
-          {
-            kernel = isa::OpenCL::compile("integrationSamplesDMs" + std::to_string(integration), *code, "-cl-mad-enable -Werror", *(openCLRunTime.context), openCLRunTime.devices->at(clDeviceID));
-          }
-        }
-        catch ( isa::OpenCL::OpenCLError & err )
-        {
-          std::cerr << err.what() << std::endl;
-          delete code;
-          break;
         }
-        delete code;
 
-        cl::NDRange global;
-        cl::NDRange local;
-        if ( inPlace && beforeDedispersion )
-        {
-          global = cl::NDRange(conf.getNrThreadsD0(), observation.getNrChannels(), observation.getNrBeams());
-          local = cl::NDRange(conf.getNrThreadsD0(), 1, 1);
-        }
-        else if ( inPlace && !beforeDedispersion )
-        {
-          global = cl::NDRange(conf.getNrThreadsD0(), observation.getNrDMs(true) * observation.getNrDMs(), observation.getNrSynthesizedBeams());
-          local = cl::NDRange(conf.getNrThreadsD0(), 1, 1);
-        }
-        else if ( DMsSamples )
-        {
-          global = cl::NDRange(conf.getNrThreadsD0() * ((observation.getNrSamplesPerBatch() / integration) / conf.getNrItemsD0()), observation.getNrDMs(true) * observation.getNrDMs(), observation.getNrSynthesizedBeams());
-          local = cl::NDRange(conf.getNrThreadsD0(), 1, 1);
-        }
-        else
-        {
-          global = cl::NDRange((observation.getNrDMs(true) * observation.getNrDMs())/ conf.getNrItemsD0(), observation.getNrSamplesPerBatch() / integration, observation.getNrSynthesizedBeams());
-          local = cl::NDRange(conf.getNrThreadsD0(), 1, 1);
-        }
-        kernel->setArg(0, input_d);
-        if ( !inPlace )
-        {
-          kernel->setArg(1, output_d);
-        }
+        kernelName = Integration::getIntegrationKernelName(mode, integration);
+        unsigned int best = configurations.size();
         try
         {
-          // Warm-up run
-          openCLRunTime.queues->at(clDeviceID)[0].finish();
-          openCLRunTime.queues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
-          event.wait();
-          // Tuning runs
-          for ( unsigned int iteration = 0; iteration < nrIterations; iteration++ )
+          best = Integration::searchConfigurations(strategy, parameters, nrIterations, budget, measure, seed, prepare);
+          if ( best < configurations.size() )
           {
-            timer.start();
-            openCLRunTime.queues->at(clDeviceID)[0].enqueueNDRangeKernel(*kernel, cl::NullRange, global, local, 0, &event);
-            event.wait();
-            timer.stop();
+            bestConf = configurations.at(best);
           }
         }
         catch ( cl::Error & err )
         {
-          std::cerr << "OpenCL error kernel execution (";
-          std::cerr << conf.print() << "): ";
-          std::cerr << std::to_string(err.err()) << "." << std::endl;
-          delete kernel;
-          if ( err.err() == -4 || err.err() == -61 )
-          {
-            return -1;
-          }
-          reinitializeDeviceMemory = true;
-          break;
+          // Fatal OpenCL errors are reported by measure
+          return -1;
         }
-        delete kernel;
 
-        if ( (gflops / timer.getAverageTime()) > bestGFLOPs )
+        if ( bestMode )
         {
-          bestGFLOPs = gflops / timer.getAverageTime();
-          bestConf = conf;
+          std::cout << getDim0() << " " << integration << " " << bestConf.print() << std::endl;
         }
-        if ( !bestMode )
+        if ( gridMode )
         {
-          if ( inPlace && beforeDedispersion )
+          if ( best < configurations.size() )
           {
-            std::cout << observation.getNrBeams() << " " << observation.getNrChannels() << " " << observation.getNrSamplesPerDispersedBatch() << " " << integration << " ";
+            confFiles[samples] += deviceName + " " + std::to_string(getDim0()) + " " + std::to_string(integration) + " " + bestConf.print() + "\n";
           }
           else
           {
-            std::cout << observation.getNrSynthesizedBeams() << " " << observation.getNrDMs(true) * observation.getNrDMs() << " " << observation.getNrSamplesPerBatch() << " " << integration << " ";
+            std::cerr << "No valid configuration for " << dim0 << " " << samples << " " << integration << "." << std::endl;
           }
-          std::cout << conf.print() << " ";
-          std::cout << std::setprecision(3);
-          std::cout << gflops / timer.getAverageTime() << " ";
-          std::cout << gbs / timer.getAverageTime() << " ";
-          std::cout << std::setprecision(6);
-          std::cout << timer.getAverageTime() << " " << timer.getStandardDeviation() << " ";
-          std::cout << timer.getCoefficientOfVariation() <<  std::endl;
         }
       }
     }
   }
-
-  if ( bestMode )
+  if ( !bestMode )
   {
-    if ( inPlace && beforeDedispersion )
+    if ( outputFormat == "json" )
     {
-      std::cout << observation.getNrSamplesPerBatch() << " " << integration << " " << bestConf.print() << std::endl;
+      std::cout << "\n]}" << std::endl;
     }
-    else
+    else if ( outputFormat == "text" )
     {
-      std::cout << observation.getNrDMs(true) * observation.getNrDMs() << " " << integration << " " << bestConf.print() << std::endl;
+      std::cout << std::endl;
     }
   }
-  else
+
+  for ( const auto & file : confFiles )
   {
-    std::cout << std::endl;
+    std::string filename = confFilename;
+    if ( samplesList.size() > 1 )
+    {
+      filename += "." + std::to_string(file.first);
+    }
+    std::ofstream output(filename);
+    output << file.second;
+    output.close();
+    if ( !output )
+    {
+      std::cerr << "Impossible to write " << filename << "." << std::endl;
+      return 1;
+    }
   }
 
   return 0;
 }
 
-void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue, cl::Buffer * input_d, const unsigned int input_size, cl::Buffer * output_d, const unsigned int output_size, bool before) {
+void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue, cl::Buffer * input_d, const uint64_t input_size, cl::Buffer * output_d, const uint64_t output_size, bool before) {
   try
   {
     if ( output_size > 0 )
@@ -446,3 +795,56 @@ void initializeDeviceMemory(cl::Context & clContext, cl::CommandQueue * clQueue,
   }
 }
 
+
+std::vector< unsigned int > getList(const std::string & list)
+{
+  std::vector< unsigned int > values;
+  std::string::size_type begin = 0;
+
+  while ( begin < list.size() )
+  {
+    std::string::size_type end = list.find(',', begin);
+
+    if ( end == std::string::npos )
+    {
+      end = list.size();
+    }
+    values.push_back(isa::utils::castToType< std::string, unsigned int >(list.substr(begin, end - begin)));
+    begin = end + 1;
+  }
+  return values;
+}
+
+double measureCopyBandwidth(Integration::kernelCache & kernels, cl::Context & clContext, cl::Device & clDevice, cl::CommandQueue & clQueue, const uint64_t size, const unsigned int nrIterations)
+{
+  // At least 64 MB are copied, so that caches do not affect the measurement
+  const uint64_t nrElements = (std::max(size, static_cast< uint64_t >(64 * 1024 * 1024)) + 15) / 16;
+  cl::Buffer input_d(clContext, CL_MEM_READ_WRITE, nrElements * 16, 0, 0);
+  cl::Buffer output_d(clContext, CL_MEM_READ_WRITE, nrElements * 16, 0, 0);
+  cl::Kernel * kernel = kernels.compile("copy", Integration::getCopyOpenCL(), "-Werror", clContext, clDevice);
+  Integration::kernelRunTimes runTimes;
+  cl::Event event;
+
+  kernel->setArg(0, input_d);
+  kernel->setArg(1, output_d);
+  try
+  {
+    // Warm-up run
+    clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, cl::NDRange(nrElements), cl::NullRange, 0, &event);
+    event.wait();
+    for ( unsigned int iteration = 0; iteration < std::max(nrIterations, 1u); iteration++ )
+    {
+      clQueue.enqueueNDRangeKernel(*kernel, cl::NullRange, cl::NDRange(nrElements), cl::NullRange, 0, &event);
+      event.wait();
+      runTimes.add((event.getProfilingInfo< CL_PROFILING_COMMAND_END >() - event.getProfilingInfo< CL_PROFILING_COMMAND_START >()) * 1.0e-9);
+    }
+  }
+  catch ( cl::Error & err )
+  {
+    delete kernel;
+    throw;
+  }
+  delete kernel;
+  // As in STREAM, bytes are counted once when read and once when written, and the fastest run is used
+  return isa::utils::giga(2 * nrElements * 16) / runTimes.getMinimumTime();
+}